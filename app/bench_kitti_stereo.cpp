@@ -0,0 +1,161 @@
+#include <gflags/gflags.h>
+#include <sys/resource.h>
+#include <chrono>
+#include <fstream>
+#include "myslam/profiler.h"
+#include "myslam/synthetic_dataset.h"
+#include "myslam/trajectory.h"
+#include "myslam/visual_odometry.h"
+
+DEFINE_string(config_file, "../config/default.yaml", "config file path");
+DEFINE_int32(num_frames, 0, "num of frames preloaded and processed, 0 for the whole sequence");
+DEFINE_string(ground_truth, "", "KITTI poses/XX.txt of the sequence, empty to skip ATE and RPE "
+                             "(or to use the exact poses of dataset.type: synthetic)");
+DEFINE_string(report, "", "JSON file of the results, empty to not write");
+DEFINE_string(profile_output, "", "prefix of the profiler results (.json, .csv, .trace.json)");
+DEFINE_double(max_ate, 0, "fail if the ATE in m is larger, 0 to not check");
+DEFINE_double(max_rpe, 0, "fail if the translational RPE in m is larger, 0 to not check");
+DEFINE_double(min_fps, 0, "fail if the throughput in frames/s is lower, 0 to not check");
+DEFINE_double(max_frame_p99_ms, 0, "fail if the p99 latency of a frame in ms is larger, 0 to not check");
+DEFINE_double(realtime_speed, 0, "replay the frames at this rate of their time stamps, 0 for realtime.speed");
+DEFINE_double(deadline_ms, 0, "deadline of a frame in real-time mode, 0 for the period between the frames");
+DEFINE_double(max_deadline_miss_rate, 0, "fail if more frames are dropped or late in real-time mode, 0 to not check");
+DEFINE_bool(verbose, false, "keep the INFO log of every frame");
+
+// peak resident set size of the process in MB
+static double PeakRssMb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0; // KB on Linux
+}
+
+/**
+ * run the frontend and backend over preloaded frames of a KITTI or synthetic sequence without the viewer,
+ * report the throughput, the latency of each stage, the peak memory and the trajectory error,
+ * and exit with 1 if one of the thresholds is not met
+ */
+int main(int argc, char** argv) {
+    google::ParseCommandLineFlags(&argc, &argv, true);
+    if (!FLAGS_verbose) FLAGS_minloglevel = google::WARNING;
+
+    myslam::VisualOdometry::Ptr vo(new myslam::VisualOdometry(FLAGS_config_file));
+    vo->SetHeadless(true);
+    if (!vo->Init()) return 2;
+    if (FLAGS_realtime_speed > 0) vo->SetRealtime(FLAGS_realtime_speed, FLAGS_deadline_ms);
+    myslam::Profiler &profiler = myslam::Profiler::Instance();
+    profiler.SetEnabled(true);
+
+    // decode before timing, the images stay in memory
+    std::vector<myslam::Frame::Ptr> frames;
+    while (FLAGS_num_frames <= 0 || static_cast<int>(frames.size()) < FLAGS_num_frames) {
+        myslam::Frame::Ptr frame = vo->GetDataset()->NextFrame();
+        if (frame == nullptr) break;
+        frames.push_back(frame);
+    }
+    if (frames.empty()) {
+        std::cerr << "no frames in the dataset" << std::endl;
+        vo->Shutdown(); // joins the threads of the backend
+        return 2;
+    }
+    profiler.Clear();
+
+    // in real-time mode, a dropped frame keeps the pose of the last processed one
+    myslam::RealtimeScheduler::Ptr scheduler = vo->GetRealtimeScheduler();
+    std::vector<bool> dropped(frames.size(), false);
+    auto t1 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < frames.size(); ++i) {
+        unsigned long num_dropped = scheduler ? scheduler->Stats().dropped : 0;
+        vo->AddFrame(frames[i]);
+        dropped[i] = scheduler && scheduler->Stats().dropped > num_dropped;
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    vo->Shutdown();
+
+    const double seconds = std::chrono::duration<double>(t2 - t1).count();
+    const double fps = frames.size() / seconds;
+    const double peak_rss = PeakRssMb();
+    std::cout << "frames " << frames.size() << ", " << seconds << " s, " << fps << " frames/s, peak RSS "
+              << peak_rss << " MB" << std::endl;
+
+    double miss_rate = 0;
+    if (scheduler) {
+        const myslam::RealtimeStats &stats = scheduler->Stats();
+        miss_rate = double(stats.dropped + stats.deadline_misses) / stats.frames;
+        std::cout << "real-time: dropped " << stats.dropped << ", degraded " << stats.degraded
+                  << ", deadline misses " << stats.deadline_misses << ", max latency " << stats.max_latency_ms
+                  << " ms" << std::endl;
+    }
+
+    profiler.Collect();
+    std::vector<myslam::Profiler::Summary> summaries = profiler.Summaries();
+    double frame_p99 = 0;
+    for (auto &s : summaries) {
+        std::cout << "  " << s.name << (s.is_span ? " ms" : "") << ": count " << s.count << ", p50 " << s.p50
+                  << ", p95 " << s.p95 << ", p99 " << s.p99 << ", max " << s.max << std::endl;
+        if (s.name == "frontend.add_frame") frame_p99 = s.p99;
+    }
+    if (!FLAGS_profile_output.empty()) {
+        profiler.WriteJson(FLAGS_profile_output + ".json");
+        profiler.WriteCsv(FLAGS_profile_output + ".csv");
+        profiler.WriteChromeTrace(FLAGS_profile_output + ".trace.json");
+    }
+
+    // trajectory of all the frames, keyframes as refined by the backend
+    myslam::TrajectoryError error;
+    bool has_ground_truth = false;
+    auto synthetic = std::dynamic_pointer_cast<myslam::SyntheticDataset>(vo->GetDataset());
+    if (!FLAGS_ground_truth.empty() || synthetic) {
+        myslam::Trajectory ground_truth, estimate;
+        if (!FLAGS_ground_truth.empty()) {
+            if (!myslam::LoadKittiPoses(FLAGS_ground_truth, ground_truth)) return 2;
+        } else {
+            ground_truth = synthetic->GroundTruth();
+        }
+        for (size_t i = 0; i < frames.size(); ++i) {
+            if (dropped[i] && !estimate.empty()) {
+                estimate.push_back(estimate.back());
+            } else {
+                estimate.push_back(frames[i]->Pose().inverse());
+            }
+        }
+        error = myslam::EvaluateTrajectory(estimate, ground_truth);
+        has_ground_truth = true;
+        std::cout << "ATE " << error.ate << " m, RPE " << error.rpe_translation << " m "
+                  << error.rpe_rotation << " deg over " << error.num_poses << " poses" << std::endl;
+    }
+
+    if (!FLAGS_report.empty()) {
+        std::ofstream report(FLAGS_report);
+        report << "{\n  \"frames\": " << frames.size() << ",\n  \"seconds\": " << seconds
+               << ",\n  \"fps\": " << fps << ",\n  \"peak_rss_mb\": " << peak_rss
+               << ",\n  \"frame_p99_ms\": " << frame_p99;
+        if (scheduler) {
+            const myslam::RealtimeStats &stats = scheduler->Stats();
+            report << ",\n  \"dropped\": " << stats.dropped << ",\n  \"degraded\": " << stats.degraded
+                   << ",\n  \"deadline_misses\": " << stats.deadline_misses
+                   << ",\n  \"max_latency_ms\": " << stats.max_latency_ms;
+        }
+        if (has_ground_truth) {
+            report << ",\n  \"ate\": " << error.ate << ",\n  \"rpe_translation\": " << error.rpe_translation
+                   << ",\n  \"rpe_rotation\": " << error.rpe_rotation;
+        }
+        report << "\n}\n";
+    }
+
+    // regression thresholds
+    bool failed = false;
+    auto check = [&](bool ok, const std::string &what) {
+        if (!ok) {
+            std::cerr << "regression: " << what << std::endl;
+            failed = true;
+        }
+    };
+    if (FLAGS_min_fps > 0) check(fps >= FLAGS_min_fps, "fps below --min_fps");
+    if (FLAGS_max_frame_p99_ms > 0) check(frame_p99 <= FLAGS_max_frame_p99_ms, "frame p99 above --max_frame_p99_ms");
+    if (FLAGS_max_deadline_miss_rate > 0) {
+        check(miss_rate <= FLAGS_max_deadline_miss_rate, "deadline misses above --max_deadline_miss_rate");
+    }
+    if (FLAGS_max_ate > 0) check(has_ground_truth && error.ate <= FLAGS_max_ate, "ATE above --max_ate");
+    if (FLAGS_max_rpe > 0) check(has_ground_truth && error.rpe_translation <= FLAGS_max_rpe, "RPE above --max_rpe");
+    return failed ? 1 : 0;
+}
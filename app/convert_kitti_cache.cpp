@@ -0,0 +1,30 @@
+#include <gflags/gflags.h>
+#include "myslam/cached_dataset.h"
+
+DEFINE_string(config_file, "../config/default.yaml", "config file path");
+DEFINE_string(output, "", "cache file to write, dataset.cache_file of the config by default");
+
+// decode a KITTI sequence once into a cache file for CachedDataset
+int main(int argc, char** argv) {
+    google::ParseCommandLineFlags(&argc, &argv, true);
+
+    cv::FileStorage file(FLAGS_config_file, cv::FileStorage::READ);
+    std::string dataset_dir = file["dataset_dir"];
+    std::string output = FLAGS_output;
+    if (output.empty()) output = std::string(file["dataset.cache_file"]);
+    if (output.empty()) {
+        std::cerr << "no output file, set --output or dataset.cache_file" << std::endl;
+        return 1;
+    }
+
+    myslam::KittiDataset dataset(dataset_dir);
+    dataset.SetPrefetchDepth(4);
+    if (!dataset.Init()) return 1;
+
+    int num_frames = myslam::CachedDataset::Write(output, dataset);
+    if (num_frames < 0) return 1;
+
+    std::cout << "converted " << num_frames << " frames of " << dataset_dir
+              << " into " << output << std::endl;
+    return 0;
+}
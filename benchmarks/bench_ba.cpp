@@ -0,0 +1,24 @@
+#include <benchmark/benchmark.h>
+#include "bench_problems.h"
+
+template <typename Solver>
+static void BM_BASolver(benchmark::State &state) {
+    const auto &problems = Problems();
+    Solver solver;
+    double cost = 0;
+    for (auto _ : state) {
+        cost = 0;
+        for (auto &p : problems) {
+            state.PauseTiming();
+            myslam::BAProblem problem = p;
+            state.ResumeTiming();
+            cost += solver.Solve(problem, 10);
+        }
+    }
+    state.counters["cost"] = cost;
+    state.SetItemsProcessed(state.iterations() * problems.size());
+}
+BENCHMARK_TEMPLATE(BM_BASolver, myslam::G2OBASolver)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BASolver, myslam::SchurBASolver)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
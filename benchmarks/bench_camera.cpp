@@ -0,0 +1,50 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include "myslam/common_include.h"
+#include "myslam/camera.h"
+
+// right camera of the half resolution KITTI rig, points in front of it
+struct CameraPoints {
+    myslam::Camera camera;
+    SE3 pose;
+    std::vector<Vec3> points;
+    std::vector<Vec2> pixels;
+
+    explicit CameraPoints(int n)
+        : camera(358.5, 358.5, 303.4, 92.4, 0.537, SE3(SO3(), Vec3(-0.537, 0, 0))),
+          pose(SO3::exp(Vec3(0, 0.05, 0)), Vec3(0.1, 0, -2)) {
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<double> uniform(-1, 1);
+        for (int i = 0; i < n; ++i) {
+            Vec3 pw(uniform(rng) * 10, uniform(rng) * 3, 25 + uniform(rng) * 20);
+            points.push_back(pw);
+            pixels.push_back(camera.world2pixel(pw, pose));
+        }
+    }
+};
+
+// projection of the landmarks, as in TrackFeatures and FindFeaturesInRight
+static void BM_CameraWorld2Pixel(benchmark::State &state) {
+    CameraPoints data(state.range(0));
+    for (auto _ : state) {
+        for (auto &p : data.points) {
+            benchmark::DoNotOptimize(data.camera.world2pixel(p, data.pose));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CameraWorld2Pixel)->RangeMultiplier(4)->Range(16, 16384);
+
+// normalized coordinates of the features, as in the triangulation of new landmarks
+static void BM_CameraPixel2Camera(benchmark::State &state) {
+    CameraPoints data(state.range(0));
+    for (auto _ : state) {
+        for (auto &px : data.pixels) {
+            benchmark::DoNotOptimize(data.camera.pixel2camera(px));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CameraPixel2Camera)->RangeMultiplier(4)->Range(16, 16384);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <opencv2/opencv.hpp>
+#include "myslam/common_include.h"
+#include "myslam/corner.h"
+#include "myslam/detector.h"
+
+// half resolution KITTI frame, MYSLAM_BENCH_IMAGE or blurred noise of the same size
+static const cv::Mat &Frame() {
+    static cv::Mat img;
+    if (img.empty()) {
+        const char *path = std::getenv("MYSLAM_BENCH_IMAGE");
+        if (path) {
+            cv::Mat full = cv::imread(path, cv::IMREAD_GRAYSCALE);
+            if (!full.empty()) cv::resize(full, img, cv::Size(), 0.5, 0.5, cv::INTER_NEAREST);
+        }
+        if (img.empty()) {
+            img.create(188, 621, CV_8UC1);
+            cv::RNG rng(0);
+            rng.fill(img, cv::RNG::UNIFORM, 0, 256);
+            cv::GaussianBlur(img, img, cv::Size(5, 5), 1.5);
+        }
+    }
+    return img;
+}
+
+static void BM_CornerMinEigenVal(benchmark::State &state) {
+    const cv::Mat &img = Frame();
+    cv::Mat score;
+    for (auto _ : state) {
+        cv::cornerMinEigenVal(img, score, 3, 3);
+        benchmark::DoNotOptimize(score.data);
+    }
+}
+BENCHMARK(BM_CornerMinEigenVal);
+
+static void BM_ShiTomasiScore(benchmark::State &state) {
+    const cv::Mat &img = Frame();
+    cv::Mat score(img.size(), CV_32FC1);
+    for (auto _ : state) {
+        myslam::ShiTomasiScore(img.ptr<uchar>(), img.cols, img.rows, img.step,
+                               score.ptr<float>(), score.step1());
+        benchmark::DoNotOptimize(score.data);
+    }
+}
+BENCHMARK(BM_ShiTomasiScore);
+
+// detection of 150 features in an empty frame, as in the frontend
+static void BM_GFTTDetector(benchmark::State &state) {
+    const cv::Mat &img = Frame();
+    auto gftt = cv::GFTTDetector::create(150, 0.01, 20);
+    std::vector<cv::KeyPoint> keypoints;
+    for (auto _ : state) {
+        gftt->detect(img, keypoints);
+        benchmark::DoNotOptimize(keypoints.data());
+    }
+}
+BENCHMARK(BM_GFTTDetector);
+
+template <typename DetectorT>
+static void BM_Detector(benchmark::State &state) {
+    const cv::Mat &img = Frame();
+    DetectorT detector(150);
+    std::vector<cv::Point2f> existing;
+    std::vector<cv::KeyPoint> keypoints;
+    for (auto _ : state) {
+        detector.Detect(img, existing, keypoints);
+        benchmark::DoNotOptimize(keypoints.data());
+    }
+}
+BENCHMARK_TEMPLATE(BM_Detector, myslam::GridDetector);
+BENCHMARK_TEMPLATE(BM_Detector, myslam::ShiTomasiDetector);
+
+BENCHMARK_MAIN();
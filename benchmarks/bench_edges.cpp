@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+#include "bench_problems.h"
+#include "myslam/g2o_types.h"
+
+// n edges of the observations of the first problem, cycling through them, with vertices at its estimates
+struct Edges {
+    std::vector<std::unique_ptr<myslam::VertexPose>> poses;
+    std::vector<std::unique_ptr<myslam::VertexXYZ>> points;
+    std::vector<std::unique_ptr<myslam::EdgeProjection>> edges;
+    std::vector<std::unique_ptr<myslam::EdgeProjectionPoseOnly>> pose_only_edges;
+
+    explicit Edges(int n) {
+        const myslam::BAProblem &problem = Problems().front();
+        for (auto &pose : problem.poses) {
+            poses.emplace_back(new myslam::VertexPose);
+            poses.back()->setEstimate(pose);
+        }
+        for (auto &point : problem.points) {
+            points.emplace_back(new myslam::VertexXYZ);
+            points.back()->setEstimate(point);
+        }
+        for (int i = 0; i < n; ++i) {
+            int k = i % problem.NumObservations();
+            auto pose = poses[problem.obs_pose[k]].get();
+            edges.emplace_back(new myslam::EdgeProjection(problem.K, problem.cam_ext[problem.obs_camera[k]]));
+            edges.back()->setVertex(0, pose);
+            edges.back()->setVertex(1, points[problem.obs_point[k]].get());
+            edges.back()->setMeasurement(problem.obs_pixel[k]);
+            // the frontend uses the left camera
+            pose_only_edges.emplace_back(new myslam::EdgeProjectionPoseOnly(problem.points[problem.obs_point[k]],
+                                                                            problem.K));
+            pose_only_edges.back()->setVertex(0, pose);
+            pose_only_edges.back()->setMeasurement(problem.obs_pixel[k]);
+        }
+    }
+};
+
+// residuals and jacobians of the backend edges, as in one g2o iteration
+static void BM_EdgeProjection(benchmark::State &state) {
+    Edges data(state.range(0));
+    for (auto _ : state) {
+        for (auto &edge : data.edges) {
+            edge->computeError();
+            edge->linearizeOplus();
+            benchmark::DoNotOptimize(edge->jacobianOplusXj().data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetLabel(std::getenv("MYSLAM_BA_PROBLEMS") ? "recorded" : "synthetic");
+}
+BENCHMARK(BM_EdgeProjection)->RangeMultiplier(4)->Range(16, 16384);
+
+// residuals and jacobians of the pose estimation of the frontend
+static void BM_EdgeProjectionPoseOnly(benchmark::State &state) {
+    Edges data(state.range(0));
+    for (auto _ : state) {
+        for (auto &edge : data.pose_only_edges) {
+            edge->computeError();
+            edge->linearizeOplus();
+            benchmark::DoNotOptimize(edge->jacobianOplusXi().data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetLabel(std::getenv("MYSLAM_BA_PROBLEMS") ? "recorded" : "synthetic");
+}
+BENCHMARK(BM_EdgeProjectionPoseOnly)->RangeMultiplier(4)->Range(16, 16384);
+
+BENCHMARK_MAIN();
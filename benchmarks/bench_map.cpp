@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+#include "myslam/common_include.h"
+#include "myslam/feature.h"
+#include "myslam/map.h"
+#include "myslam/mappoint.h"
+
+// keyframe at z with n features in the left and right image, each observing a new landmark
+static myslam::Frame::Ptr MakeKeyframe(myslam::Map &map, int n, double z) {
+    auto frame = myslam::Frame::CreateFrame();
+    frame->SetKeyFrame();
+    frame->SetPose(SE3(SO3(), Vec3(0, 0, -z)));
+    for (int i = 0; i < n; ++i) {
+        auto mp = myslam::MapPoint::CreateNewMappoint();
+        mp->SetPos(Vec3(i % 20 - 10, i / 20 - 4, z + 20));
+        for (int camera = 0; camera < 2; ++camera) {
+            auto feat = myslam::Feature::Create(frame, cv::KeyPoint(cv::Point2f(i, camera), 7));
+            feat->is_on_left_image_ = camera == 0;
+            feat->map_point_ = mp;
+            mp->AddObservation(feat);
+            (camera == 0 ? frame->features_left_ : frame->features_right_).push_back(feat);
+        }
+        map.InsertMapPoint(mp);
+    }
+    return frame;
+}
+
+// insertion of a keyframe into a full window, RemoveOldKeyframe and CleanMap of the keyframe leaving it
+static void BM_MapRemoveOldKeyframe(benchmark::State &state) {
+    const int n = state.range(0);
+    myslam::Map map;
+    double z = 0;
+    for (int i = 0; i < 7; ++i, z += 1) map.InsertKeyFrame(MakeKeyframe(map, n, z));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto frame = MakeKeyframe(map, n, z);
+        z += 1;
+        state.ResumeTiming();
+        map.InsertKeyFrame(frame);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_MapRemoveOldKeyframe)->RangeMultiplier(2)->Range(32, 512);
+
+// publication of the active landmarks after a change, and a read by the backend or the viewer
+static void BM_MapActiveSnapshot(benchmark::State &state) {
+    const int n = state.range(0);
+    myslam::Map map;
+    double z = 0;
+    for (int i = 0; i < 7; ++i, z += 1) map.InsertKeyFrame(MakeKeyframe(map, n, z));
+    auto mp = myslam::MapPoint::CreateNewMappoint();
+    for (auto _ : state) {
+        map.InsertMapPoint(mp);
+        benchmark::DoNotOptimize(map.GetActiveMapPoints());
+    }
+    state.SetItemsProcessed(state.iterations() * 7 * n);
+}
+BENCHMARK(BM_MapActiveSnapshot)->RangeMultiplier(2)->Range(32, 512);
+
+int main(int argc, char **argv) {
+    FLAGS_minloglevel = google::WARNING; // RemoveOldKeyframe logs each keyframe
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#ifndef BENCH_PROBLEMS_H
+#define BENCH_PROBLEMS_H
+
+#include <cstdlib>
+#include <random>
+#include <opencv2/core/utility.hpp>
+#include "myslam/common_include.h"
+#include "myslam/ba_solver.h"
+
+// window of 7 stereo keyframes moving forward, each point seen by 3 to 7 of them
+inline myslam::BAProblem SyntheticProblem(int num_points) {
+    myslam::BAProblem problem;
+    problem.K << 350, 0, 300,
+                 0, 350, 100,
+                 0, 0, 1;
+    problem.cam_ext[1] = SE3(SO3(), Vec3(-0.537, 0, 0));
+
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> uniform(-1, 1);
+    std::normal_distribution<double> noise(0, 0.5);
+    std::vector<SE3, Eigen::aligned_allocator<SE3>> poses_true;
+    for (int i = 0; i < 7; ++i) {
+        SE3 pose_true(SO3::exp(Vec3(0, 0.01 * i, 0)), Vec3(0, 0, -1.0 * i));
+        Vec6 delta;
+        delta << uniform(rng) * 0.05, uniform(rng) * 0.05, uniform(rng) * 0.05,
+                 uniform(rng) * 0.005, uniform(rng) * 0.005, uniform(rng) * 0.005;
+        poses_true.push_back(pose_true);
+        problem.AddPose(SE3::exp(delta) * pose_true);
+    }
+    for (int j = 0; j < num_points; ++j) {
+        Vec3 pw(uniform(rng) * 10, uniform(rng) * 3, 25 + uniform(rng) * 10);
+        int point = problem.AddPoint(pw + 0.1 * Vec3(uniform(rng), uniform(rng), uniform(rng)));
+        int first = j % 5, last = std::min(7, first + 3 + j % 3);
+        for (int i = first; i < last; ++i) {
+            for (int camera = 0; camera < 2; ++camera) {
+                Vec3 pc = problem.cam_ext[camera] * (poses_true[i] * pw);
+                problem.AddObservation(i, point, camera,
+                                       Vec2(problem.K(0, 0) * pc[0] / pc[2] + problem.K(0, 2) + noise(rng),
+                                            problem.K(1, 1) * pc[1] / pc[2] + problem.K(1, 2) + noise(rng)));
+            }
+        }
+    }
+    problem.prior_poses.push_back(0);
+    problem.prior_linearization.push_back(poses_true[0]);
+    problem.prior_J = 1e3 * MatXX::Identity(6, 6);
+    problem.prior_r0 = VecX::Zero(6);
+    return problem;
+}
+
+// problems recorded by backend.record_dir in the directory MYSLAM_BA_PROBLEMS, or a synthetic one
+inline const std::vector<myslam::BAProblem> &Problems() {
+    static std::vector<myslam::BAProblem> problems;
+    if (problems.empty()) {
+        const char *dir = std::getenv("MYSLAM_BA_PROBLEMS");
+        if (dir) {
+            std::vector<cv::String> files;
+            cv::glob(std::string(dir) + "/ba_*.bin", files);
+            for (auto &file : files) {
+                myslam::BAProblem problem;
+                if (problem.Load(file)) problems.push_back(problem);
+            }
+        }
+        if (problems.empty()) problems.push_back(SyntheticProblem(2000));
+    }
+    return problems;
+}
+
+#endif // BENCH_PROBLEMS_H
@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include "myslam/common_include.h"
+#include "myslam/algorithm.h"
+
+// KITTI-like stereo rig at half resolution, points in normalized plane with pixel noise
+struct StereoPoints {
+    SE3 left, right;
+    std::vector<Vec3> pts_left, pts_right;
+
+    explicit StereoPoints(int n)
+        : left(SO3(), Vec3::Zero()), right(SO3(), Vec3(-0.537, 0, 0)) {
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<double> uniform(-1, 1);
+        std::normal_distribution<double> noise(0, 0.5 / 350);
+        for (int i = 0; i < n; ++i) {
+            Vec3 pw(uniform(rng) * 10, uniform(rng) * 3, 25 + uniform(rng) * 20);
+            Vec3 pl = left * pw, pr = right * pw;
+            pl /= pl[2];
+            pr /= pr[2];
+            pl[0] += noise(rng); pl[1] += noise(rng);
+            pr[0] += noise(rng); pr[1] += noise(rng);
+            pts_left.push_back(pl);
+            pts_right.push_back(pr);
+        }
+    }
+};
+
+// triangulation() of each point, as in the frontend before batching
+static void BM_TriangulationSvd(benchmark::State &state) {
+    StereoPoints data(state.range(0));
+    std::vector<SE3> poses{data.left, data.right};
+    for (auto _ : state) {
+        for (size_t i = 0; i < data.pts_left.size(); ++i) {
+            Vec3 pt_world;
+            std::vector<Vec3> points{data.pts_left[i], data.pts_right[i]};
+            benchmark::DoNotOptimize(myslam::triangulation(poses, points, pt_world));
+            benchmark::DoNotOptimize(pt_world);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TriangulationSvd)->RangeMultiplier(4)->Range(16, 16384);
+
+static void BM_TriangulationBatch(benchmark::State &state) {
+    StereoPoints data(state.range(0));
+    myslam::TriangulationBatch batch;
+    for (size_t i = 0; i < data.pts_left.size(); ++i) {
+        batch.Add(data.pts_left[i], data.pts_right[i]);
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(myslam::triangulation(data.left, data.right, batch));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TriangulationBatch)->RangeMultiplier(4)->Range(16, 16384);
+
+BENCHMARK_MAIN();
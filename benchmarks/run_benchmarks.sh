@@ -0,0 +1,18 @@
+#!/bin/sh
+# run the benchmarks, results in <results_dir>/<commit>/<benchmark>.json
+# compare two commits with tools/compare.py of google benchmark:
+#   compare.py benchmarks <results_dir>/<commit1>/bench_x.json <results_dir>/<commit2>/bench_x.json
+# usage: run_benchmarks.sh <results_dir> <benchmark>...
+# run from the directory of the executables, extra arguments from $MYSLAM_BENCHMARK_ARGS
+set -e
+
+results_dir=$1
+shift
+commit=$(git -C "$(dirname "$0")" describe --always --dirty 2>/dev/null || echo unknown)
+out="$results_dir/$commit"
+mkdir -p "$out"
+
+for bench in "$@"; do
+    echo "$bench -> $out/$bench.json"
+    ./"$bench" --benchmark_out="$out/$bench.json" --benchmark_out_format=json $MYSLAM_BENCHMARK_ARGS
+done
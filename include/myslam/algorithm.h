@@ -33,6 +33,43 @@ namespace myslam {
         return false;
     }
 
+    /**
+     * structure of arrays for batched two-view triangulation,
+     * point i is observed at (x0[i], y0[i]) in view 0 and (x1[i], y1[i]) in view 1,
+     * all in normalized plane
+     */
+    struct TriangulationBatch {
+        // input
+        std::vector<double> x0, y0, x1, y1;
+        // output, 3D points relative to the reference coordinate
+        std::vector<double> px, py, pz;
+        std::vector<uchar> success; // 1 if the triangulation is good
+
+        void Clear() {
+            x0.clear(); y0.clear(); x1.clear(); y1.clear();
+        }
+
+        void Add(const Vec3 &pt0, const Vec3 &pt1) {
+            x0.push_back(pt0[0]); y0.push_back(pt0[1]);
+            x1.push_back(pt1[0]); y1.push_back(pt1[1]);
+        }
+
+        size_t Size() const { return x0.size(); }
+
+        Vec3 Point(size_t i) const { return Vec3(px[i], py[i], pz[i]); }
+    };
+
+    /**
+     * batched linear triangulation of two views,
+     * the normal equation of each point is solved in closed form (3x3 adjugate),
+     * the loop over points is vectorized and large batches are split across threads
+     * @param pose0         pose of view 0
+     * @param pose1         pose of view 1
+     * @param batch         points in normalized plane, and the triangulated points
+     * @return num of good triangulated points
+     */
+    int triangulation(const SE3 &pose0, const SE3 &pose1, TriangulationBatch &batch);
+
     // converters
     inline Vec2 toVec2(const cv::Point2f p) { return Vec2(p.x, p.y); }
 
@@ -0,0 +1,183 @@
+#pragma once
+
+#ifndef BA_SOLVER_H
+#define BA_SOLVER_H
+
+#include "common_include.h"
+
+namespace myslam {
+
+    /**
+     * @details bundle adjustment problem of the backend window, independent of the solver
+     * @details same model as EdgeProjection: e = z - pi(K * ext * T * p_w), Huber kernel,
+     * @details plus the optional dense prior of EdgeMarginalPrior on some of the poses
+     */
+    struct BAProblem {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+
+        Mat33 K = Mat33::Identity();
+        SE3 cam_ext[2]; // extrinsics of the left and right camera
+        double huber_delta = 5.991;
+
+        std::vector<SE3, Eigen::aligned_allocator<SE3>> poses; // Tcw of the keyframes
+        std::vector<Vec3> points; // landmarks, world
+        std::vector<uchar> point_fixed;
+
+        // observations, structure of arrays
+        std::vector<int> obs_pose, obs_point;
+        std::vector<uchar> obs_camera; // 0 left, 1 right
+        std::vector<Vec2> obs_pixel;
+
+        // dense prior, |prior_r0 + prior_J * dx|^2, empty if there is no prior
+        std::vector<int> prior_poses;
+        std::vector<SE3, Eigen::aligned_allocator<SE3>> prior_linearization;
+        MatXX prior_J;
+        VecX prior_r0;
+
+        int AddPose(const SE3 &pose) {
+            poses.push_back(pose);
+            return poses.size() - 1;
+        }
+
+        int AddPoint(const Vec3 &point, bool fixed = false) {
+            points.push_back(point);
+            point_fixed.push_back(fixed);
+            return points.size() - 1;
+        }
+
+        void AddObservation(int pose, int point, int camera, const Vec2 &pixel) {
+            obs_pose.push_back(pose);
+            obs_point.push_back(point);
+            obs_camera.push_back(camera);
+            obs_pixel.push_back(pixel);
+        }
+
+        size_t NumObservations() const { return obs_pose.size(); }
+
+        // robust chi2 of the observations and chi2 of the prior
+        double Cost() const;
+
+        // binary file, for recording the problems of a run and replaying them in benchmarks
+        bool Save(const std::string &path) const;
+        bool Load(const std::string &path);
+    };
+
+    /**
+     * @details interface of the bundle adjustment solvers of the backend
+     */
+    class BASolver {
+    public:
+        typedef std::shared_ptr<BASolver> Ptr;
+
+        virtual ~BASolver() {}
+
+        /**
+         * @details Levenberg-Marquardt iterations with the damping scheme of g2o
+         * @param problem poses and points are the initial values and the results
+         * @param iterations maximum num of iterations
+         * @return cost at the result
+         */
+        virtual double Solve(BAProblem &problem, int iterations) = 0;
+    };
+
+    /**
+     * @details g2o::BlockSolver_6_3 with CSparse, a new graph of the problem in each call
+     */
+    class G2OBASolver : public BASolver {
+    public:
+        double Solve(BAProblem &problem, int iterations) override;
+    };
+
+    /**
+     * @details Schur complement solver for 6-DoF poses and 3-D points.
+     * @details Residuals and jacobians are evaluated in parallel on structure of arrays buffers,
+     * @details in batches of the observations of one keyframe and camera, so the loop over a batch
+     * @details is vectorized; the pose blocks of the batches are summed in batch order.
+     * @details The observations are also grouped by point so the 3x3 point blocks are contiguous.
+     * @details Points are eliminated in parallel into per-chunk copies of the dense reduced camera system,
+     * @details which are summed in chunk order, and the system is solved with a fixed-size Cholesky
+     * @details for windows of up to 8 poses. Results do not depend on the num of threads.
+     * @details The buffers are kept between calls
+     */
+    class SchurBASolver : public BASolver {
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+
+        double Solve(BAProblem &problem, int iterations) override;
+
+    private:
+        typedef Eigen::Matrix<double, 2, 6> Mat26;
+        typedef Eigen::Matrix<double, 2, 3> Mat23;
+        typedef Eigen::Matrix<double, 6, 3> Mat63;
+
+        typedef std::vector<SE3, Eigen::aligned_allocator<SE3>> Poses;
+
+        // max num of observations of a batch
+        static const int kBatchSize = 256;
+
+        // group the observations by keyframe and by point
+        void Setup(const BAProblem &problem);
+
+        /**
+         * @details residuals, and optionally jacobians and the pose blocks of Hpp_ and bp_
+         * @details (Hpp_ and bp_ are added to), at poses and points
+         * @return cost, with the prior
+         */
+        double Evaluate(const BAProblem &problem, const Poses &poses,
+                        const std::vector<Vec3> &points, bool jacobians);
+
+        /**
+         * @details residuals, jacobians and the blocks of the normal equations H dx = b
+         * @return cost
+         */
+        double Linearize(const BAProblem &problem);
+
+        /**
+         * @details reduced camera system of the damped normal equations, and its solution
+         * @return false if the system can not be solved
+         */
+        bool SolveDamped(const BAProblem &problem, double lambda);
+
+        int num_poses_ = 0, num_points_ = 0;
+        std::vector<int> order_; // observations sorted by point
+        std::vector<int> point_begin_; // observations of point i are order_[point_begin_[i], point_begin_[i + 1])
+        std::vector<int> point_slot_; // slot of order_[k]
+
+        // observations of one keyframe and camera, slots [begin, end)
+        struct Batch {
+            int pose, camera;
+            int begin, end;
+        };
+        std::vector<Batch> batches_;
+        std::vector<int> slot_order_; // observation in each slot, sorted by keyframe and camera
+
+        // per slot, structure of arrays
+        std::vector<double> x_, y_, z_; // landmarks, world
+        std::vector<double> u_, v_; // measurements, pixel
+        std::vector<double> eu_, ev_, rho_, w_; // residuals, Huber cost and weight
+        std::vector<double> jac_[18]; // d e / d pose, row u then v, then d e / d point, row u then v
+
+        // per batch
+        std::vector<Mat66, Eigen::aligned_allocator<Mat66>> batch_H_;
+        std::vector<Vec6, Eigen::aligned_allocator<Vec6>> batch_b_;
+        std::vector<double> batch_cost_;
+
+        // per observation, in the order of order_
+        std::vector<Mat63, Eigen::aligned_allocator<Mat63>> Hpl_;
+
+        // per point
+        std::vector<Mat33> Hll_, Hll_inv_;
+        std::vector<Vec3> bl_;
+
+        // poses, dense
+        MatXX Hpp_;
+        VecX bp_;
+
+        // solution
+        VecX dx_poses_;
+        std::vector<Vec3> dx_points_;
+    };
+
+} // namespace myslam
+
+#endif // BA_SOLVER_H
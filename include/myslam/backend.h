@@ -1,19 +1,32 @@
 #ifndef BACKEND_H
 #define BACKEND_H
 
+#include <chrono>
+
+#include "myslam/ba_solver.h"
 #include "myslam/common_include.h"
 #include "myslam/frame.h"
+#include "myslam/g2o_types.h"
 #include "myslam/map.h"
 
 namespace myslam {
     class Map;
+    struct Feature;
+
+    enum class BackendSolverType {
+        G2O,
+        SCHUR
+    };
 
     /**
      * @details Backend
      * @details it has independent optimized thread,
      * @details it will start when the map updates
      * @details the updating of map is activated by frondend.cpp
-     * @details backend_->UpdateMap()
+     * @details backend_->UpdateMap(), requests are numbered by generation
+     * @details the g2o graph of the window is kept between updates, only the vertices and edges
+     * @details of the inserted and removed keyframes and landmarks are added or removed,
+     * @details the other vertices start from the solution of the last update
      */
     class Backend {
     public:
@@ -30,21 +43,143 @@ namespace myslam {
 
         void SetMap(std::shared_ptr<Map> map) { map_ = map; }
 
-        void UpdateMap();
+        /**
+         * @details request an optimization of the current window.
+         * @details Requests made while the backend is busy are coalesced into one optimization
+         * @details of the latest window, which completes all of them
+         * @return generation of the request
+         */
+        unsigned long UpdateMap();
+
+        /**
+         * @details wait until the optimization of a generation returned by UpdateMap has completed
+         * @return false on timeout, or if the backend stopped before
+         */
+        bool WaitForGeneration(unsigned long generation, std::chrono::milliseconds timeout);
 
         void Stop();
 
+        // counters of the requests
+        struct QueueStats {
+            unsigned long requests = 0; // UpdateMap calls
+            unsigned long optimizations = 0;
+            unsigned long coalesced = 0; // requests completed by the optimization of a later one
+            unsigned long dropped = 0; // requests pending at Stop
+            unsigned long max_depth = 0; // max num of requests not completed
+        };
+
+        QueueStats GetQueueStats() {
+            std::unique_lock<std::mutex> lock(data_mutex_);
+            return queue_stats_;
+        }
+
+        /**
+         * @details marginalize the keyframes leaving the window, with the landmarks observed only by them,
+         * @details into a dense prior on the landmarks they share with the window instead of dropping them.
+         * @details The shared landmarks stay free, and are minimized out of the prior when they leave the window.
+         * @details The marginalized landmarks stay fixed if they are observed again.
+         * @details The g2o solver takes the landmark blocks of the prior as block diagonal in its Schur complement,
+         * @details the SCHUR solver keeps the poses of the prior only, its landmarks are minimized out
+         */
+        void SetMarginalization(bool marginalization) { marginalization_ = marginalization; }
+
+        // dims of the marginalization prior after the last optimization, 0 if there is none
+        int PriorDimension() {
+            std::unique_lock<std::mutex> lock(data_mutex_);
+            return prior_dimension_;
+        }
+
+        /**
+         * @details solver of the window, the graph is kept in g2o either way,
+         * @details SCHUR exports it to a BAProblem for the hand-written SchurBASolver
+         */
+        void SetSolver(BackendSolverType type) { solver_type_ = type; }
+
+        // save the problem of each update to record_dir, for bench_ba; empty to disable
+        void SetRecordDir(const std::string &record_dir) { record_dir_ = record_dir; }
+
     private:
         void BackendLoop();
 
         // optimize the keyframe and landmarks
-        void Optimize(Map::KeyframesType& keyframes, Map::LandmarksType& landmarks);
+        void Optimize(const Map::KeyframesType& keyframes, const Map::LandmarksType& landmarks);
+
+        /**
+         * @details add the vertices and edges which are new in the window, remove those which left it
+         * @return true if the structure of the graph changed
+         */
+        bool UpdateGraph(const Map::KeyframesType& keyframes, const Map::LandmarksType& landmarks);
+
+        /**
+         * @details Schur complement of the keyframes and the landmarks observed only by them,
+         * @details their edges and the old prior are replaced by a new prior on the landmarks they share
+         * @details with the window and the vertices of the old prior which stay
+         * @param keyframe_ids keyframes leaving the window, still in the graph
+         */
+        void Marginalize(const std::vector<unsigned long>& keyframe_ids);
+
+        // minimize the landmarks not used by the update of generation out of the prior, before they are removed
+        void RemovePriorLandmarks(unsigned long generation);
+
+        // the graph as a BAProblem, in the order of graph_poses_ and graph_landmarks_
+        void ExportProblem(BAProblem& problem) const;
+
+        // the solution of ExportProblem back to the vertices
+        void ImportProblem(const BAProblem& problem);
+
+        // vertices and edges of the window graph, generation is the last update using them
+        struct GraphPose {
+            VertexPose *vertex;
+            unsigned long generation;
+        };
+        struct GraphLandmark {
+            VertexXYZ *vertex;
+            unsigned long generation;
+        };
+        struct GraphEdge {
+            EdgeProjection *edge;
+            std::weak_ptr<Feature> feature; // detects a new feature at the address of a removed one
+            int camera; // 0 left, 1 right
+            unsigned long generation;
+        };
+
+        // the graph, owns the vertices and edges
+        g2o::SparseOptimizer optimizer_;
+        std::unordered_map<unsigned long, GraphPose> graph_poses_; // keyframe id
+        std::unordered_map<unsigned long, GraphLandmark> graph_landmarks_; // landmark id
+        std::unordered_map<Feature *, GraphEdge> graph_edges_; // observation
+        unsigned long graph_generation_ = 0;
+        int next_edge_id_ = 0;
+        bool structure_changed_ = false; // since the last initializeOptimization
+
+        // solver
+        BackendSolverType solver_type_ = BackendSolverType::G2O;
+        SchurBASolver schur_solver_;
+        std::string record_dir_;
+
+        // marginalization
+        bool marginalization_ = false;
+        EdgeMarginalPrior *prior_ = nullptr; // owned by optimizer_
+        std::unordered_set<unsigned long> retired_landmarks_; // marginalized, fixed from then on
+        std::unordered_map<Feature *, std::weak_ptr<Feature>> absorbed_edges_; // in the prior
+        int prior_dimension_ = 0; // of the last optimization, guarded by data_mutex_
+
+        // timing of the updates in ms
+        struct Timing {
+            int updates = 0, marginalizations = 0;
+            double graph = 0, marginalization = 0, optimization = 0;
+        } timing_;
 
         std::shared_ptr<Map> map_;
         std::thread backend_thread_;
-        std::mutex data_mutex_;
+        std::mutex data_mutex_; // guards the generations and queue_stats_
 
-        std::condition_variable map_update_;
+        std::condition_variable map_update_; // request or stop
+        std::condition_variable generation_done_; // optimization completed or stop
+        unsigned long requested_generation_ = 0, completed_generation_ = 0;
+        bool request_pending_ = false; // requested and not taken by the loop yet
+        std::chrono::steady_clock::time_point pending_since_; // time of the oldest request not taken
+        QueueStats queue_stats_;
         std::atomic<bool> backend_running_;
 
         Camera::Ptr cam_left_ = nullptr, cam_right_ = nullptr;
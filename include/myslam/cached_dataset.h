@@ -0,0 +1,63 @@
+#ifndef CACHED_DATASET_H
+#define CACHED_DATASET_H
+
+#include <cstdint>
+#include "common_include.h"
+#include "kitti_dataset.h"
+
+namespace myslam {
+    /**
+     * @details dataset backed by a pre-decoded cache file
+     * @details the cache stores the downscaled 8-bit stereo pairs of a sequence
+     * @details in one contiguous file with an index header, it is memory mapped
+     * @details and the images of the frames point directly into the mapping
+     * @details camera parameters are still read from calib.txt in dataset_path
+     *
+     * @details layout: CacheHeader | images (64 bytes aligned) | CacheEntry[num_frames]
+     */
+    class CachedDataset : public KittiDataset {
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+        typedef std::shared_ptr<CachedDataset> Ptr;
+
+        CachedDataset(const std::string &dataset_path, const std::string &cache_file);
+
+        // read calibration and map the cache file
+        bool Init() override;
+
+        // zero-copy, the images of the frame refer to the mapped file
+        Frame::Ptr NextFrame() override;
+
+        size_t NumFrames() const { return num_frames_; }
+
+        /**
+         * @details convert all frames of source into a cache file
+         * @param cache_file output file
+         * @param source initialized dataset, read until NextFrame() returns nullptr
+         * @return num of frames written, -1 if failed
+         */
+        static int Write(const std::string &cache_file, Dataset &source);
+
+    private:
+        struct CacheHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t num_frames;
+            uint64_t index_offset; // offset of the CacheEntry array
+        };
+
+        struct CacheEntry {
+            uint64_t left_offset, right_offset;
+            uint32_t width, height; // same for left and right, rows are continuous
+            double time_stamp;
+        };
+
+        std::string cache_file_;
+        std::shared_ptr<const void> mapping_; // unmapped when the last frame is released
+        const uint8_t *data_ = nullptr;
+        const CacheEntry *entries_ = nullptr;
+        size_t num_frames_ = 0;
+    };
+} // namespace myslam
+
+#endif // CACHED_DATASET_H
@@ -6,6 +6,7 @@
 // std
 #include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <iostream>
 #include <list>
 #include <map>
@@ -16,6 +17,7 @@
 #include <thread>
 #include <typeinfo>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 // define the commonly included file to avoid a long include list
@@ -0,0 +1,38 @@
+#pragma once
+
+#ifndef CORNER_H
+#define CORNER_H
+
+#include "common_include.h"
+
+namespace myslam {
+
+    /**
+     * @details Shi-Tomasi corner response of an 8-bit grayscale image
+     * @details fused 3x3 Sobel gradient, 3x3 box filtered structure tensor and minimal eigenvalue,
+     * @details in one pass over the rows with AVX2/SSE2, the same scale as cv::cornerMinEigenVal(img, score, 3, 3).
+     * @details The 2 pixels at the image border have no full support and are set to 0
+     * @param img pixels, row i starts at img + i * img_stride
+     * @param width
+     * @param height
+     * @param img_stride in bytes
+     * @param score output, row i starts at score + i * score_stride
+     * @param score_stride in floats
+     */
+    void ShiTomasiScore(const uchar *img, int width, int height, int img_stride,
+                        float *score, int score_stride);
+
+    /**
+     * @details 3x3 non-maximum suppression of a score image
+     * @details a pixel of the rect [x0, x1) x [y0, y1) is kept if its score is larger than min_score
+     * @details and not smaller than its 8 neighbours, the rect must not touch the image border
+     * @param maxima positions of the kept pixels, appended in row-major order
+     * @return num of kept pixels
+     */
+    int NonMaxSuppression3x3(const float *score, int score_stride,
+                             int x0, int y0, int x1, int y1, float min_score,
+                             std::vector<cv::Point> &maxima);
+
+} // namespace myslam
+
+#endif // CORNER_H
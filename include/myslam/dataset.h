@@ -7,8 +7,14 @@
 
 namespace myslam {
     /**
-     * @details read data from dataset.
+     * @details source of stereo frames, a dataset on disk, a video or a live producer.
      * @details After Initialization, it can get camera and the next frame.
+     * @details A source implements Open() and ReadStereoPair(). With a prefetch depth > 0,
+     * @details a loader thread reads the stereo pairs ahead of NextFrame() into a bounded
+     * @details queue, so the tracker does not block on I/O. A live source drops the oldest
+     * @details pair of a full queue instead of waiting for the tracker.
+     * @details The loader thread calls ReadStereoPair(), so a concrete source calls
+     * @details StopLoader() in its destructor, before its members are destroyed.
      */
     class Dataset {
     public:
@@ -16,22 +22,83 @@ namespace myslam {
         typedef std::shared_ptr<Dataset> Ptr;
         Dataset(const std::string& dataset_path);
 
-        // initialization
-        bool Init();
+        virtual ~Dataset();
 
-        // Create and return the next frame containing the stereo images
-        Frame::Ptr NextFrame();
+        // open the source, the loader thread is started here
+        virtual bool Init();
+
+        /**
+         * @details Create and return the next frame containing the stereo images
+         * @details with prefetching, it only pops the queue
+         * @details and waits only if the loader falls behind
+         * @return nullptr at the end of the sequence
+         */
+        virtual Frame::Ptr NextFrame();
+
+        // num of stereo pairs read ahead, 0 to read in NextFrame(), set before Init()
+        void SetPrefetchDepth(int depth) { prefetch_depth_ = depth; }
+
+        // drop the oldest pair when the queue is full, instead of blocking the source; set before Init()
+        void SetLive(bool live) { live_ = live; }
+        bool IsLive() const { return live_; }
+
+        // num of stereo pairs dropped by a live source
+        unsigned long NumDropped();
 
         // get camera by id
         Camera::Ptr GetCamera(int camera_id) const {
             return cameras_.at(camera_id);
         }
 
-    private:
+    protected:
+        // rectified stereo images of a time stamp
+        struct StereoPair {
+            bool valid = false; // false at the end of the sequence
+            double time_stamp = 0; // s
+            cv::Mat left, right;
+        };
+
+        // open the source and set the cameras, called by Init()
+        virtual bool Open() = 0;
+
+        /**
+         * @details read the stereo pair at index, indices are read in order from 0
+         * @details called by the loader thread with prefetching
+         * @return false at the end of the sequence
+         */
+        virtual bool ReadStereoPair(int index, StereoPair &pair) = 0;
+
+        // left camera at the origin, right camera at the baseline along x, as for KITTI
+        void SetStereoCameras(double fx, double fy, double cx, double cy, double baseline);
+
+        // stop and join the loader thread
+        void StopLoader();
+
+        // true once StopLoader() is called, for a ReadStereoPair() which waits on its source
+        bool Stopping();
+
         std::string dataset_path_;
         int current_image_index_ = 0;
 
         std::vector<Camera::Ptr> cameras_;
+
+        int prefetch_depth_ = 0;
+        bool live_ = false;
+
+    private:
+        // loop of the loader thread, fill the queue
+        void LoaderLoop();
+
+        // prefetching
+        std::vector<StereoPair> ring_;
+        size_t ring_head_ = 0, ring_count_ = 0;
+        unsigned long dropped_ = 0;
+        std::thread loader_thread_;
+        std::mutex loader_mutex_;
+        std::condition_variable pair_loaded_;
+        std::condition_variable slot_freed_;
+        bool loader_running_ = false;
+        bool stopping_ = false; // StopLoader() is called, until the next Init()
     };
 } // namespace myslam
 
@@ -0,0 +1,111 @@
+#pragma once
+
+#ifndef DETECTOR_H
+#define DETECTOR_H
+
+#include <opencv2/features2d.hpp>
+#include "common_include.h"
+
+namespace myslam {
+
+    /**
+     * @details interface of the feature detectors of the frontend
+     */
+    class Detector {
+    public:
+        typedef std::shared_ptr<Detector> Ptr;
+
+        virtual ~Detector() {}
+
+        /**
+         * @details detect new features in img, away from the existing features
+         * @param img 8-bit grayscale image
+         * @param existing positions of the features already in the image
+         * @param keypoints new features
+         * @return num of new features
+         */
+        virtual int Detect(const cv::Mat &img, const std::vector<cv::Point2f> &existing,
+                           std::vector<cv::KeyPoint> &keypoints) = 0;
+    };
+
+    /**
+     * @details cv::GFTTDetector over the whole image,
+     * @details the existing features are masked out by rectangles of min_distance
+     */
+    class GfttDetector : public Detector {
+    public:
+        GfttDetector(int num_features, double quality_level = 0.01, int min_distance = 20);
+
+        int Detect(const cv::Mat &img, const std::vector<cv::Point2f> &existing,
+                   std::vector<cv::KeyPoint> &keypoints) override;
+
+    private:
+        cv::Ptr<cv::GFTTDetector> gftt_; // feature detector in opencv
+        int min_distance_;
+    };
+
+    /**
+     * @details Shi-Tomasi corners in a grid of cells
+     * @details each cell has a quota of num_features / num_cells features, cells filled
+     * @details by the existing features are skipped, the other cells are scored in parallel.
+     * @details The spacing between features is checked on an occupancy bitmap
+     * @details of min_distance / 2 blocks instead of a drawn mask
+     */
+    class GridDetector : public Detector {
+    public:
+        GridDetector(int num_features, int cell_size = 40,
+                     double quality_level = 0.01, int min_distance = 20);
+
+        int Detect(const cv::Mat &img, const std::vector<cv::Point2f> &existing,
+                   std::vector<cv::KeyPoint> &keypoints) override;
+
+    protected:
+        /**
+         * @details corner response of the pixels of img, same size as img
+         * @details by default the minimal eigenvalue of cv::cornerMinEigenVal
+         */
+        virtual void ComputeScore(const cv::Mat &img, cv::Mat &score);
+
+    private:
+        // local maximum of the corner response in a cell
+        struct Corner {
+            float score;
+            cv::Point2f pt;
+        };
+
+        // true if the bitmap block of pt is occupied
+        bool IsOccupied(const cv::Point2f &pt) const;
+
+        // occupy the blocks within min_distance_ / 2 of pt
+        void Occupy(const cv::Point2f &pt);
+
+        int num_features_;
+        int cell_size_;
+        double quality_level_;
+        int min_distance_;
+
+        // buffers, reused between images
+        int grid_cols_ = 0, grid_rows_ = 0;
+        int bitmap_cols_ = 0, bitmap_rows_ = 0, block_size_ = 1;
+        std::vector<uchar> occupancy_; // bitmap of blocks
+        std::vector<int> cell_count_; // num of features in each cell
+        std::vector<std::vector<Corner>> cell_corners_;
+        std::vector<float> cell_max_score_;
+    };
+
+    /**
+     * @details GridDetector with the in-tree Shi-Tomasi kernel (corner.h) instead of cv::cornerMinEigenVal,
+     * @details for 8-bit grayscale images
+     */
+    class ShiTomasiDetector : public GridDetector {
+    public:
+        ShiTomasiDetector(int num_features, int cell_size = 40,
+                          double quality_level = 0.01, int min_distance = 20);
+
+    protected:
+        void ComputeScore(const cv::Mat &img, cv::Mat &score) override;
+    };
+
+} // namespace myslam
+
+#endif // DETECTOR_H
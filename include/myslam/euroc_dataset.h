@@ -0,0 +1,40 @@
+#ifndef EUROC_DATASET_H
+#define EUROC_DATASET_H
+
+#include "common_include.h"
+#include "dataset.h"
+
+namespace myslam {
+    /**
+     * @details sequence in the EuRoC MAV folder layout, mav0/cam0 and mav0/cam1 with
+     * @details data.csv (time stamp in ns, file name), data/ and sensor.yaml.
+     * @details The pairs are undistorted and rectified with the intrinsics, the distortion
+     * @details and the extrinsics T_BS of sensor.yaml. Only time stamps of both cameras are read.
+     */
+    class EurocDataset : public Dataset {
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+        typedef std::shared_ptr<EurocDataset> Ptr;
+
+        EurocDataset(const std::string &dataset_path);
+
+        ~EurocDataset();
+
+    protected:
+        // read sensor.yaml and data.csv of both cameras, compute the rectification
+        bool Open() override;
+
+        bool ReadStereoPair(int index, StereoPair &pair) override;
+
+    private:
+        struct Entry {
+            double time_stamp; // s
+            std::string left, right;
+        };
+
+        std::vector<Entry> entries_;
+        cv::Mat map_x_[2], map_y_[2]; // rectification of left and right
+    };
+} // namespace myslam
+
+#endif // EUROC_DATASET_H
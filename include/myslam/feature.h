@@ -23,6 +23,7 @@ public:
     std::weak_ptr<Frame> frame_; // the frame which contains this feature
     cv::KeyPoint position_; // 2D position on the image
     std::weak_ptr<MapPoint> map_point_; // corresponding map point
+    size_t observation_index_ = 0; // index in the observations of map_point_, guarded by its data_mutex_
 
     bool is_outlier_ = false;
     bool is_on_left_image_ = true;
@@ -32,6 +33,9 @@ public:
 
     Feature(std::shared_ptr<Frame> frame, const cv::KeyPoint &kp)
         : frame_(frame), position_(kp) {}
+
+    // factory function, the feature and its control block are allocated in the arena of the frame
+    static Feature::Ptr Create(std::shared_ptr<Frame> frame, const cv::KeyPoint &kp);
 };
 } // namespace myslam
 
@@ -5,11 +5,13 @@
 
 #include "camera.h"
 #include "common_include.h"
+#include "seqlock.h"
 
 namespace myslam {
 // forward declare
 struct MapPoint;
 struct Feature;
+class FrameArena;
 
 /**
  * each frame has ID
@@ -23,17 +25,20 @@ public:
     unsigned long id_ = 0;
     unsigned long keyframe_id_ = 0;
     bool is_keyframe_ = false;
-    double time_stamp_;
-    SE3 pose_; // Tcw
-    std::mutex pose_mutex_; // pose data lock
+    double time_stamp_ = 0;
+    SeqLocked<7> pose_; // Tcw, quaternion (x, y, z, w) and translation
     cv::Mat left_img_, right_img_; // stereo images
+    // keeps the memory of the images alive if cv::Mat does not own it, e.g. a mapped cache file
+    std::shared_ptr<const void> image_storage_;
     // extract features in left image
     std::vector<std::shared_ptr<Feature>> features_left_;
     // corresponding features in right image, set to nullptr if no corresponding
     std::vector<std::shared_ptr<Feature>> features_right_;
+    // memory of the features, released with the frame and the last of its features
+    std::shared_ptr<FrameArena> arena_;
 
 public:
-    Frame() {}
+    Frame() { SetPose(SE3()); }
 
     /**
      * constructor
@@ -47,12 +52,14 @@ public:
             const cv::Mat &left, const cv::Mat &right);
 
     /**
-     * set and get pose, Tcw, thread safe
+     * set and get pose, Tcw, thread safe without a mutex,
+     * a reader never sees a pose which is partially written
      * @return
      */
-    SE3 Pose() {
-        std::unique_lock<std::mutex> lck(pose_mutex_);
-        return pose_;
+    SE3 Pose() const {
+        double v[7];
+        pose_.Load(v);
+        return SE3(Eigen::Quaterniond(v[3], v[0], v[1], v[2]), Vec3(v[4], v[5], v[6]));
     }
 
     /**
@@ -61,10 +68,29 @@ public:
      * but got by frame.Pose(), e.g., current_frame_->Pose()
      */
     void SetPose(const SE3 &pose) {
-        std::unique_lock<std::mutex> lck(pose_mutex_);
-        pose_ = pose;
+        const Eigen::Quaterniond q = pose.unit_quaternion();
+        const Vec3 t = pose.translation();
+        const double v[7] = {q.x(), q.y(), q.z(), q.w(), t[0], t[1], t[2]};
+        pose_.Store(v);
     }
 
+    /**
+     * image pyramids for LK flow, built on first use and cached, thread safe
+     * the left pyramid has derivatives, as it is the previous image of the flow
+     * to the next frame and to the right image
+     * @param win_size window size of LK flow
+     * @param max_level 0-based maximal pyramid level
+     * @return the pyramid, can be passed to cv::calcOpticalFlowPyrLK
+     */
+    std::vector<cv::Mat> LeftPyramid(const cv::Size &win_size, int max_level);
+    std::vector<cv::Mat> RightPyramid(const cv::Size &win_size, int max_level);
+
+    /**
+     * release the cached pyramids,
+     * when the frame is neither the last frame nor an active keyframe
+     */
+    void ReleasePyramids();
+
     /**
      * set keyframe and id
      * keyframes_.find(frame->keyframe_id_) == keyframes_.end() in map.cpp
@@ -77,6 +103,15 @@ public:
      */
     static std::shared_ptr<Frame> CreateFrame(); // Static functions in a class/struct
 
+private:
+    // build pyramid of img if it is not cached with the same parameters
+    std::vector<cv::Mat> CachedPyramid(const cv::Mat &img, std::vector<cv::Mat> &pyramid,
+            const cv::Size &win_size, int max_level, bool with_derivatives);
+
+    std::mutex pyramid_mutex_; // pyramid data lock
+    std::vector<cv::Mat> left_pyramid_, right_pyramid_;
+    cv::Size pyramid_win_size_;
+    int pyramid_max_level_ = -1;
 };
 
 } // namespace myslam
@@ -4,9 +4,14 @@
 #define FRONTEND_H
 
 #include <opencv2/features2d.hpp>
+#include "algorithm.h"
 #include "common_include.h"
+#include "detector.h"
 #include "frame.h"
+#include "klt.h"
 #include "map.h"
+#include "pose_solver.h"
+#include "stereo_matcher.h"
 
 namespace myslam {
     class Backend;
@@ -15,6 +20,19 @@ namespace myslam {
     // three status in the frontend
     enum class FrontendStatus { INITING, TRACKING_GOOD, TRACKING_BAD, LOST };
 
+    // solver of the pose estimation, g2o or the dedicated PoseSolver
+    enum class PoseSolverType { G2O, DIRECT };
+
+    // feature detector, GFTT over the whole image, GFTT in a grid of cells,
+    // or the grid with the in-tree Shi-Tomasi kernel
+    enum class DetectorType { GFTT, GRID, SHI_TOMASI };
+
+    // optical flow of the tracking and the right image, cv::calcOpticalFlowPyrLK or KltTracker
+    enum class OpticalFlowType { OPENCV, KLT };
+
+    // features in the right image, 2-D optical flow or 1-D search along the row of the rectified pair
+    enum class StereoMatchingType { OPTICAL_FLOW, SCANLINE };
+
     /**
      * @details frondend
      * @details compute pose of current frame, add the frame to map
@@ -27,8 +45,17 @@ namespace myslam {
 
         Frontend();
 
+        // stops the keyframe worker thread
+        ~Frontend();
+
         bool AddFrame(Frame::Ptr frame);
 
+        /**
+         * @details Stop the keyframe worker thread, started by the first pipelined keyframe,
+         * @details pending keyframe jobs are finished before it returns; can be called again
+         */
+        void Stop();
+
         void SetMap(Map::Ptr map) { map_ = map; }
 
         void SetBackend(std::shared_ptr<Backend> backend) { backend_ = backend; }
@@ -42,6 +69,47 @@ namespace myslam {
             camera_right_ = right;
         }
 
+        /**
+         * @details run the keyframe work (detection, right image flow, triangulation)
+         * @details on the worker thread, overlapped with the tracking of the next frame
+         */
+        void SetPipelined(bool pipelined) { pipelined_ = pipelined; }
+
+        void SetPoseSolver(PoseSolverType type) { pose_solver_type_ = type; }
+
+        /**
+         * @details choose the detector of new features
+         * @param cell_size size of the cells of DetectorType::GRID and SHI_TOMASI in pixels
+         */
+        void SetDetector(DetectorType type, int cell_size = 40);
+
+        /**
+         * @details choose the optical flow
+         * @param fb_threshold forward-backward check of OpticalFlowType::KLT in pixels, 0 to disable
+         */
+        void SetOpticalFlow(OpticalFlowType type, double fb_threshold = 0);
+
+        /**
+         * @details choose how the features of the left image are found in the right image
+         * @param max_disparity disparity range of StereoMatchingType::SCANLINE in pixels
+         */
+        void SetStereoMatching(StereoMatchingType type, int max_disparity = 96) {
+            stereo_matching_type_ = type;
+            stereo_matcher_.SetMaxDisparity(max_disparity);
+        }
+
+        /**
+         * @details wait up to timeout_ms for the backend optimization requested by each keyframe,
+         * @details so the next keyframe starts from the optimized window; 0 to not wait
+         */
+        void SetBackendWait(int timeout_ms) { backend_wait_ms_ = timeout_ms; }
+
+        /**
+         * @details degraded mode of a frame which is late: a keyframe is only inserted
+         * @details if the tracking is bad, and the keyframe work does not wait for the backend
+         */
+        void SetDegraded(bool degraded) { degraded_.store(degraded); }
+
     private:
         /**
          * @details Track in normal mode
@@ -56,12 +124,34 @@ namespace myslam {
          */
         bool Reset();
 
+        /**
+         * @details optical flow with the cached pyramids, next_pts is the initial guess
+         * @return num of tracked points
+         */
+        int CalcOpticalFlow(const std::vector<cv::Mat> &prev_pyramid,
+                            const std::vector<cv::Mat> &next_pyramid,
+                            const std::vector<cv::Point2f> &prev_pts,
+                            std::vector<cv::Point2f> &next_pts,
+                            std::vector<uchar> &status);
+
         /**
          * @details Track with last frame
+         * @details if the keyframe job of the last frame may still be running,
+         * @details the features it had before the job are tracked from it first,
+         * @details then the job is waited for and the features it created are tracked,
+         * @details so the tracking overlaps the job only up to there
          * @return num of tracked points
          */
         int TrackLastFrame();
 
+        /**
+         * @details Track the given features of a previous frame into current frame with LK flow
+         * @param from last frame, or a keyframe whose job has finished
+         * @param last_features features in the left image of from
+         * @return num of tracked points
+         */
+        int TrackFeatures(Frame::Ptr from, const std::vector<std::shared_ptr<Feature>> &last_features);
+
         /**
          * @details 3D-2D PnP, only for camera pose
          * @details It only use left camera to estimate current frame's pose
@@ -71,11 +161,17 @@ namespace myslam {
          * @details 1. initialized_pose: current_frame_->Pose()
          * @details 2. left_camera_intrinsic: K
          * @details 3. 2D_features: current_frame_->features_left_
-         * @details 4. 3D_MapPoint/landmark_position: mp->pos_
+         * @details 4. 3D_MapPoint/landmark_position: mp->Pos()
          * @return num of inliers/tracking features
          */
         int EstimateCurrentPose();
 
+        /**
+         * @details same as EstimateCurrentPose(), solved by PoseSolver instead of g2o
+         * @return num of inliers/tracking features
+         */
+        int EstimateCurrentPoseDirect();
+
         /**
          * @details set current frame as a keyframe and insert it to backend
          * @return true if success
@@ -89,17 +185,17 @@ namespace myslam {
         bool StereoInit();
 
         /**
-         * @details Detect features in left image in current_frame_
-         * @details keypoints will be saved in current_frame_
+         * @details Detect features in left image of frame
+         * @details keypoints will be saved in frame
          * @return num of features found
          */
-        int DetectFeatures();
+        int DetectFeatures(Frame::Ptr frame);
 
         /**
-         * @details Find the corresponding features in right image of current_frame_
+         * @details Find the corresponding features in right image of frame
          * @return num of features found
          */
-        int FindFeaturesInRight();
+        int FindFeaturesInRight(Frame::Ptr frame);
 
         /**
          * @details Build the initial map with single image
@@ -108,10 +204,28 @@ namespace myslam {
         bool BuildInitMap();
 
         /**
-         * @details Triangulate the 2D points in current frame
+         * @details Triangulate the 2D points in frame
+         * @param first_feature features before this index are skipped
          * @return num of triangulated points
          */
-        int TriangulateNewPoints();
+        int TriangulateNewPoints(Frame::Ptr frame, size_t first_feature = 0);
+
+        /**
+         * @details Keyframe work: detect new features, find them in right image,
+         * @details triangulate new landmarks and activate the backend
+         * @param first_feature only the features from this index are triangulated,
+         * @details the ones before may be read by the tracking of next frame
+         */
+        void ProcessKeyframe(Frame::Ptr frame, size_t first_feature = 0);
+
+        // loop of the keyframe worker thread
+        void KeyframeLoop();
+
+        // request a backend optimization, and wait for it if backend_wait_ms_ > 0
+        void RequestBackendUpdate();
+
+        // block until all queued keyframe jobs are finished
+        void WaitForKeyframeJobs();
 
         /**
          * @details Set the features in keyframe as new observation of the map points
@@ -143,9 +257,39 @@ namespace myslam {
         int num_features_tracking_ = 50;
         int num_features_tracking_bad_ = 20;
         int num_features_needed_for_keyframe_ = 80;
+        cv::Size lk_win_size_ = cv::Size(11, 11); // window of LK flow
+        int lk_max_level_ = 3; // pyramid levels of LK flow
 
         // utilities
-        cv::Ptr<cv::GFTTDetector> gftt_; // feature detector in opencv
+        Detector::Ptr detector_; // feature detector
+        OpticalFlowType optical_flow_type_ = OpticalFlowType::OPENCV;
+        KltTracker klt_{lk_win_size_, 30, 0.01};
+        StereoMatchingType stereo_matching_type_ = StereoMatchingType::OPTICAL_FLOW;
+        StereoMatcher stereo_matcher_;
+        TriangulationBatch triangulation_batch_; // reused by triangulation of each keyframe
+        PoseSolverType pose_solver_type_ = PoseSolverType::G2O;
+        PoseSolver pose_solver_; // reused by pose estimation of each frame
+        std::vector<std::shared_ptr<Feature>> pose_features_; // features in pose_solver_
+
+        // keyframe pipeline
+        bool pipelined_ = true;
+        int backend_wait_ms_ = 0;
+        std::atomic<bool> degraded_{false}; // read by the keyframe worker
+        std::thread keyframe_thread_;
+        std::mutex keyframe_mutex_;
+        std::condition_variable keyframe_cv_; // job queued or stop requested
+        std::condition_variable keyframe_done_; // job finished
+        // keyframe and its num of tracked features, at most one job
+        std::deque<std::pair<Frame::Ptr, size_t>> keyframe_queue_;
+        std::atomic<bool> keyframe_running_{false};
+        std::atomic<unsigned long> latest_frame_id_{0}; // frame being tracked, read by the worker
+
+        // keyframe whose new features are not tracked yet, and its features before the job
+        struct PendingKeyframe {
+            Frame::Ptr frame;
+            std::vector<std::shared_ptr<Feature>> tracked_features;
+        };
+        PendingKeyframe pending_keyframe_; // of the tracking thread, frame is nullptr if none
 
     };
 } // namespace myslam
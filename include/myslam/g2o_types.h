@@ -4,6 +4,7 @@
 #include "common_include.h"
 
 #include <g2o/core/base_binary_edge.h>
+#include <g2o/core/base_multi_edge.h>
 #include <g2o/core/base_unary_edge.h>
 #include <g2o/core/base_vertex.h>
 #include <g2o/core/block_solver.h>
@@ -144,6 +145,91 @@ namespace myslam {
         SE3 _cam_ext;
     };
 
+    /**
+     * @details dense prior on a set of poses and landmarks, left by the marginalization of old keyframes
+     * @details the cost 0.5 * dx^T H dx + b^T dx is stored as 0.5 * |r0 + J dx|^2, J^T J = H, J^T r0 = b,
+     * @details dx_i = log(T_i * T0_i^-1) for a pose and p_i - p0_i for a landmark,
+     * @details at the linearization points T0_i and p0_i,
+     * @details J is kept at the linearization points (first estimate jacobian)
+     */
+    class EdgeMarginalPrior : public g2o::BaseMultiEdge<-1, VecX> {
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+
+        /**
+         * @param poses linearization points of the vertices, all VertexPose, in the order of the vertices
+         * @param J jacobian, 6 columns per pose
+         * @param r0 residual at the linearization points
+         */
+        EdgeMarginalPrior(const std::vector<SE3, Eigen::aligned_allocator<SE3>> &poses, const MatXX &J, const VecX &r0)
+            : EdgeMarginalPrior(std::vector<int>(poses.size(), 6), poses, std::vector<Vec3>(), J, r0) {}
+
+        /**
+         * @param dims 6 for a VertexPose and 3 for a VertexXYZ, in the order of the vertices
+         * @param poses linearization points of the poses, in the order of the vertices
+         * @param points linearization points of the landmarks, in the order of the vertices
+         * @param J jacobian, dims[i] columns per vertex
+         * @param r0 residual at the linearization points
+         */
+        EdgeMarginalPrior(const std::vector<int> &dims, const std::vector<SE3, Eigen::aligned_allocator<SE3>> &poses,
+                          const std::vector<Vec3> &points, const MatXX &J, const VecX &r0)
+            : _dims(dims), _poses(poses), _points(points), _J(J), _r0(r0) {
+            resize(dims.size());
+            setDimension(J.rows());
+            setMeasurement(VecX::Zero(J.rows()));
+            setInformation(MatXX::Identity(J.rows(), J.rows()));
+        }
+
+        virtual void computeError() override {
+            _error = _r0 + _J * Delta();
+        }
+
+        virtual void linearizeOplus() override {
+            int offset = 0;
+            for (size_t i = 0; i < _vertices.size(); ++i) {
+                _jacobianOplus[i] = _J.middleCols(offset, _dims[i]);
+                offset += _dims[i];
+            }
+        }
+
+        // dx of the vertices, stacked
+        VecX Delta() const {
+            VecX dx(_J.cols());
+            int offset = 0;
+            size_t pose = 0, point = 0;
+            for (size_t i = 0; i < _vertices.size(); ++i) {
+                if (_dims[i] == 6) {
+                    const VertexPose *v = static_cast<const VertexPose *>(_vertices[i]);
+                    dx.segment<6>(offset) = (v->estimate() * _poses[pose++].inverse()).log();
+                } else {
+                    const VertexXYZ *v = static_cast<const VertexXYZ *>(_vertices[i]);
+                    dx.segment<3>(offset) = v->estimate() - _points[point++];
+                }
+                offset += _dims[i];
+            }
+            return dx;
+        }
+
+        const MatXX &J() const { return _J; }
+
+        const VecX &r0() const { return _r0; }
+
+        const std::vector<int> &Dims() const { return _dims; }
+
+        const std::vector<SE3, Eigen::aligned_allocator<SE3>> &LinearizationPoints() const { return _poses; }
+
+        const std::vector<Vec3> &PointLinearizationPoints() const { return _points; }
+
+        virtual bool read(std::istream &in) override { return true; }
+        virtual bool write(std::ostream &out) const override { return true; }
+
+    private:
+        std::vector<int> _dims;
+        std::vector<SE3, Eigen::aligned_allocator<SE3>> _poses;
+        std::vector<Vec3> _points;
+        MatXX _J;
+        VecX _r0;
+    };
 
 } // namespace myslam
 
@@ -0,0 +1,34 @@
+#ifndef KITTI_DATASET_H
+#define KITTI_DATASET_H
+
+#include "common_include.h"
+#include "dataset.h"
+
+namespace myslam {
+    /**
+     * @details sequence of the KITTI odometry dataset, image_0/%06d.png and image_1/%06d.png,
+     * @details with the projection matrices of calib.txt and the time stamps of times.txt.
+     * @details The images are downscaled by half.
+     */
+    class KittiDataset : public Dataset {
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+        typedef std::shared_ptr<KittiDataset> Ptr;
+
+        KittiDataset(const std::string &dataset_path);
+
+        ~KittiDataset();
+
+    protected:
+        // read calib.txt and times.txt
+        bool Open() override;
+
+        // left and right images are decoded in parallel
+        bool ReadStereoPair(int index, StereoPair &pair) override;
+
+    private:
+        std::vector<double> time_stamps_;
+    };
+} // namespace myslam
+
+#endif // KITTI_DATASET_H
@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef KLT_H
+#define KLT_H
+
+#include "common_include.h"
+
+namespace myslam {
+
+    /**
+     * @details sparse pyramidal KLT tracker on the pyramids of cv::buildOpticalFlowPyramid,
+     * @details same model and defaults as cv::calcOpticalFlowPyrLK with OPTFLOW_USE_INITIAL_FLOW.
+     * @details The template gradient is computed on the interpolated patch, so the derivative
+     * @details levels of the pyramids are skipped if present and not needed if absent.
+     * @details Points are tracked in batches with cv::parallel_for_, each thread keeps its patch
+     * @details buffers between calls. Track is const and can be called from several threads
+     */
+    class KltTracker {
+    public:
+        KltTracker(cv::Size win_size = cv::Size(11, 11), int max_iterations = 30, double epsilon = 0.01)
+            : win_size_(win_size), max_iterations_(max_iterations), epsilon_(epsilon) {}
+
+        void SetWindow(cv::Size win_size) { win_size_ = win_size; }
+
+        /**
+         * @details forward-backward consistency check, the tracked points are tracked back
+         * @details to the previous image and rejected if they land farther than threshold pixels
+         * @param threshold in pixels, 0 to disable
+         */
+        void SetForwardBackwardCheck(double threshold) { fb_threshold_ = threshold; }
+
+        /**
+         * @details track prev_pts of the previous image to the next image
+         * @param prev_pyramid pyramid of the previous image
+         * @param next_pyramid pyramid of the next image
+         * @param prev_pts
+         * @param next_pts initial guess, the tracked positions on return
+         * @param status 1 if the point is tracked
+         * @return num of tracked points
+         */
+        int Track(const std::vector<cv::Mat> &prev_pyramid, const std::vector<cv::Mat> &next_pyramid,
+                  const std::vector<cv::Point2f> &prev_pts, std::vector<cv::Point2f> &next_pts,
+                  std::vector<uchar> &status) const;
+
+    private:
+        // a pyramid level and the pixels that can be read, including its border
+        struct Level {
+            const cv::Mat *img;
+            int x_min, y_min, x_max, y_max;
+        };
+
+        // levels of a pyramid, with or without derivatives
+        static std::vector<Level> Levels(const std::vector<cv::Mat> &pyramid);
+
+        // track one point from level num_levels - 1 to level 0
+        bool TrackPoint(const Level *prev_levels, const Level *next_levels, int num_levels,
+                        const cv::Point2f &prev_pt, cv::Point2f &next_pt) const;
+
+        cv::Size win_size_;
+        int max_iterations_;
+        double epsilon_;
+        double fb_threshold_ = 0;
+    };
+
+} // namespace myslam
+
+#endif // KLT_H
@@ -6,12 +6,16 @@
 #include "common_include.h"
 #include "frame.h"
 #include "mappoint.h"
+#include "seqlock.h"
 
 namespace myslam{
     /**
      * interact with map
      * for frontend, use InsertKeyframe and InsertMapPoint to insert new keyframe and MapPoint
      * for backend, improve the map, recognize the outlier and remove it
+     * the getters return immutable snapshots. The active window is published by the writers once
+     * per batch of changes and grabbed by the readers in O(1) without their lock (read-copy-update);
+     * the all-time containers grow without bound and are copied on the first read after a change
      */
     class Map {
     public:
@@ -20,48 +24,94 @@ namespace myslam{
         typedef std::shared_ptr<Map> Ptr;
         typedef std::unordered_map<unsigned long, MapPoint::Ptr> LandmarksType;
         typedef std::unordered_map<unsigned long, Frame::Ptr> KeyframesType;
+        typedef std::shared_ptr<const LandmarksType> LandmarksSnapshot;
+        typedef std::shared_ptr<const KeyframesType> KeyframesSnapshot;
 
         Map() {}
 
+        // may remove an old keyframe and walk its features, no keyframe job may be appending to them
         void InsertKeyFrame(Frame::Ptr frame);
         void InsertMapPoint(MapPoint::Ptr map_point);
 
-        // get all MapPoints
-        LandmarksType GetAllMapPoints() {
-            std::unique_lock<std::mutex> lck(data_mutex_);
-            return landmarks_;
-        }
+        // insert the landmarks of a keyframe, published once
+        void InsertMapPoints(const std::vector<MapPoint::Ptr> &map_points);
 
-        // get all keyframes
-        KeyframesType GetAllKeyFrames() {
-            std::unique_lock<std::mutex> lck(data_mutex_);
-            return keyframes_;
-        }
+        // get all MapPoints, O(n) copy under the lock of the writers if they changed
+        LandmarksSnapshot GetAllMapPoints() { return PublishedSnapshot(landmarks_); }
+
+        // get all keyframes, O(n) copy under the lock of the writers if they changed
+        KeyframesSnapshot GetAllKeyFrames() { return PublishedSnapshot(keyframes_); }
 
         // get active MapPoints
-        LandmarksType GetActiveMapPoints() {
-            std::unique_lock<std::mutex> lck(data_mutex_);
-            return active_landmarks_;
-        }
+        LandmarksSnapshot GetActiveMapPoints() const { return std::atomic_load(&active_landmarks_.snapshot); }
 
         // get active keyframes
-        KeyframesType GetActiveKeyFrames() {
-            std::unique_lock<std::mutex> lck(data_mutex_);
-            return active_keyframes_;
-        }
+        KeyframesSnapshot GetActiveKeyFrames() const { return std::atomic_load(&active_keyframes_.snapshot); }
+
+        // num of snapshots published, i.e. copies of a container
+        unsigned long NumSnapshotsPublished() const { return snapshots_published_.load(); }
 
         // clear the point in the map which has 0 observation
         void CleanMap();
 
+        /**
+         * @details the backend writes the poses and positions of an optimized window
+         * @details between BeginCommit and EndCommit, ConsistentRead runs read again
+         * @details until no commit happened during it, so it sees the window of one commit
+         */
+        void BeginCommit() { commit_lock_.WriteLock(); }
+
+        void EndCommit() { commit_lock_.WriteUnlock(); }
+
+        // read must be safe to run again
+        template <typename Read>
+        void ConsistentRead(Read read) const {
+            uint64_t seq;
+            do {
+                seq = commit_lock_.ReadBegin();
+                read();
+            } while (commit_lock_.ReadRetry(seq));
+        }
+
     private:
+        // container of the writers, and its last published version
+        template <typename T>
+        struct Published {
+            T data;
+            std::shared_ptr<const T> snapshot = std::make_shared<const T>(); // std::atomic_load/store only
+            bool changed = false;
+        };
+
+        // publish the changes, write_mutex_ is held; the readers keep their snapshot
+        template <typename T>
+        void Publish(Published<T> &container) {
+            if (!container.changed) return;
+            std::atomic_store(&container.snapshot, std::make_shared<const T>(container.data));
+            container.changed = false;
+            snapshots_published_++;
+        }
+
+        // publish on read, for the containers the writers do not publish
+        template <typename T>
+        std::shared_ptr<const T> PublishedSnapshot(Published<T> &container) {
+            std::unique_lock<std::mutex> lck(write_mutex_);
+            Publish(container);
+            return container.snapshot;
+        }
+
+        // remove the active landmarks without observation, the writer holds write_mutex_
+        void RemoveUnobservedLandmarks();
+
         // Set old keyframe to inactive status
         void RemoveOldKeyframe();
 
-        std::mutex data_mutex_; // lock
-        LandmarksType landmarks_; // all landmarks
-        LandmarksType active_landmarks_; // active landmarks
-        KeyframesType keyframes_; // all keyframes
-        KeyframesType active_keyframes_; // active keyframes
+        std::mutex write_mutex_; // serializes the writers, never taken by the readers
+        SeqLock commit_lock_; // commits of the backend
+        Published<LandmarksType> landmarks_; // all landmarks
+        Published<LandmarksType> active_landmarks_; // active landmarks
+        Published<KeyframesType> keyframes_; // all keyframes
+        Published<KeyframesType> active_keyframes_; // active keyframes
+        std::atomic<unsigned long> snapshots_published_{0};
 
         Frame::Ptr current_frame_ = nullptr;
 
@@ -4,6 +4,8 @@
 #define MAPPOINT_H
 
 #include "common_include.h"
+#include "seqlock.h"
+#include "small_vector.h"
 
 namespace myslam {
     struct Frame;
@@ -21,49 +23,61 @@ namespace myslam {
         typedef std::shared_ptr<MapPoint> Ptr;
         unsigned long id_ = 0; // ID
         bool is_outlier_ = false;
-        Vec3 pos_ = Vec3::Zero(); // position in the world coordinate
-        std::mutex data_mutex_;
+        SeqLocked<3> pos_; // position in the world coordinate
+        std::mutex data_mutex_; // observations lock
 
         // observed_times_ shows how many times the MapPoint is observed by features
         // or how many features/frames correspond to this MapPoint
         // value of 0 means no feature/frame corresponding to this landmark/MapPoint
         int observed_times_ = 0;
 
-        // observations_ show which features can observe this MapPoint
-        std::list<std::weak_ptr<Feature>> observations_;
+        // observations_ show which features can observe this MapPoint,
+        // a landmark is observed by a few keyframes in the window, each in the left and right image
+        typedef SmallVector<std::weak_ptr<Feature>, 8> Observations;
+        Observations observations_;
 
         MapPoint() {}
 
         MapPoint(long id, Vec3 position);
 
-        Vec3 Pos() {
-            std::unique_lock<std::mutex> lck(data_mutex_);
-            return pos_;
+        // thread safe without a mutex, a reader never sees a position which is partially written
+        Vec3 Pos() const {
+            Vec3 pos;
+            pos_.Load(pos.data());
+            return pos;
         }
 
-        void SetPos(const Vec3 &pos) {
-            std::unique_lock<std::mutex> lck(data_mutex_);
-            pos_ = pos;
-        }
+        void SetPos(const Vec3 &pos) { pos_.Store(pos.data()); }
 
         /**
          * if new MapPoint/landmark exist, the corresponding
          * feature will become the new observation and
-         * then be added into observations_ group
+         * then be added into observations_ group,
+         * the feature keeps its index in observations_
          */
-        void AddObservation(std::shared_ptr<Feature> feature) {
-            std::unique_lock<std::mutex> lck(data_mutex_);
-            observations_.push_back(feature);
-            observed_times_++;
-        }
+        void AddObservation(std::shared_ptr<Feature> feature);
 
         /**
          * when feature is outlier,
-         * the observations/MapPoint will be removed
+         * the observations/MapPoint will be removed,
+         * in O(1) by the index kept in the feature
          */
         void RemoveObservation(std::shared_ptr<Feature> feat);
 
-        std::list<std::weak_ptr<Feature>> GetObs() {
+        /**
+         * f(feature) for each observation whose feature still exists, without copying the observations.
+         * f runs under the lock of the observations, it must not call the methods of this MapPoint
+         */
+        template <typename F>
+        void ForEachObservation(F f) {
+            std::unique_lock<std::mutex> lck(data_mutex_);
+            for (auto &obs : observations_) {
+                auto feat = obs.lock();
+                if (feat) f(feat);
+            }
+        }
+
+        Observations GetObs() {
             std::unique_lock<std::mutex> lck(data_mutex_);
             return observations_;
         }
@@ -0,0 +1,58 @@
+#ifndef PIPE_DATASET_H
+#define PIPE_DATASET_H
+
+#include <cstdint>
+#include "common_include.h"
+#include "dataset.h"
+
+namespace myslam {
+    /**
+     * @details live stereo pairs written by a producer process into a named pipe (mkfifo)
+     * @details or a file descriptor such as /dev/stdin, nothing goes through the disk.
+     * @details Each pair is a PipeHeader followed by the left and the right rectified
+     * @details 8-bit images, width * height bytes each, row by row.
+     * @details The source is live, the oldest pairs are dropped if the tracker falls behind.
+     * @details The end of the stream is the end of the sequence.
+     */
+    class PipeDataset : public Dataset {
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+        typedef std::shared_ptr<PipeDataset> Ptr;
+
+        struct PipeHeader {
+            char magic[4]; // MSPP
+            uint32_t width, height;
+            uint32_t reserved;
+            double time_stamp; // s
+        };
+
+        /**
+         * @param pipe path of the pipe, opened for reading by Init(), which waits for the producer
+         * @param camera intrinsics of the rectified images and baseline of the pair
+         */
+        PipeDataset(const std::string &pipe, const Camera &camera);
+
+        ~PipeDataset();
+
+        /**
+         * @details write a stereo pair to fd, for the producers
+         * @return false if the images are not 8-bit of the same size or the write fails
+         */
+        static bool Write(int fd, double time_stamp, const cv::Mat &left, const cv::Mat &right);
+
+    protected:
+        bool Open() override;
+
+        // pairs are read in order, index is not used
+        bool ReadStereoPair(int index, StereoPair &pair) override;
+
+    private:
+        // read size bytes, false at the end of the stream or when the loader stops
+        bool ReadFully(void *data, size_t size);
+
+        Camera camera_;
+        int fd_ = -1;
+    };
+} // namespace myslam
+
+#endif // PIPE_DATASET_H
@@ -0,0 +1,197 @@
+#pragma once
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace myslam {
+
+    // counters of the block pools, summed over all of them
+    struct PoolStats {
+        unsigned long allocations = 0; // blocks handed out
+        unsigned long heap_allocations = 0; // chunks allocated from the heap
+        unsigned long live = 0; // blocks in use
+    };
+
+    /**
+     * @details fixed-size blocks carved from chunks of the heap, freed blocks are kept in a free list
+     * @details and handed out again, the chunks are never returned. The blocks of the frames, landmarks
+     * @details and arena chunks which are released are reused, so tracking does not allocate in steady state.
+     * @details Thread safe, blocks may be freed by another thread than the one which allocated them
+     */
+    class BlockPool {
+    public:
+        BlockPool(size_t block_size, size_t alignment, size_t blocks_per_chunk = 256);
+
+        ~BlockPool();
+
+        void *Allocate();
+
+        void Deallocate(void *block);
+
+        PoolStats Stats();
+
+        // stats of all the pools
+        static PoolStats TotalStats();
+
+    private:
+        struct FreeBlock {
+            FreeBlock *next;
+        };
+
+        size_t block_size_, alignment_, blocks_per_chunk_;
+        std::mutex mutex_;
+        FreeBlock *free_ = nullptr;
+        std::vector<void *> chunks_;
+        PoolStats stats_;
+    };
+
+    /**
+     * @details allocator of std::allocate_shared, the object and its control block are one block of
+     * @details the pool of their type. Other allocations, e.g. of arrays, go to the heap
+     */
+    template <typename T>
+    class PoolAllocator {
+    public:
+        typedef T value_type;
+
+        PoolAllocator() {}
+
+        template <typename U>
+        PoolAllocator(const PoolAllocator<U> &) {}
+
+        template <typename U>
+        struct rebind {
+            typedef PoolAllocator<U> other;
+        };
+
+        T *allocate(size_t n) {
+            if (n != 1) return static_cast<T *>(::operator new(n * sizeof(T)));
+            return static_cast<T *>(Pool().Allocate());
+        }
+
+        void deallocate(T *p, size_t n) {
+            if (n != 1) {
+                ::operator delete(p);
+                return;
+            }
+            Pool().Deallocate(p);
+        }
+
+        // one pool per type, never destroyed, blocks may be freed at exit
+        static BlockPool &Pool() {
+            static BlockPool *pool = new BlockPool(sizeof(T), alignof(T) > 16 ? alignof(T) : 16);
+            return *pool;
+        }
+    };
+
+    template <typename T, typename U>
+    bool operator==(const PoolAllocator<T> &, const PoolAllocator<U> &) { return true; }
+
+    template <typename T, typename U>
+    bool operator!=(const PoolAllocator<T> &, const PoolAllocator<U> &) { return false; }
+
+    // std::make_shared in a pool
+    template <typename T, typename... Args>
+    std::shared_ptr<T> MakePooled(Args &&... args) {
+        return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @details bump allocator of the transient objects of a frame, e.g. its features. The memory
+     * @details is carved from chunks of a shared pool of chunks and is not freed per object, the
+     * @details chunks go back to the pool when the arena is destroyed, i.e. when the frame and all
+     * @details the objects allocated in the arena are released. A frame takes a lock per chunk of
+     * @details the shared pool instead of one per feature.
+     * @details Thread safe, the lock of an arena is only contended by the threads of its frame
+     */
+    class FrameArena {
+    public:
+        typedef std::shared_ptr<FrameArena> Ptr;
+
+        static const size_t kChunkSize = 16384;
+
+        FrameArena() {}
+
+        ~FrameArena();
+
+        FrameArena(const FrameArena &) = delete;
+        FrameArena &operator=(const FrameArena &) = delete;
+
+        void *Allocate(size_t size, size_t alignment);
+
+        // counted only, the memory is released with the arena
+        void Deallocate(void *block);
+
+        // num of chunks of this arena, and of objects not released
+        size_t NumChunks();
+        size_t NumLive();
+
+        // stats of the pool of the chunks of all the arenas
+        static PoolStats ChunkStats();
+
+    private:
+        static BlockPool &ChunkPool();
+
+        std::mutex mutex_;
+        std::vector<void *> chunks_; // blocks of ChunkPool()
+        std::vector<void *> large_; // from the heap, larger than a chunk
+        char *head_ = nullptr, *end_ = nullptr;
+        size_t live_ = 0;
+    };
+
+    /**
+     * @details allocator of std::allocate_shared in a FrameArena, the control block keeps
+     * @details the arena alive until the object and its weak references are released
+     */
+    template <typename T>
+    class ArenaAllocator {
+    public:
+        typedef T value_type;
+
+        explicit ArenaAllocator(FrameArena::Ptr arena) : arena_(std::move(arena)) {}
+
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U> &other) : arena_(other.arena_) {}
+
+        template <typename U>
+        struct rebind {
+            typedef ArenaAllocator<U> other;
+        };
+
+        T *allocate(size_t n) {
+            return static_cast<T *>(arena_->Allocate(n * sizeof(T), alignof(T) > 16 ? alignof(T) : 16));
+        }
+
+        void deallocate(T *p, size_t) { arena_->Deallocate(p); }
+
+    private:
+        template <typename U>
+        friend class ArenaAllocator;
+
+        template <typename U, typename V>
+        friend bool operator==(const ArenaAllocator<U> &, const ArenaAllocator<V> &);
+
+        FrameArena::Ptr arena_;
+    };
+
+    template <typename T, typename U>
+    bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) { return a.arena_ == b.arena_; }
+
+    template <typename T, typename U>
+    bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) { return !(a == b); }
+
+    // std::make_shared in an arena
+    template <typename T, typename... Args>
+    std::shared_ptr<T> MakeInArena(const FrameArena::Ptr &arena, Args &&... args) {
+        return std::allocate_shared<T>(ArenaAllocator<T>(arena), std::forward<Args>(args)...);
+    }
+
+} // namespace myslam
+
+#endif // POOL_H
@@ -0,0 +1,85 @@
+#pragma once
+
+#ifndef POSE_SOLVER_H
+#define POSE_SOLVER_H
+
+#include "common_include.h"
+
+namespace myslam {
+
+    /**
+     * @details pose only Levenberg-Marquardt solver, the same problem as
+     * @details EdgeProjectionPoseOnly in g2o: min sum rho(||z - pi(K * T * p_w)||^2)
+     * @details the 6x6 normal equations are accumulated directly from
+     * @details structure of arrays of points and measurements,
+     * @details the buffers are kept between frames, so solving does not allocate
+     */
+    class PoseSolver {
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+
+        PoseSolver() {}
+
+        void SetCamera(const Mat33 &K) { K_ = K; }
+
+        // remove all observations, the capacity is kept
+        void Clear();
+
+        /**
+         * @param pos landmark in the world coordinate
+         * @param measurement pixel
+         */
+        void AddObservation(const Vec3 &pos, const Vec2 &measurement);
+
+        size_t Size() const { return px_.size(); }
+
+        /**
+         * @details same schedule as the g2o pose estimation of the frontend:
+         * @details num_rounds_ rounds of num_iterations_ iterations, each from the initial pose,
+         * @details observations with chi2 > chi2_th_ are outliers in the next round,
+         * @details the Huber kernel is used in the first 3 rounds
+         * @param pose Tcw, initial value and the result
+         * @return num of inliers
+         */
+        int Solve(SE3 &pose);
+
+        // outlier flag of observation i after Solve()
+        bool IsOutlier(size_t i) const { return outlier_[i] != 0; }
+
+        // settings
+        int num_rounds_ = 4;
+        int num_iterations_ = 10;
+        double chi2_th_ = 5.991;
+        double huber_delta_ = 1.0; // g2o::RobustKernelHuber default
+
+    private:
+        /**
+         * @details accumulate H = sum w J^T J and b = -sum w J^T e over the inliers
+         * @return robust chi2 of the inliers
+         */
+        double BuildNormalEquations(const SE3 &pose, bool robust, Mat66 &H, Vec6 &b) const;
+
+        // robust chi2 of the inliers at pose
+        double RobustChi2(const SE3 &pose, bool robust) const;
+
+        // Levenberg-Marquardt iterations on the inliers
+        void Optimize(SE3 &pose, bool robust) const;
+
+        // chi2 of each observation at pose
+        void ComputeChi2(const SE3 &pose);
+
+        // rho and its first derivative of the Huber kernel
+        void Robustify(double e2, bool robust, double &rho0, double &rho1) const;
+
+        Mat33 K_ = Mat33::Identity();
+
+        // structure of arrays
+        std::vector<double> px_, py_, pz_; // landmarks, world
+        std::vector<double> u_, v_; // measurements, pixel
+        std::vector<double> chi2_;
+        std::vector<uchar> outlier_;
+    };
+
+} // namespace myslam
+
+#endif // POSE_SOLVER_H
@@ -0,0 +1,135 @@
+#pragma once
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace myslam {
+
+    /**
+     * @details latencies of the stages of the pipeline and counters, e.g. num of features.
+     * @details Each thread records its events in its own ring, a single-producer single-consumer
+     * @details queue without locks; Collect moves them to the profiler, it must be called often
+     * @details enough that the rings do not fill up, the events of a full ring are dropped.
+     * @details Names must be string literals, they are kept by pointer.
+     * @details Disabled by default, then recording only loads an atomic flag
+     */
+    class Profiler {
+    public:
+        // the profiler of the process
+        static Profiler &Instance();
+
+        void SetEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+
+        bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+        // ns since the profiler was created
+        int64_t Now() const {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start_).count();
+        }
+
+        // a stage of the calling thread from start_ns to end_ns
+        void RecordSpan(const char *name, int64_t start_ns, int64_t end_ns);
+
+        // a value of a counter at the current time
+        void RecordCounter(const char *name, double value);
+
+        // move the events of the rings of all the threads to the profiler
+        void Collect();
+
+        // statistics of a stage in ms, or of a counter
+        struct Summary {
+            std::string name;
+            bool is_span = false;
+            size_t count = 0;
+            double mean = 0, p50 = 0, p95 = 0, p99 = 0, max = 0;
+        };
+
+        // summaries of the events collected, sorted by name
+        std::vector<Summary> Summaries();
+
+        // num of events dropped because a ring was full
+        unsigned long NumDropped();
+
+        // summaries as a JSON object, or one CSV row per stage or counter
+        bool WriteJson(const std::string &path);
+
+        bool WriteCsv(const std::string &path);
+
+        // all the events collected in the Chrome trace event format, for chrome://tracing or Perfetto
+        bool WriteChromeTrace(const std::string &path);
+
+        // forget the events collected
+        void Clear();
+
+    private:
+        Profiler() : start_(std::chrono::steady_clock::now()) {}
+
+        struct Event {
+            const char *name;
+            int64_t start_ns;
+            int64_t duration_ns; // < 0 for counters
+            double value;
+        };
+
+        // single-producer single-consumer, written by one thread and read under collect_mutex_
+        struct Ring {
+            static const size_t kCapacity = 1 << 14;
+
+            explicit Ring(int thread_index) : thread_index(thread_index), events(kCapacity) {}
+
+            const int thread_index;
+            std::vector<Event> events;
+            std::atomic<size_t> head{0}; // next write, only the producer writes it
+            std::atomic<size_t> tail{0}; // next read, only the consumer writes it
+            std::atomic<unsigned long> dropped{0};
+        };
+
+        Ring &ThreadRing();
+
+        void Push(const Event &event);
+
+        std::atomic<bool> enabled_{false};
+        const std::chrono::steady_clock::time_point start_;
+
+        std::mutex rings_mutex_; // guards rings_
+        std::vector<std::unique_ptr<Ring>> rings_;
+
+        std::mutex collect_mutex_; // consumer of the rings, guards events_
+        std::vector<std::pair<int, Event>> events_; // thread index and event
+    };
+
+    /**
+     * @details records the lifetime of the timer as a span of the stage name
+     */
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(const char *name)
+                : name_(name), enabled_(Profiler::Instance().Enabled()),
+                  start_ns_(enabled_ ? Profiler::Instance().Now() : 0) {}
+
+        ~ScopedTimer() {
+            if (enabled_) Profiler::Instance().RecordSpan(name_, start_ns_, Profiler::Instance().Now());
+        }
+
+        ScopedTimer(const ScopedTimer &) = delete;
+
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    private:
+        const char *name_;
+        const bool enabled_;
+        const int64_t start_ns_;
+    };
+
+} // namespace myslam
+
+#endif // PROFILER_H
@@ -0,0 +1,73 @@
+#pragma once
+
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <chrono>
+#include "common_include.h"
+
+namespace myslam {
+
+    struct RealtimeStats {
+        unsigned long frames = 0; // scheduled
+        unsigned long processed = 0; // including the degraded ones
+        unsigned long dropped = 0; // stale at their release, not processed
+        unsigned long degraded = 0; // processed late, without the optional work
+        unsigned long deadline_misses = 0; // processed, but finished after their deadline
+        double max_latency_ms = 0; // from release to finish of a processed frame
+    };
+
+    /**
+     * @details schedule of the frames of a replay or a live source at the rate of their time stamps.
+     * @details The frame with time stamp t is released at start + (t - t0) / speed, where the first
+     * @details frame, at t0, is released when it is scheduled. A frame is due by its deadline, its
+     * @details release plus the deadline, by default the period to the previous frame.
+     * @details A frame which starts after half of its deadline is degraded, one which starts after
+     * @details its deadline is dropped, so that the tracker catches up with the source instead of
+     * @details falling behind without bound. The first frame is never dropped.
+     */
+    class RealtimeScheduler {
+    public:
+        typedef std::shared_ptr<RealtimeScheduler> Ptr;
+        typedef std::chrono::steady_clock Clock;
+
+        enum class Decision { PROCESS, DEGRADE, DROP };
+
+        /**
+         * @param speed replay rate of the time stamps, 1 for the camera rate
+         * @param deadline_ms deadline after the release, 0 for the period between the frames
+         */
+        RealtimeScheduler(double speed = 1.0, double deadline_ms = 0);
+
+        // when the frame at time_stamp is released, the first call starts the schedule
+        Clock::time_point Release(double time_stamp);
+
+        // what to do with the frame at time_stamp, started at now
+        Decision Decide(double time_stamp, Clock::time_point now);
+
+        /**
+         * @details the frame of the last PROCESS or DEGRADE decision is finished at now
+         * @return latency from its release in ms
+         */
+        double Finish(Clock::time_point now);
+
+        const RealtimeStats &Stats() const { return stats_; }
+
+    private:
+        double speed_;
+        double deadline_ms_;
+
+        bool started_ = false;
+        Clock::time_point start_;
+        double first_time_stamp_ = 0, last_time_stamp_ = 0;
+        double period_ms_ = 0; // between the last two frames, at the replay rate
+
+        // frame being processed
+        Clock::time_point release_, deadline_;
+
+        RealtimeStats stats_;
+    };
+
+} // namespace myslam
+
+#endif // REALTIME_H
@@ -0,0 +1,88 @@
+#pragma once
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace myslam {
+
+    /**
+     * @details sequence lock, the sequence is odd while a writer is writing.
+     * @details Readers do not write shared memory and never block writers,
+     * @details they read again if the sequence was odd or changed during the read.
+     * @details Writers are serialized by a compare-and-swap on the sequence
+     */
+    class SeqLock {
+    public:
+        void WriteLock() {
+            uint64_t seq = seq_.load(std::memory_order_relaxed);
+            while ((seq & 1) || !seq_.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                                                             std::memory_order_relaxed)) {
+                if (seq & 1) {
+                    std::this_thread::yield();
+                    seq = seq_.load(std::memory_order_relaxed);
+                }
+            }
+            // the data written after this are not visible before the odd sequence
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        void WriteUnlock() {
+            seq_.store(seq_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // start of a read, waits while a writer is writing
+        uint64_t ReadBegin() const {
+            uint64_t seq = seq_.load(std::memory_order_acquire);
+            while (seq & 1) {
+                std::this_thread::yield();
+                seq = seq_.load(std::memory_order_acquire);
+            }
+            return seq;
+        }
+
+        // end of a read started with ReadBegin, true if the data read may be torn
+        bool ReadRetry(uint64_t seq) const {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return seq_.load(std::memory_order_relaxed) != seq;
+        }
+
+    private:
+        std::atomic<uint64_t> seq_{0};
+    };
+
+    /**
+     * @details N doubles published under a SeqLock, each stored in a relaxed atomic
+     */
+    template <int N>
+    class SeqLocked {
+    public:
+        SeqLocked() {
+            for (int i = 0; i < N; ++i) values_[i].store(0, std::memory_order_relaxed);
+        }
+
+        void Store(const double *values) {
+            lock_.WriteLock();
+            for (int i = 0; i < N; ++i) values_[i].store(values[i], std::memory_order_relaxed);
+            lock_.WriteUnlock();
+        }
+
+        void Load(double *values) const {
+            uint64_t seq;
+            do {
+                seq = lock_.ReadBegin();
+                for (int i = 0; i < N; ++i) values[i] = values_[i].load(std::memory_order_relaxed);
+            } while (lock_.ReadRetry(seq));
+        }
+
+    private:
+        SeqLock lock_;
+        std::atomic<double> values_[N];
+    };
+
+} // namespace myslam
+
+#endif // SEQLOCK_H
@@ -0,0 +1,87 @@
+#pragma once
+
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace myslam {
+
+    /**
+     * @details vector with the first N elements stored inline, no allocation until it grows
+     * @details beyond N, then all the elements move to the heap and stay there.
+     * @details Only what MapPoint needs: push_back, pop_back, swap-remove and indexing
+     */
+    template <typename T, int N>
+    class SmallVector {
+    public:
+        size_t size() const { return size_; }
+
+        bool empty() const { return size_ == 0; }
+
+        T *data() { return on_heap_ ? heap_.data() : inline_; }
+
+        const T *data() const { return on_heap_ ? heap_.data() : inline_; }
+
+        T *begin() { return data(); }
+
+        T *end() { return data() + size_; }
+
+        const T *begin() const { return data(); }
+
+        const T *end() const { return data() + size_; }
+
+        T &operator[](size_t i) { return data()[i]; }
+
+        const T &operator[](size_t i) const { return data()[i]; }
+
+        T &back() { return data()[size_ - 1]; }
+
+        void push_back(const T &value) {
+            if (!on_heap_ && size_ == N) {
+                heap_.reserve(2 * N);
+                for (int i = 0; i < N; ++i) {
+                    heap_.push_back(std::move(inline_[i]));
+                    inline_[i] = T();
+                }
+                on_heap_ = true;
+            }
+            if (on_heap_) {
+                heap_.push_back(value);
+            } else {
+                inline_[size_] = value;
+            }
+            size_++;
+        }
+
+        void pop_back() {
+            if (on_heap_) {
+                heap_.pop_back();
+            } else {
+                inline_[size_ - 1] = T(); // release what the element holds
+            }
+            size_--;
+        }
+
+        // O(1) removal, the last element takes the place of element i
+        void swap_remove(size_t i) {
+            if (i + 1 != size_) (*this)[i] = std::move(back());
+            pop_back();
+        }
+
+        void clear() {
+            while (size_ > 0) pop_back();
+        }
+
+    private:
+        T inline_[N];
+        std::vector<T> heap_;
+        size_t size_ = 0;
+        bool on_heap_ = false;
+    };
+
+} // namespace myslam
+
+#endif // SMALL_VECTOR_H
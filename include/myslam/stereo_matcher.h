@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef STEREO_MATCHER_H
+#define STEREO_MATCHER_H
+
+#include "common_include.h"
+
+namespace myslam {
+
+    /**
+     * @details matcher of rectified stereo pairs, the match of a left pixel is on the same row
+     * @details of the right image. SAD of a block along the row within a disparity range,
+     * @details sub-pixel disparity by a parabola through the costs around the minimum
+     */
+    class StereoMatcher {
+    public:
+        /**
+         * @param half_block the block is (2 * half_block + 1) x (2 * half_block + 1)
+         * @param max_disparity disparity range of the full search is [0, max_disparity]
+         * @param search_margin range around the predicted disparity
+         * @param uniqueness_ratio the best cost must be lower than ratio times the second best
+         * @param max_mean_cost mean absolute difference above which the window around
+         * @param max_mean_cost the predicted disparity is not trusted and the full range is searched
+         */
+        StereoMatcher(int half_block = 3, int max_disparity = 96,
+                      int search_margin = 4, double uniqueness_ratio = 0.9, double max_mean_cost = 10)
+            : half_block_(half_block), max_disparity_(max_disparity),
+              search_margin_(search_margin), uniqueness_ratio_(uniqueness_ratio),
+              max_mean_cost_(max_mean_cost) {}
+
+        void SetMaxDisparity(int max_disparity) { max_disparity_ = max_disparity; }
+
+        /**
+         * @details match the left points in the right image
+         * @param left rectified left image, 8-bit
+         * @param right rectified right image, 8-bit
+         * @param left_pts
+         * @param predicted_disparity disparity of each point predicted by its map point, < 0 if unknown,
+         * @param predicted_disparity the search falls back to the full range if the minimum is at the bound
+         * @param right_pts matched points
+         * @param status 1 if the point is matched
+         * @return num of matched points
+         */
+        int Match(const cv::Mat &left, const cv::Mat &right,
+                  const std::vector<cv::Point2f> &left_pts,
+                  const std::vector<float> &predicted_disparity,
+                  std::vector<cv::Point2f> &right_pts, std::vector<uchar> &status) const;
+
+    private:
+        /**
+         * @details search the disparities [d_min, d_max] of the block at (x, y)
+         * @param costs SAD of each disparity, d_max - d_min + 1 elements
+         * @return best disparity, -1 if the minimum is ambiguous
+         */
+        int Search(const cv::Mat &left, const cv::Mat &right, int x, int y,
+                   int d_min, int d_max, int *costs) const;
+
+        int half_block_;
+        int max_disparity_;
+        int search_margin_;
+        double uniqueness_ratio_;
+        double max_mean_cost_;
+    };
+
+} // namespace myslam
+
+#endif // STEREO_MATCHER_H
@@ -0,0 +1,64 @@
+#ifndef SYNTHETIC_DATASET_H
+#define SYNTHETIC_DATASET_H
+
+#include "common_include.h"
+#include "dataset.h"
+#include "trajectory.h"
+
+namespace myslam {
+    /**
+     * @details deterministic stereo sequence rendered from a procedural scene, with exact ground truth.
+     * @details The scene is an endless corridor, two walls, a floor and a ceiling, with a texture of
+     * @details blocks and value noise which fades out with distance. The stereo rig drives along it on
+     * @details a weaving trajectory. Each pixel is ray-cast, so the images of the two cameras
+     * @details are consistent with the depth of the scene. Same options, same images
+     */
+    class SyntheticDataset : public Dataset {
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+        typedef std::shared_ptr<SyntheticDataset> Ptr;
+
+        struct Options {
+            int width = 621, height = 188; // half resolution KITTI
+            double fx = 358.5, fy = 358.5;
+            double baseline = 0.537; // m
+            int num_frames = 500;
+            double fps = 10; // time stamps of the frames
+            double speed = 1.0; // m per frame
+            double texture_scale = 0.3; // m, size of the texture blocks, smaller for more features
+            double noise = 1.0; // standard deviation of the pixel noise, gray levels
+            unsigned seed = 0; // texture and noise
+        };
+
+        explicit SyntheticDataset(const Options &options);
+
+        ~SyntheticDataset();
+
+        // Twc of the left camera at each frame, set by Init()
+        const Trajectory &GroundTruth() const { return ground_truth_; }
+
+    protected:
+        // cameras and trajectory
+        bool Open() override;
+
+        // render the stereo pair at index
+        bool ReadStereoPair(int index, StereoPair &pair) override;
+
+    private:
+        // gray level of the ray through pixel (u, v) of the camera at Twc
+        double Shade(const SE3 &Twc, double u, double v) const;
+
+        // texture of a plane at in-plane coordinates (a, b), in [0, 1]
+        double Texture(int plane, double a, double b) const;
+
+        // hash of a lattice point of a plane to [0, 1)
+        double Hash(int plane, int64_t i, int64_t j, int octave) const;
+
+        void Render(const SE3 &Tcw, const Camera &camera, int camera_id, int index, cv::Mat &image) const;
+
+        Options options_;
+        Trajectory ground_truth_;
+    };
+} // namespace myslam
+
+#endif // SYNTHETIC_DATASET_H
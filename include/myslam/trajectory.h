@@ -0,0 +1,36 @@
+#pragma once
+
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include "common_include.h"
+
+namespace myslam {
+
+    // camera poses of the frames, Twc
+    typedef std::vector<SE3, Eigen::aligned_allocator<SE3>> Trajectory;
+
+    /**
+     * @details KITTI odometry ground truth, poses/XX.txt, one frame per line,
+     * @details the 3x4 matrix [R|t] of Twc row by row
+     * @return false if the file cannot be read
+     */
+    bool LoadKittiPoses(const std::string &path, Trajectory &poses);
+
+    struct TrajectoryError {
+        size_t num_poses = 0; // compared, the shorter of the two trajectories
+        double ate = 0; // RMSE of the positions after alignment, m
+        double rpe_translation = 0; // RMSE of the relative translations, m
+        double rpe_rotation = 0; // RMSE of the relative rotations, deg
+    };
+
+    /**
+     * @details absolute trajectory error after aligning the estimate to the ground truth
+     * @details by a rigid transformation (Umeyama, without scale, stereo is metric),
+     * @details and relative pose error between frames delta apart
+     */
+    TrajectoryError EvaluateTrajectory(const Trajectory &estimate, const Trajectory &ground_truth, int delta = 1);
+
+} // namespace myslam
+
+#endif // TRAJECTORY_H
@@ -0,0 +1,42 @@
+#ifndef VIDEO_DATASET_H
+#define VIDEO_DATASET_H
+
+#include <chrono>
+#include <opencv2/videoio.hpp>
+#include "common_include.h"
+#include "dataset.h"
+
+namespace myslam {
+    /**
+     * @details rectified stereo pairs of a video file or a capture device, side by side
+     * @details in each frame, the left image in the left half. The time stamps are the
+     * @details positions in the video, or the time of capture of a device, which is live.
+     */
+    class VideoDataset : public Dataset {
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+        typedef std::shared_ptr<VideoDataset> Ptr;
+
+        /**
+         * @param video file name, or the index of a capture device
+         * @param camera intrinsics of the rectified images and baseline of the pair
+         */
+        VideoDataset(const std::string &video, const Camera &camera);
+
+        ~VideoDataset();
+
+    protected:
+        bool Open() override;
+
+        // frames are read in order, index is not used
+        bool ReadStereoPair(int index, StereoPair &pair) override;
+
+    private:
+        Camera camera_;
+        cv::VideoCapture capture_;
+        bool device_ = false;
+        std::chrono::steady_clock::time_point start_;
+    };
+} // namespace myslam
+
+#endif // VIDEO_DATASET_H
@@ -43,8 +43,8 @@ namespace myslam {
         std::thread viewer_thread_;
         bool viewer_running_ = true;
 
-        std::unordered_map<unsigned long, Frame::Ptr> active_keyframes_;
-        std::unordered_map<unsigned long, MapPoint::Ptr> active_landmarks_;
+        Map::KeyframesSnapshot active_keyframes_;
+        Map::LandmarksSnapshot active_landmarks_;
         bool map_updated_ = false;
 
         std::mutex viewer_data_mutex_;
@@ -7,6 +7,7 @@
 #include "common_include.h"
 #include "dataset.h"
 #include "frontend.h"
+#include "realtime.h"
 #include "viewer.h"
 
 namespace myslam{
@@ -18,17 +19,44 @@ namespace myslam{
         // constructor with config file
         VisualOdometry(std::string &config_path);
 
+        // no viewer whatever the config says, e.g. for benchmarks; set before Init()
+        void SetHeadless(bool headless) { headless_ = headless; }
+
         bool Init();
 
         void Run();
 
+        // process the next frame of the dataset, false at the end of the sequence
         bool Step();
 
+        /**
+         * @details process a frame which does not come from the dataset, e.g. preloaded
+         * @details in real-time mode, wait for its release, and drop it if it is stale
+         */
+        bool AddFrame(Frame::Ptr frame);
+
+        /**
+         * @details real-time mode, the frames are paced by their time stamps, see RealtimeScheduler;
+         * @details overrides the config after Init()
+         * @param speed replay rate of the time stamps, 0 to process the frames as fast as possible
+         * @param deadline_ms deadline of a frame after its release, 0 for the period between the frames
+         */
+        void SetRealtime(double speed, double deadline_ms = 0);
+
+        // null if not in real-time mode
+        RealtimeScheduler::Ptr GetRealtimeScheduler() const { return scheduler_; }
+
+        // stop the threads and log the statistics, called by Run() at the end
+        void Shutdown();
+
+        Dataset::Ptr GetDataset() const { return dataset_; }
+
         //
         FrontendStatus GetFrontendStatus() const { return frontend_->GetStatus(); }
 
     private:
         bool inited_ = false;
+        bool headless_ = false;
         std::string config_file_path_;
 
         Frontend::Ptr frontend_ = nullptr;
@@ -38,6 +66,13 @@ namespace myslam{
 
         // dataset
         Dataset::Ptr dataset_ = nullptr;
+
+        // real-time mode
+        RealtimeScheduler::Ptr scheduler_ = nullptr;
+
+        // profiler results are written to profile_output_ + .json, .csv and .trace.json
+        std::string profile_output_;
+        unsigned long pool_allocations_ = 0, heap_allocations_ = 0; // pool stats at the last frame
     };
 
 } // namespace myslam
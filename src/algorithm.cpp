@@ -0,0 +1,144 @@
+#include "myslam/algorithm.h"
+
+#include <cmath>
+#include <opencv2/core/utility.hpp>
+
+namespace myslam {
+
+    namespace {
+        // batches smaller than this are not worth splitting across threads
+        const int kParallelTriangulationSize = 2048;
+
+        /**
+         * triangulate points [begin, end) of the batch
+         * each view gives two rows of D (4x4), the point is the null vector of D as in
+         * triangulation(), found in closed form from the adjugate of D (~ V S^-1 U^T),
+         * refined with one step of inverse iteration. A point is good if
+         * sigma_4^2 * sum of 1 / sigma_i^2 - 1 of D is < 1e-4, which implies sigma_4 / sigma_3 < 1e-2
+         * of the SVD check of triangulation(), but rejects some points with sigma_4 / sigma_3
+         * down to 1e-2 / sqrt(3); those have sigma_1, sigma_2 close to sigma_3, rare for stereo
+         * the loop body has no branch, so it is vectorized across points
+         */
+        void TriangulateRange(const Mat34 &P0, const Mat34 &P1, int begin, int end,
+                              const double *__restrict x0, const double *__restrict y0,
+                              const double *__restrict x1, const double *__restrict y1,
+                              double *__restrict px, double *__restrict py, double *__restrict pz,
+                              uchar *__restrict success) {
+            // rows of the projection matrices, in scalars so the loop body is plain arithmetic
+            const double a00 = P0(0, 0), a01 = P0(0, 1), a02 = P0(0, 2), a03 = P0(0, 3);
+            const double a10 = P0(1, 0), a11 = P0(1, 1), a12 = P0(1, 2), a13 = P0(1, 3);
+            const double a20 = P0(2, 0), a21 = P0(2, 1), a22 = P0(2, 2), a23 = P0(2, 3);
+            const double b00 = P1(0, 0), b01 = P1(0, 1), b02 = P1(0, 2), b03 = P1(0, 3);
+            const double b10 = P1(1, 0), b11 = P1(1, 1), b12 = P1(1, 2), b13 = P1(1, 3);
+            const double b20 = P1(2, 0), b21 = P1(2, 1), b22 = P1(2, 2), b23 = P1(2, 3);
+
+            for (int i = begin; i < end; ++i) {
+                // D, [u_i P_i,3^T - P_i,1^T], [v_i P_i,3^T - P_i,2^T]
+                const double d00 = x0[i] * a20 - a00, d01 = x0[i] * a21 - a01,
+                             d02 = x0[i] * a22 - a02, d03 = x0[i] * a23 - a03;
+                const double d10 = y0[i] * a20 - a10, d11 = y0[i] * a21 - a11,
+                             d12 = y0[i] * a22 - a12, d13 = y0[i] * a23 - a13;
+                const double d20 = x1[i] * b20 - b00, d21 = x1[i] * b21 - b01,
+                             d22 = x1[i] * b22 - b02, d23 = x1[i] * b23 - b03;
+                const double d30 = y1[i] * b20 - b10, d31 = y1[i] * b21 - b11,
+                             d32 = y1[i] * b22 - b12, d33 = y1[i] * b23 - b13;
+
+                // 2x2 minors of the upper (rows 0, 1) and lower (rows 2, 3) halves
+                const double s0 = d00 * d11 - d10 * d01, s1 = d00 * d12 - d10 * d02;
+                const double s2 = d00 * d13 - d10 * d03, s3 = d01 * d12 - d11 * d02;
+                const double s4 = d01 * d13 - d11 * d03, s5 = d02 * d13 - d12 * d03;
+                const double t5 = d22 * d33 - d32 * d23, t4 = d21 * d33 - d31 * d23;
+                const double t3 = d21 * d32 - d31 * d22, t2 = d20 * d33 - d30 * d23;
+                const double t1 = d20 * d32 - d30 * d22, t0 = d20 * d31 - d30 * d21;
+                                // C = adj(D) = det(D) D^-1, c_rc
+                const double c00 = d11 * t5 - d12 * t4 + d13 * t3;
+                const double c01 = -d01 * t5 + d02 * t4 - d03 * t3;
+                const double c02 = d31 * s5 - d32 * s4 + d33 * s3;
+                const double c03 = -d21 * s5 + d22 * s4 - d23 * s3;
+                const double c10 = -d10 * t5 + d12 * t2 - d13 * t1;
+                const double c11 = d00 * t5 - d02 * t2 + d03 * t1;
+                const double c12 = -d30 * s5 + d32 * s2 - d33 * s1;
+                const double c13 = d20 * s5 - d22 * s2 + d23 * s1;
+                const double c20 = d10 * t4 - d11 * t2 + d13 * t0;
+                const double c21 = -d00 * t4 + d01 * t2 - d03 * t0;
+                const double c22 = d30 * s4 - d31 * s2 + d33 * s0;
+                const double c23 = -d20 * s4 + d21 * s2 - d23 * s0;
+                const double c30 = -d10 * t3 + d11 * t1 - d12 * t0;
+                const double c31 = d00 * t3 - d01 * t1 + d02 * t0;
+                const double c32 = -d30 * s3 + d31 * s1 - d32 * s0;
+                const double c33 = d20 * s3 - d21 * s1 + d22 * s0;
+
+                // D^-1 = V S^-1 U^T is dominated by the null vector of D,
+                // start from its column with the largest norm
+                const double n0 = c00 * c00 + c10 * c10 + c20 * c20 + c30 * c30;
+                const double n1 = c01 * c01 + c11 * c11 + c21 * c21 + c31 * c31;
+                const double n2 = c02 * c02 + c12 * c12 + c22 * c22 + c32 * c32;
+                const double n3 = c03 * c03 + c13 * c13 + c23 * c23 + c33 * c33;
+                // selections as blends, so the loop has no branch and is vectorized
+                const double use1 = n1 > n0, use3 = n3 > n2;
+                const double n01 = n0 + use1 * (n1 - n0), n23 = n2 + use3 * (n3 - n2);
+                const double use23 = n23 > n01;
+                const double w0 = c00 + use1 * (c01 - c00) + use23 * (c02 + use3 * (c03 - c02) - c00 - use1 * (c01 - c00));
+                const double w1 = c10 + use1 * (c11 - c10) + use23 * (c12 + use3 * (c13 - c12) - c10 - use1 * (c11 - c10));
+                const double w2 = c20 + use1 * (c21 - c20) + use23 * (c22 + use3 * (c23 - c22) - c20 - use1 * (c21 - c20));
+                const double w3 = c30 + use1 * (c31 - c30) + use23 * (c32 + use3 * (c33 - c32) - c30 - use1 * (c31 - c30));
+
+                // one step of inverse iteration, v = C C^T w ~ (D^T D)^-1 w
+                const double u0 = c00 * w0 + c10 * w1 + c20 * w2 + c30 * w3;
+                const double u1 = c01 * w0 + c11 * w1 + c21 * w2 + c31 * w3;
+                const double u2 = c02 * w0 + c12 * w1 + c22 * w2 + c32 * w3;
+                const double u3 = c03 * w0 + c13 * w1 + c23 * w2 + c33 * w3;
+                const double v0 = c00 * u0 + c01 * u1 + c02 * u2 + c03 * u3;
+                const double v1 = c10 * u0 + c11 * u1 + c12 * u2 + c13 * u3;
+                const double v2 = c20 * u0 + c21 * u1 + c22 * u2 + c23 * u3;
+                const double v3 = c30 * u0 + c31 * u1 + c32 * u2 + c33 * u3;
+
+                // D v = det(D) u, so sigma_4^2 = det^2 ||u||^2 / ||v||^2 from the Rayleigh quotient,
+                // and sum of 1 / sigma_i^2 = ||D^-1||_F^2 = ||C||_F^2 / det^2,
+                // sigma_4^2 ||D^-1||_F^2 - 1 is in [(sigma_4 / sigma_3)^2, 3 (sigma_4 / sigma_3)^2],
+                // so the threshold is stricter than the one of triangulation(), never looser
+                const double u_norm2 = u0 * u0 + u1 * u1 + u2 * u2 + u3 * u3;
+                const double v_norm2 = v0 * v0 + v1 * v1 + v2 * v2 + v3 * v3;
+                const double ratio2 = u_norm2 * (n0 + n1 + n2 + n3) / v_norm2 - 1;
+
+                // a point at infinity is not good anyway
+                const double v3_inv = 1.0 / v3;
+                px[i] = v0 * v3_inv;
+                py[i] = v1 * v3_inv;
+                pz[i] = v2 * v3_inv;
+                success[i] = (ratio2 < 1e-4) & (std::abs(v3_inv) < 1e300);
+            }
+        }
+    } // namespace
+
+    int triangulation(const SE3 &pose0, const SE3 &pose1, TriangulationBatch &batch) {
+        const int n = batch.Size();
+        batch.px.resize(n);
+        batch.py.resize(n);
+        batch.pz.resize(n);
+        batch.success.resize(n);
+        if (n == 0) return 0;
+
+        const Mat34 P0 = pose0.matrix3x4();
+        const Mat34 P1 = pose1.matrix3x4();
+        auto triangulate = [&](const cv::Range &range) {
+            TriangulateRange(P0, P1, range.start, range.end,
+                             batch.x0.data(), batch.y0.data(), batch.x1.data(), batch.y1.data(),
+                             batch.px.data(), batch.py.data(), batch.pz.data(),
+                             batch.success.data());
+        };
+
+        if (n < kParallelTriangulationSize) {
+            triangulate(cv::Range(0, n));
+        } else {
+            cv::parallel_for_(cv::Range(0, n), triangulate, double(n) / kParallelTriangulationSize);
+        }
+
+        int cnt_success = 0;
+        for (int i = 0; i < n; ++i) {
+            cnt_success += batch.success[i];
+        }
+        return cnt_success;
+    }
+
+} // namespace myslam
@@ -0,0 +1,620 @@
+#include "myslam/ba_solver.h"
+
+#include <cmath>
+#include <fstream>
+#include <Eigen/Cholesky>
+#include <opencv2/core/utility.hpp>
+
+#include "myslam/g2o_types.h"
+
+namespace myslam {
+
+    namespace {
+
+        typedef std::vector<SE3, Eigen::aligned_allocator<SE3>> Poses;
+
+        // rho and its first derivative of the Huber kernel, as g2o::RobustKernelHuber
+        inline void Robustify(double e2, double delta, double &rho0, double &rho1) {
+            const double dsqr = delta * delta;
+            if (e2 <= dsqr) {
+                rho0 = e2;
+                rho1 = 1;
+            } else {
+                const double sqrte = std::sqrt(e2);
+                rho0 = 2 * sqrte * delta - dsqr;
+                rho1 = delta / sqrte;
+            }
+        }
+
+        // residual of observation o, same as EdgeProjection::computeError
+        inline Vec2 Residual(const BAProblem &problem, const SE3 &pose, const Vec3 &point, int o, Vec3 &pos_cam) {
+            pos_cam = problem.cam_ext[problem.obs_camera[o]] * (pose * point);
+            Vec3 pos_pixel = problem.K * pos_cam;
+            pos_pixel /= pos_pixel[2];
+            return problem.obs_pixel[o] - pos_pixel.head<2>();
+        }
+
+        // dx of the prior poses, stacked
+        VecX PriorDelta(const BAProblem &problem, const Poses &poses) {
+            VecX dx(6 * problem.prior_poses.size());
+            for (size_t i = 0; i < problem.prior_poses.size(); ++i) {
+                dx.segment<6>(6 * i) = (poses[problem.prior_poses[i]] *
+                                        problem.prior_linearization[i].inverse()).log();
+            }
+            return dx;
+        }
+
+        double Cost(const BAProblem &problem, const Poses &poses, const std::vector<Vec3> &points) {
+            double cost = 0;
+            Vec3 pos_cam;
+            for (size_t o = 0; o < problem.NumObservations(); ++o) {
+                Vec2 e = Residual(problem, poses[problem.obs_pose[o]], points[problem.obs_point[o]], o, pos_cam);
+                double rho0, rho1;
+                Robustify(e.squaredNorm(), problem.huber_delta, rho0, rho1);
+                cost += rho0;
+            }
+            if (!problem.prior_poses.empty()) {
+                cost += (problem.prior_r0 + problem.prior_J * PriorDelta(problem, poses)).squaredNorm();
+            }
+            return cost;
+        }
+
+        template <int N>
+        bool SolveFixed(const MatXX &S, const VecX &r, VecX &dx) {
+            typedef Eigen::Matrix<double, 6 * N, 6 * N> MatN;
+            typedef Eigen::Matrix<double, 6 * N, 1> VecN;
+            Eigen::LLT<MatN> llt{MatN(S)};
+            if (llt.info() != Eigen::Success) return false;
+            dx = llt.solve(VecN(r));
+            return true;
+        }
+
+        // fixed-size Cholesky for the usual window sizes
+        bool SolveReducedSystem(const MatXX &S, const VecX &r, VecX &dx) {
+            switch (S.rows() / 6) {
+                case 1: return SolveFixed<1>(S, r, dx);
+                case 2: return SolveFixed<2>(S, r, dx);
+                case 3: return SolveFixed<3>(S, r, dx);
+                case 4: return SolveFixed<4>(S, r, dx);
+                case 5: return SolveFixed<5>(S, r, dx);
+                case 6: return SolveFixed<6>(S, r, dx);
+                case 7: return SolveFixed<7>(S, r, dx);
+                case 8: return SolveFixed<8>(S, r, dx);
+                default: {
+                    Eigen::LLT<MatXX> llt(S);
+                    if (llt.info() != Eigen::Success) return false;
+                    dx = llt.solve(r);
+                    return true;
+                }
+            }
+        }
+
+        template <typename T>
+        void WriteValue(std::ofstream &out, const T &value) {
+            out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        void ReadValue(std::ifstream &in, T &value) {
+            in.read(reinterpret_cast<char *>(&value), sizeof(T));
+        }
+
+        void WritePose(std::ofstream &out, const SE3 &pose) {
+            WriteValue(out, pose.unit_quaternion().coeffs().eval());
+            WriteValue(out, pose.translation().eval());
+        }
+
+        void ReadPose(std::ifstream &in, SE3 &pose) {
+            Eigen::Vector4d q;
+            Vec3 t;
+            ReadValue(in, q);
+            ReadValue(in, t);
+            pose = SE3(Eigen::Quaterniond(q), t);
+        }
+
+        const char kMagic[8] = {'M', 'Y', 'S', 'L', 'A', 'M', 'B', 'A'};
+        const int kVersion = 1;
+
+    } // namespace
+
+    double BAProblem::Cost() const {
+        return myslam::Cost(*this, poses, points);
+    }
+
+    bool BAProblem::Save(const std::string &path) const {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) return false;
+        out.write(kMagic, sizeof(kMagic));
+        WriteValue(out, kVersion);
+        WriteValue(out, K);
+        WritePose(out, cam_ext[0]);
+        WritePose(out, cam_ext[1]);
+        WriteValue(out, huber_delta);
+
+        WriteValue(out, int(poses.size()));
+        for (auto &pose : poses) WritePose(out, pose);
+        WriteValue(out, int(points.size()));
+        for (size_t i = 0; i < points.size(); ++i) {
+            WriteValue(out, points[i]);
+            WriteValue(out, point_fixed[i]);
+        }
+        WriteValue(out, int(NumObservations()));
+        for (size_t o = 0; o < NumObservations(); ++o) {
+            WriteValue(out, obs_pose[o]);
+            WriteValue(out, obs_point[o]);
+            WriteValue(out, obs_camera[o]);
+            WriteValue(out, obs_pixel[o]);
+        }
+
+        WriteValue(out, int(prior_poses.size()));
+        WriteValue(out, int(prior_J.rows()));
+        for (size_t i = 0; i < prior_poses.size(); ++i) {
+            WriteValue(out, prior_poses[i]);
+            WritePose(out, prior_linearization[i]);
+        }
+        out.write(reinterpret_cast<const char *>(prior_J.data()), sizeof(double) * prior_J.size());
+        out.write(reinterpret_cast<const char *>(prior_r0.data()), sizeof(double) * prior_r0.size());
+        return bool(out);
+    }
+
+    bool BAProblem::Load(const std::string &path) {
+        std::ifstream in(path, std::ios::binary);
+        char magic[sizeof(kMagic)];
+        int version = 0;
+        in.read(magic, sizeof(magic));
+        ReadValue(in, version);
+        if (!in || !std::equal(magic, magic + sizeof(magic), kMagic) || version != kVersion) {
+            LOG(ERROR) << "invalid bundle adjustment problem " << path;
+            return false;
+        }
+        *this = BAProblem();
+        ReadValue(in, K);
+        ReadPose(in, cam_ext[0]);
+        ReadPose(in, cam_ext[1]);
+        ReadValue(in, huber_delta);
+
+        int n = 0;
+        ReadValue(in, n);
+        poses.resize(n);
+        for (auto &pose : poses) ReadPose(in, pose);
+        ReadValue(in, n);
+        points.resize(n);
+        point_fixed.resize(n);
+        for (int i = 0; i < n; ++i) {
+            ReadValue(in, points[i]);
+            ReadValue(in, point_fixed[i]);
+        }
+        ReadValue(in, n);
+        obs_pose.resize(n);
+        obs_point.resize(n);
+        obs_camera.resize(n);
+        obs_pixel.resize(n);
+        for (int o = 0; o < n; ++o) {
+            ReadValue(in, obs_pose[o]);
+            ReadValue(in, obs_point[o]);
+            ReadValue(in, obs_camera[o]);
+            ReadValue(in, obs_pixel[o]);
+        }
+
+        int rows = 0;
+        ReadValue(in, n);
+        ReadValue(in, rows);
+        prior_poses.resize(n);
+        prior_linearization.resize(n);
+        for (int i = 0; i < n; ++i) {
+            ReadValue(in, prior_poses[i]);
+            ReadPose(in, prior_linearization[i]);
+        }
+        prior_J.resize(rows, 6 * n);
+        prior_r0.resize(rows);
+        in.read(reinterpret_cast<char *>(prior_J.data()), sizeof(double) * prior_J.size());
+        in.read(reinterpret_cast<char *>(prior_r0.data()), sizeof(double) * prior_r0.size());
+        if (!in) {
+            LOG(ERROR) << "truncated bundle adjustment problem " << path;
+            return false;
+        }
+        return true;
+    }
+
+    double G2OBASolver::Solve(BAProblem &problem, int iterations) {
+        // setup g2o
+        typedef g2o::BlockSolver_6_3 BlockSolverType;
+        typedef g2o::LinearSolverCSparse<BlockSolverType::PoseMatrixType> LinearSolverType;
+        auto solver = new g2o::OptimizationAlgorithmLevenberg(
+                g2o::make_unique<BlockSolverType>(
+                        g2o::make_unique<LinearSolverType>()));
+        g2o::SparseOptimizer optimizer;
+        optimizer.setAlgorithm(solver);
+
+        std::vector<VertexPose *> pose_vertices;
+        for (size_t i = 0; i < problem.poses.size(); ++i) {
+            VertexPose *v = new VertexPose();
+            v->setId(2 * i);
+            v->setEstimate(problem.poses[i]);
+            optimizer.addVertex(v);
+            pose_vertices.push_back(v);
+        }
+        std::vector<VertexXYZ *> point_vertices;
+        for (size_t i = 0; i < problem.points.size(); ++i) {
+            VertexXYZ *v = new VertexXYZ();
+            v->setId(2 * i + 1);
+            v->setEstimate(problem.points[i]);
+            v->setMarginalized(true);
+            v->setFixed(problem.point_fixed[i]);
+            optimizer.addVertex(v);
+            point_vertices.push_back(v);
+        }
+        for (size_t o = 0; o < problem.NumObservations(); ++o) {
+            EdgeProjection *edge = new EdgeProjection(problem.K, problem.cam_ext[problem.obs_camera[o]]);
+            edge->setId(o);
+            edge->setVertex(0, pose_vertices[problem.obs_pose[o]]);
+            edge->setVertex(1, point_vertices[problem.obs_point[o]]);
+            edge->setMeasurement(problem.obs_pixel[o]);
+            edge->setInformation(Mat22::Identity());
+            auto rk = new g2o::RobustKernelHuber();
+            rk->setDelta(problem.huber_delta);
+            edge->setRobustKernel(rk);
+            optimizer.addEdge(edge);
+        }
+        if (!problem.prior_poses.empty()) {
+            auto prior = new EdgeMarginalPrior(problem.prior_linearization, problem.prior_J, problem.prior_r0);
+            for (size_t i = 0; i < problem.prior_poses.size(); ++i) {
+                prior->setVertex(i, pose_vertices[problem.prior_poses[i]]);
+            }
+            prior->setId(problem.NumObservations());
+            optimizer.addEdge(prior);
+        }
+
+        optimizer.initializeOptimization();
+        optimizer.optimize(iterations);
+
+        for (size_t i = 0; i < problem.poses.size(); ++i) {
+            problem.poses[i] = pose_vertices[i]->estimate();
+        }
+        for (size_t i = 0; i < problem.points.size(); ++i) {
+            problem.points[i] = point_vertices[i]->estimate();
+        }
+        return problem.Cost();
+    }
+
+    /**
+     * @details residuals, Huber costs and weights, and optionally the jacobians of EdgeProjection,
+     * @details of n observations sharing the transform R, t from the world to the camera.
+     * @details A branch-free loop over the arrays, vectorized by the compiler
+     * @param jac 18 arrays, d e_u / d pose, d e_v / d pose, d e_u / d point, d e_v / d point; null for the cost only
+     */
+    static void EvaluateBatch(const Mat33 &K, const Mat33 &R, const Vec3 &t, double delta, int n,
+                              const double *x, const double *y, const double *z,
+                              const double *u, const double *v,
+                              double *eu, double *ev, double *rho, double *w, double *const *jac) {
+        const double fx = K(0, 0), fy = K(1, 1), cx = K(0, 2), cy = K(1, 2);
+        const double r00 = R(0, 0), r01 = R(0, 1), r02 = R(0, 2);
+        const double r10 = R(1, 0), r11 = R(1, 1), r12 = R(1, 2);
+        const double r20 = R(2, 0), r21 = R(2, 1), r22 = R(2, 2);
+        const double t0 = t[0], t1 = t[1], t2 = t[2];
+        const double dsqr = delta * delta;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC ivdep
+#endif
+        for (int i = 0; i < n; ++i) {
+            const double X = r00 * x[i] + r01 * y[i] + r02 * z[i] + t0;
+            const double Y = r10 * x[i] + r11 * y[i] + r12 * z[i] + t1;
+            const double Z = r20 * x[i] + r21 * y[i] + r22 * z[i] + t2;
+            const double Zinv = 1.0 / (Z + 1e-18);
+            const double du = u[i] - (fx * X * Zinv + cx);
+            const double dv = v[i] - (fy * Y * Zinv + cy);
+            const double e2 = du * du + dv * dv;
+            const double sqrte = std::sqrt(e2);
+            const bool inlier = e2 <= dsqr;
+            eu[i] = du;
+            ev[i] = dv;
+            rho[i] = inlier ? e2 : 2 * sqrte * delta - dsqr;
+            w[i] = inlier ? 1.0 : delta / sqrte;
+        }
+        if (!jac) return;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC ivdep
+#endif
+        for (int i = 0; i < n; ++i) {
+            const double X = r00 * x[i] + r01 * y[i] + r02 * z[i] + t0;
+            const double Y = r10 * x[i] + r11 * y[i] + r12 * z[i] + t1;
+            const double Z = r20 * x[i] + r21 * y[i] + r22 * z[i] + t2;
+            const double Zinv = 1.0 / (Z + 1e-18);
+            const double Zinv2 = Zinv * Zinv;
+            const double ju0 = -fx * Zinv, ju2 = fx * X * Zinv2;
+            const double jv1 = -fy * Zinv, jv2 = fy * Y * Zinv2;
+            jac[0][i] = ju0;
+            jac[1][i] = 0;
+            jac[2][i] = ju2;
+            jac[3][i] = fx * X * Y * Zinv2;
+            jac[4][i] = -fx - fx * X * X * Zinv2;
+            jac[5][i] = fx * Y * Zinv;
+            jac[6][i] = 0;
+            jac[7][i] = jv1;
+            jac[8][i] = jv2;
+            jac[9][i] = fy + fy * Y * Y * Zinv2;
+            jac[10][i] = -fy * X * Y * Zinv2;
+            jac[11][i] = -fy * X * Zinv;
+            // d e / d point = (d e / d pose).leftCols(3) * R
+            jac[12][i] = ju0 * r00 + ju2 * r20;
+            jac[13][i] = ju0 * r01 + ju2 * r21;
+            jac[14][i] = ju0 * r02 + ju2 * r22;
+            jac[15][i] = jv1 * r10 + jv2 * r20;
+            jac[16][i] = jv1 * r11 + jv2 * r21;
+            jac[17][i] = jv1 * r12 + jv2 * r22;
+        }
+    }
+
+    void SchurBASolver::Setup(const BAProblem &problem) {
+        num_poses_ = problem.poses.size();
+        num_points_ = problem.points.size();
+        const int num_obs = problem.NumObservations();
+
+        // counting sort of the observations by point
+        point_begin_.assign(num_points_ + 1, 0);
+        for (int o = 0; o < num_obs; ++o) point_begin_[problem.obs_point[o] + 1]++;
+        for (int i = 0; i < num_points_; ++i) point_begin_[i + 1] += point_begin_[i];
+        order_.resize(num_obs);
+        std::vector<int> next(point_begin_.begin(), point_begin_.end() - 1);
+        for (int o = 0; o < num_obs; ++o) order_[next[problem.obs_point[o]]++] = o;
+
+        // counting sort of the observations by keyframe and camera, cut into batches
+        const int num_groups = 2 * num_poses_;
+        std::vector<int> group_begin(num_groups + 1, 0);
+        for (int o = 0; o < num_obs; ++o) group_begin[2 * problem.obs_pose[o] + problem.obs_camera[o] + 1]++;
+        for (int g = 0; g < num_groups; ++g) group_begin[g + 1] += group_begin[g];
+        slot_order_.resize(num_obs);
+        std::vector<int> obs_slot(num_obs);
+        next.assign(group_begin.begin(), group_begin.end() - 1);
+        for (int o = 0; o < num_obs; ++o) {
+            int slot = next[2 * problem.obs_pose[o] + problem.obs_camera[o]]++;
+            slot_order_[slot] = o;
+            obs_slot[o] = slot;
+        }
+        batches_.clear();
+        for (int g = 0; g < num_groups; ++g) {
+            for (int begin = group_begin[g]; begin < group_begin[g + 1]; begin += kBatchSize) {
+                batches_.push_back({g / 2, g % 2, begin, std::min(begin + kBatchSize, group_begin[g + 1])});
+            }
+        }
+        point_slot_.resize(num_obs);
+        for (int k = 0; k < num_obs; ++k) point_slot_[k] = obs_slot[order_[k]];
+
+        for (auto *array : {&x_, &y_, &z_, &u_, &v_, &eu_, &ev_, &rho_, &w_}) array->resize(num_obs);
+        for (auto &array : jac_) array.resize(num_obs);
+        for (int s = 0; s < num_obs; ++s) {
+            u_[s] = problem.obs_pixel[slot_order_[s]][0];
+            v_[s] = problem.obs_pixel[slot_order_[s]][1];
+        }
+        batch_H_.resize(batches_.size());
+        batch_b_.resize(batches_.size());
+        batch_cost_.resize(batches_.size());
+
+        Hpl_.resize(num_obs);
+        Hll_.resize(num_points_);
+        Hll_inv_.resize(num_points_);
+        bl_.resize(num_points_);
+        dx_points_.resize(num_points_);
+    }
+
+    double SchurBASolver::Evaluate(const BAProblem &problem, const Poses &poses,
+                                   const std::vector<Vec3> &points, bool jacobians) {
+        double *jac[18];
+        for (int j = 0; j < 18; ++j) jac[j] = jac_[j].data();
+
+        cv::parallel_for_(cv::Range(0, batches_.size()), [&](const cv::Range &range) {
+            for (int bi = range.start; bi < range.end; ++bi) {
+                const Batch &batch = batches_[bi];
+                for (int s = batch.begin; s < batch.end; ++s) {
+                    const Vec3 &point = points[problem.obs_point[slot_order_[s]]];
+                    x_[s] = point[0];
+                    y_[s] = point[1];
+                    z_[s] = point[2];
+                }
+                const SE3 T = problem.cam_ext[batch.camera] * poses[batch.pose];
+                double *batch_jac[18];
+                for (int j = 0; j < 18; ++j) batch_jac[j] = jac[j] + batch.begin;
+                const int b = batch.begin, n = batch.end - batch.begin;
+                EvaluateBatch(problem.K, T.rotationMatrix(), T.translation(), problem.huber_delta, n,
+                              &x_[b], &y_[b], &z_[b], &u_[b], &v_[b], &eu_[b], &ev_[b], &rho_[b], &w_[b],
+                              jacobians ? batch_jac : nullptr);
+
+                double cost = 0;
+                for (int s = b; s < batch.end; ++s) cost += rho_[s];
+                batch_cost_[bi] = cost;
+                if (!jacobians) continue;
+
+                // pose block of the batch
+                Mat66 &H = batch_H_[bi];
+                Vec6 &g = batch_b_[bi];
+                H.setZero();
+                g.setZero();
+                Mat26 Jp;
+                for (int s = b; s < batch.end; ++s) {
+                    for (int j = 0; j < 6; ++j) {
+                        Jp(0, j) = jac[j][s];
+                        Jp(1, j) = jac[6 + j][s];
+                    }
+                    H.noalias() += w_[s] * Jp.transpose() * Jp;
+                    g.noalias() -= w_[s] * Jp.transpose() * Vec2(eu_[s], ev_[s]);
+                }
+            }
+        });
+
+        // reduction in batch order, independent of the threads
+        double cost = 0;
+        for (size_t bi = 0; bi < batches_.size(); ++bi) {
+            cost += batch_cost_[bi];
+            if (!jacobians) continue;
+            const int p = batches_[bi].pose;
+            Hpp_.block<6, 6>(6 * p, 6 * p) += batch_H_[bi];
+            bp_.segment<6>(6 * p) += batch_b_[bi];
+        }
+        if (!problem.prior_poses.empty()) {
+            cost += (problem.prior_r0 + problem.prior_J * PriorDelta(problem, poses)).squaredNorm();
+        }
+        return cost;
+    }
+
+    double SchurBASolver::Linearize(const BAProblem &problem) {
+        Hpp_.setZero(6 * num_poses_, 6 * num_poses_);
+        bp_.setZero(6 * num_poses_);
+        const double cost = Evaluate(problem, problem.poses, problem.points, true);
+
+        // point blocks, each point by one thread
+        cv::parallel_for_(cv::Range(0, num_points_), [&](const cv::Range &range) {
+            Mat26 Jp;
+            Mat23 Jl;
+            for (int i = range.start; i < range.end; ++i) {
+                Hll_[i].setZero();
+                bl_[i].setZero();
+                if (problem.point_fixed[i]) continue;
+                for (int k = point_begin_[i]; k < point_begin_[i + 1]; ++k) {
+                    const int s = point_slot_[k];
+                    for (int j = 0; j < 6; ++j) {
+                        Jp(0, j) = jac_[j][s];
+                        Jp(1, j) = jac_[6 + j][s];
+                    }
+                    for (int j = 0; j < 3; ++j) {
+                        Jl(0, j) = jac_[12 + j][s];
+                        Jl(1, j) = jac_[15 + j][s];
+                    }
+                    const Vec2 e(eu_[s], ev_[s]);
+                    Hll_[i].noalias() += w_[s] * Jl.transpose() * Jl;
+                    bl_[i].noalias() -= w_[s] * Jl.transpose() * e;
+                    Hpl_[k].noalias() = w_[s] * Jp.transpose() * Jl;
+                }
+            }
+        });
+
+        // prior, with its first estimate jacobian
+        if (!problem.prior_poses.empty()) {
+            VecX r = problem.prior_r0 + problem.prior_J * PriorDelta(problem, problem.poses);
+            for (size_t a = 0; a < problem.prior_poses.size(); ++a) {
+                const int p = problem.prior_poses[a];
+                bp_.segment<6>(6 * p).noalias() -= problem.prior_J.middleCols<6>(6 * a).transpose() * r;
+                for (size_t b = 0; b < problem.prior_poses.size(); ++b) {
+                    const int q = problem.prior_poses[b];
+                    Hpp_.block<6, 6>(6 * p, 6 * q).noalias() +=
+                            problem.prior_J.middleCols<6>(6 * a).transpose() * problem.prior_J.middleCols<6>(6 * b);
+                }
+            }
+        }
+        return cost;
+    }
+
+    bool SchurBASolver::SolveDamped(const BAProblem &problem, double lambda) {
+        const int dim = 6 * num_poses_;
+        // fixed chunks, independent of the num of threads, so the sum is deterministic
+        const int num_chunks = std::max(1, std::min(16, num_points_ / 128));
+        std::vector<MatXX> S_chunks(num_chunks, MatXX::Zero(dim, dim));
+        std::vector<VecX> r_chunks(num_chunks, VecX::Zero(dim));
+
+        // eliminate the points
+        cv::parallel_for_(cv::Range(0, num_chunks), [&](const cv::Range &range) {
+            for (int c = range.start; c < range.end; ++c) {
+                MatXX &S = S_chunks[c];
+                VecX &r = r_chunks[c];
+                const int begin = num_points_ * c / num_chunks, end = num_points_ * (c + 1) / num_chunks;
+                for (int i = begin; i < end; ++i) {
+                    if (problem.point_fixed[i]) continue;
+                    Mat33 H = Hll_[i];
+                    H.diagonal().array() += lambda;
+                    Hll_inv_[i] = H.inverse();
+                    for (int a = point_begin_[i]; a < point_begin_[i + 1]; ++a) {
+                        const int pa = problem.obs_pose[order_[a]];
+                        Mat63 T = Hpl_[a] * Hll_inv_[i];
+                        r.segment<6>(6 * pa).noalias() -= T * bl_[i];
+                        for (int b = point_begin_[i]; b < point_begin_[i + 1]; ++b) {
+                            const int pb = problem.obs_pose[order_[b]];
+                            S.block<6, 6>(6 * pa, 6 * pb).noalias() -= T * Hpl_[b].transpose();
+                        }
+                    }
+                }
+            }
+        });
+
+        MatXX S = Hpp_;
+        S.diagonal().array() += lambda;
+        VecX r = bp_;
+        for (int c = 0; c < num_chunks; ++c) {
+            S += S_chunks[c];
+            r += r_chunks[c];
+        }
+        if (!SolveReducedSystem(S, r, dx_poses_) || !dx_poses_.allFinite()) return false;
+
+        // back substitution of the points
+        cv::parallel_for_(cv::Range(0, num_points_), [&](const cv::Range &range) {
+            for (int i = range.start; i < range.end; ++i) {
+                if (problem.point_fixed[i]) {
+                    dx_points_[i].setZero();
+                    continue;
+                }
+                Vec3 rhs = bl_[i];
+                for (int a = point_begin_[i]; a < point_begin_[i + 1]; ++a) {
+                    const int pa = problem.obs_pose[order_[a]];
+                    rhs.noalias() -= Hpl_[a].transpose() * dx_poses_.segment<6>(6 * pa);
+                }
+                dx_points_[i] = Hll_inv_[i] * rhs;
+            }
+        });
+        return true;
+    }
+
+    double SchurBASolver::Solve(BAProblem &problem, int iterations) {
+        Setup(problem);
+        Poses new_poses(num_poses_);
+        std::vector<Vec3> new_points(num_points_);
+
+        double lambda = -1; // set in the first iteration
+        double ni = 2;
+        double cost = 0;
+        for (int iteration = 0; iteration < iterations; ++iteration) {
+            cost = Linearize(problem);
+            if (lambda < 0) {
+                // same initial damping as g2o::OptimizationAlgorithmLevenberg
+                double max_diag = Hpp_.size() ? Hpp_.diagonal().maxCoeff() : 0;
+                for (int i = 0; i < num_points_; ++i) {
+                    if (!problem.point_fixed[i]) max_diag = std::max(max_diag, Hll_[i].diagonal().maxCoeff());
+                }
+                lambda = 1e-5 * max_diag;
+            }
+
+            // try damping factors until the cost decreases
+            bool accepted = false;
+            for (int trial = 0; trial < 10 && !accepted; ++trial) {
+                if (!SolveDamped(problem, lambda)) {
+                    lambda *= ni;
+                    ni *= 2;
+                    continue;
+                }
+
+                double scale = dx_poses_.dot(lambda * dx_poses_ + bp_) + 1e-3;
+                for (int i = 0; i < num_poses_; ++i) {
+                    new_poses[i] = SE3::exp(dx_poses_.segment<6>(6 * i)) * problem.poses[i];
+                }
+                for (int i = 0; i < num_points_; ++i) {
+                    new_points[i] = problem.points[i] + dx_points_[i];
+                    scale += dx_points_[i].dot(lambda * dx_points_[i] + bl_[i]);
+                }
+                double new_cost = Evaluate(problem, new_poses, new_points, false);
+                double rho = (cost - new_cost) / scale;
+                if (rho > 0 && std::isfinite(new_cost)) {
+                    problem.poses.swap(new_poses);
+                    problem.points.swap(new_points);
+                    cost = new_cost;
+                    double alpha = 1 - std::pow(2 * rho - 1, 3);
+                    lambda *= std::max(1.0 / 3.0, std::min(alpha, 2.0 / 3.0));
+                    ni = 2;
+                    accepted = true;
+                } else {
+                    lambda *= ni;
+                    ni *= 2;
+                }
+            }
+            if (!accepted) break; // converged, or no decrease possible
+        }
+        return cost;
+    }
+
+} // namespace myslam
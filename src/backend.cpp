@@ -1,142 +1,650 @@
+#include <chrono>
+#include <cstdio>
+#include <Eigen/Eigenvalues>
+
 #include "myslam/backend.h"
 #include "myslam/algorithm.h"
 #include "myslam/feature.h"
 #include "myslam/g2o_types.h"
 #include "myslam/map.h"
 #include "myslam/mappoint.h"
+#include "myslam/profiler.h"
 
 namespace myslam {
 
     Backend::Backend() {
+        // setup g2o, the graph is kept for the lifetime of the backend
+        typedef g2o::BlockSolver_6_3 BlockSolverType;
+        typedef g2o::LinearSolverCSparse<BlockSolverType::PoseMatrixType> LinearSolverType;
+        auto solver = new g2o::OptimizationAlgorithmLevenberg(
+                g2o::make_unique<BlockSolverType>(
+                        g2o::make_unique<LinearSolverType>()));
+        optimizer_.setAlgorithm(solver);
+
         backend_running_.store(true);
         backend_thread_ = std::thread(std::bind(&Backend::BackendLoop, this));
     }
 
-    void Backend::UpdateMap() {
+    unsigned long Backend::UpdateMap() {
         std::unique_lock<std::mutex> lock(data_mutex_);
+        const unsigned long generation = ++requested_generation_;
+        if (!request_pending_) {
+            request_pending_ = true;
+            pending_since_ = std::chrono::steady_clock::now();
+        }
+        queue_stats_.requests++;
+        queue_stats_.max_depth = std::max(queue_stats_.max_depth, generation - completed_generation_);
         map_update_.notify_one();
-        /**
-         * public member function
-         * std::condition_variable::notify_one
-         * void notify_one() noexcept;
-         *
-         * Notify one
-         * Unblocks one of the threads currently waiting for this condition.
-         * If no threads are waiting, the function does nothing.
-         * If more than one, it is unspecified which of the threads is selected.
-         */
+        return generation;
+    }
+
+    bool Backend::WaitForGeneration(unsigned long generation, std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(data_mutex_);
+        return generation_done_.wait_for(lock, timeout, [&] {
+            return completed_generation_ >= generation || !backend_running_.load();
+        }) && completed_generation_ >= generation;
     }
 
     void Backend::Stop() {
-        backend_running_.store(false);
+        {
+            std::unique_lock<std::mutex> lock(data_mutex_);
+            backend_running_.store(false);
+        }
         map_update_.notify_one();
+        generation_done_.notify_all();
         backend_thread_.join();
+
+        queue_stats_.dropped = requested_generation_ - completed_generation_;
+        LOG(INFO) << "Backend requests: " << queue_stats_.requests << ", optimizations "
+                  << queue_stats_.optimizations << ", coalesced " << queue_stats_.coalesced
+                  << ", dropped " << queue_stats_.dropped << ", max depth " << queue_stats_.max_depth;
+        if (timing_.updates > 0) {
+            LOG(INFO) << "Backend average over " << timing_.updates << " updates: graph "
+                      << timing_.graph / timing_.updates << " ms, optimization "
+                      << timing_.optimization / timing_.updates << " ms";
+        }
+        if (timing_.marginalizations > 0) {
+            LOG(INFO) << "Backend average over " << timing_.marginalizations << " marginalizations: "
+                      << timing_.marginalization / timing_.marginalizations << " ms";
+        }
     }
 
     void Backend::BackendLoop() {
-        while (backend_running_.load()) {
-            std::unique_lock<std::mutex> lock(data_mutex_);
-            map_update_.wait(lock);
+        while (true) {
+            // all the pending requests are served by one optimization of the latest window
+            unsigned long generation;
+            {
+                std::unique_lock<std::mutex> lock(data_mutex_);
+                map_update_.wait(lock, [&] {
+                    return !backend_running_.load() || requested_generation_ > completed_generation_;
+                });
+                if (!backend_running_.load()) break;
+                generation = requested_generation_;
+                queue_stats_.coalesced += generation - completed_generation_ - 1;
+                request_pending_ = false;
+                Profiler::Instance().RecordCounter(
+                        "backend.queue_wait_ms",
+                        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pending_since_).count());
+            }
 
             // In the backend, only the activated frames and landmarks are optimized
-            Map::KeyframesType active_kfs = map_->GetActiveKeyFrames();
-            Map::LandmarksType active_landmarks = map_->GetActiveMapPoints();
-            Optimize(active_kfs, active_landmarks);
+            Map::KeyframesSnapshot active_kfs = map_->GetActiveKeyFrames();
+            Map::LandmarksSnapshot active_landmarks = map_->GetActiveMapPoints();
+            Optimize(*active_kfs, *active_landmarks);
+
+            {
+                std::unique_lock<std::mutex> lock(data_mutex_);
+                completed_generation_ = generation;
+                queue_stats_.optimizations++;
+                prior_dimension_ = prior_ ? prior_->dimension() : 0;
+            }
+            generation_done_.notify_all();
         }
     }
 
-    /**
-     * @details optimize the MapPoints/landmarks and camera pose
-     * @details it will be activated after map_update_ wait for the notification
-     * @details map_update_.wait(lock) in the Backend::Backend()->void Backend::BackendLoop()
-     * @param keyframes
-     * @param landmarks
-     */
-    void Backend::Optimize(Map::KeyframesType &keyframes, Map::LandmarksType &landmarks) {
-        // setup g2o
-        typedef g2o::BlockSolver_6_3 BlockSolverType;
-        typedef g2o::LinearSolverCSparse<BlockSolverType::PoseMatrixType> LinearSolverType;
-        auto solver = new g2o::OptimizationAlgorithmLevenberg(
-                g2o::make_unique<BlockSolverType>(
-                        g2o::make_unique<LinearSolverType>()));
-        g2o::SparseOptimizer optimizer;
-        optimizer.setAlgorithm(solver);
+    // vertex ids, even for keyframes and odd for landmarks
+    static int PoseVertexId(unsigned long keyframe_id) { return 2 * keyframe_id; }
 
-        // pose vertex, use keyframe id
-        std::map<unsigned long, VertexPose *> vertices;
-        unsigned long max_kf_id = 0;
-        for (auto &keyframe : keyframes) {
-            auto kf = keyframe.second;
-            VertexPose *vertex_pose = new VertexPose();
-            vertex_pose->setId(kf->keyframe_id_);
-            vertex_pose->setEstimate(kf->Pose());
-            optimizer.addVertex(vertex_pose);
-            if (kf->keyframe_id_ > max_kf_id) {
-                max_kf_id = kf->keyframe_id_;
-            }
+    static int LandmarkVertexId(unsigned long landmark_id) { return 2 * landmark_id + 1; }
 
-            vertices.insert({kf->keyframe_id_, vertex_pose});
-        }
+    bool Backend::UpdateGraph(const Map::KeyframesType &keyframes, const Map::LandmarksType &landmarks) {
+        ScopedTimer timer("backend.update_graph");
+        const unsigned long generation = ++graph_generation_;
+        int poses_added = 0, landmarks_added = 0, edges_added = 0;
 
-        // landmark vertex, use landmark id
-        std::map<unsigned long, VertexXYZ *> vertices_landmarks;
+        // keyframes leaving the window, marginalized while their edges are still in the graph
+        bool marginalized = false;
+        if (marginalization_) {
+            std::vector<unsigned long> leaving;
+            for (auto &pose : graph_poses_) {
+                if (keyframes.find(pose.first) == keyframes.end()) leaving.push_back(pose.first);
+            }
+            if (!leaving.empty()) {
+                auto t1 = std::chrono::steady_clock::now();
+                Marginalize(leaving);
+                auto t2 = std::chrono::steady_clock::now();
+                timing_.marginalization += std::chrono::duration<double, std::milli>(t2 - t1).count();
+                timing_.marginalizations++;
+                marginalized = true;
+            }
+            // forget the landmarks and features which are gone
+            for (auto iter = retired_landmarks_.begin(); iter != retired_landmarks_.end();) {
+                iter = landmarks.count(*iter) ? std::next(iter) : retired_landmarks_.erase(iter);
+            }
+            for (auto iter = absorbed_edges_.begin(); iter != absorbed_edges_.end();) {
+                iter = iter->second.expired() ? absorbed_edges_.erase(iter) : std::next(iter);
+            }
+        }
 
         // K, and left and right extrinsics
         Mat33 K = cam_left_->K();
         SE3 left_ext = cam_left_->pose();
         SE3 right_ext = cam_right_->pose();
-
-        // edges
-        int index = 1;
         double chi2_th = 5.991; // robust kernel threshold
-        std::map<EdgeProjection *, Feature::Ptr> edges_and_features;
 
+        // pose vertex, use keyframe id
+        for (auto &keyframe : keyframes) {
+            auto kf = keyframe.second;
+            auto iter = graph_poses_.find(kf->keyframe_id_);
+            if (iter != graph_poses_.end()) {
+                iter->second.generation = generation;
+                continue;
+            }
+            VertexPose *vertex_pose = new VertexPose();
+            vertex_pose->setId(PoseVertexId(kf->keyframe_id_));
+            vertex_pose->setEstimate(kf->Pose());
+            optimizer_.addVertex(vertex_pose);
+            graph_poses_.insert({kf->keyframe_id_, {vertex_pose, generation}});
+            poses_added++;
+        }
+
+        // landmark vertices and edges of the observations
         for (auto &landmark : landmarks) {
             if (landmark.second->is_outlier_) continue;
             unsigned long landmark_id = landmark.second->id_;
-            auto observations = landmark.second->GetObs();
-            for (auto &obs : observations) {
-                if (obs.lock() == nullptr) continue;
-                auto feat = obs.lock();
-                if (feat->is_outlier_ || feat->frame_.lock() == nullptr) continue;
-
+            landmark.second->ForEachObservation([&](const std::shared_ptr<Feature> &feat) {
                 auto frame = feat->frame_.lock();
-                EdgeProjection *edge = nullptr;
-                if (feat->is_on_left_image_) {
-                    edge = new EdgeProjection(K, left_ext);
-                } else {
-                    edge = new EdgeProjection(K, right_ext);
-                }
+                if (feat->is_outlier_ || frame == nullptr) return;
+                auto pose_iter = graph_poses_.find(frame->keyframe_id_);
+                if (pose_iter == graph_poses_.end() || pose_iter->second.generation != generation) return;
 
                 // if this landmark is not inserted, insert a new vertex
-                if (vertices_landmarks.find(landmark_id) == vertices_landmarks.end()) {
+                auto landmark_iter = graph_landmarks_.find(landmark_id);
+                if (landmark_iter == graph_landmarks_.end()) {
                     VertexXYZ *v = new VertexXYZ;
                     v->setEstimate(landmark.second->Pos());
-                    v->setId(landmark_id + max_kf_id + 1);
+                    v->setId(LandmarkVertexId(landmark_id));
                     v->setMarginalized(true);
-                    vertices_landmarks.insert({landmark_id, v});
-                    optimizer.addVertex(v);
+                    v->setFixed(retired_landmarks_.count(landmark_id) > 0);
+                    optimizer_.addVertex(v);
+                    landmark_iter = graph_landmarks_.insert({landmark_id, {v, generation}}).first;
+                    landmarks_added++;
+                }
+                landmark_iter->second.generation = generation;
+
+                // the observation is already in the prior
+                auto absorbed_iter = absorbed_edges_.find(feat.get());
+                if (absorbed_iter != absorbed_edges_.end()) {
+                    if (absorbed_iter->second.lock() == feat) return;
+                    absorbed_edges_.erase(absorbed_iter);
+                }
+
+                auto edge_iter = graph_edges_.find(feat.get());
+                if (edge_iter != graph_edges_.end()) {
+                    if (edge_iter->second.feature.lock() == feat) {
+                        edge_iter->second.generation = generation;
+                        return;
+                    }
+                    // the feature of this edge was released and its address reused
+                    optimizer_.removeEdge(edge_iter->second.edge);
+                    graph_edges_.erase(edge_iter);
                 }
 
-                edge->setId(index);
-                edge->setVertex(0, vertices.at(frame->keyframe_id_));       // pose
-                edge->setVertex(1, vertices_landmarks.at(landmark_id));     // landmark
+                EdgeProjection *edge = nullptr;
+                if (feat->is_on_left_image_) {
+                    edge = new EdgeProjection(K, left_ext);
+                } else {
+                    edge = new EdgeProjection(K, right_ext);
+                }
+                edge->setId(next_edge_id_++);
+                edge->setVertex(0, pose_iter->second.vertex);       // pose
+                edge->setVertex(1, landmark_iter->second.vertex);   // landmark
                 edge->setMeasurement(toVec2(feat->position_.pt));
                 edge->setInformation(Mat22::Identity());
                 auto rk = new g2o::RobustKernelHuber();
                 rk->setDelta(chi2_th);
                 edge->setRobustKernel(rk);
-                edges_and_features.insert({edge, feat});
+                optimizer_.addEdge(edge);
+                graph_edges_.insert({feat.get(), {edge, feat, feat->is_on_left_image_ ? 0 : 1, generation}});
+                edges_added++;
+            });
+        }
 
-                optimizer.addEdge(edge);
+        // remove what is not in the window anymore, the landmarks of the prior first, then the edges
+        RemovePriorLandmarks(generation);
+        int poses_removed = 0, landmarks_removed = 0, edges_removed = 0;
+        for (auto iter = graph_edges_.begin(); iter != graph_edges_.end();) {
+            if (iter->second.generation == generation) {
+                ++iter;
+                continue;
+            }
+            optimizer_.removeEdge(iter->second.edge);
+            iter = graph_edges_.erase(iter);
+            edges_removed++;
+        }
+        for (auto iter = graph_landmarks_.begin(); iter != graph_landmarks_.end();) {
+            if (iter->second.generation == generation) {
+                ++iter;
+                continue;
+            }
+            optimizer_.removeVertex(iter->second.vertex);
+            iter = graph_landmarks_.erase(iter);
+            landmarks_removed++;
+        }
+        for (auto iter = graph_poses_.begin(); iter != graph_poses_.end();) {
+            if (iter->second.generation == generation) {
+                ++iter;
+                continue;
+            }
+            optimizer_.removeVertex(iter->second.vertex);
+            iter = graph_poses_.erase(iter);
+            poses_removed++;
+        }
+
+        LOG(INFO) << "Backend graph: +" << poses_added << "/-" << poses_removed << " keyframes, +"
+                  << landmarks_added << "/-" << landmarks_removed << " landmarks, +"
+                  << edges_added << "/-" << edges_removed << " edges";
+        return marginalized || poses_added + poses_removed + landmarks_added + landmarks_removed +
+                               edges_added + edges_removed > 0;
+    }
 
-                index++;
+    void Backend::Marginalize(const std::vector<unsigned long> &keyframe_ids) {
+        ScopedTimer timer("backend.marginalize");
+        std::unordered_set<VertexPose *> marginalized_poses;
+        for (auto id : keyframe_ids) {
+            marginalized_poses.insert(graph_poses_.at(id).vertex);
+        }
+
+        // landmarks of the marginalized poses, inlier edges counted: exclusive if observed by them only,
+        // shared if a kept pose observes them too
+        auto is_inlier = [](const GraphEdge &ge) {
+            auto feat = ge.feature.lock();
+            return feat && !feat->is_outlier_;
+        };
+        std::unordered_set<VertexXYZ *> landmarks, kept_observed, shared_landmarks;
+        for (auto &ge : graph_edges_) {
+            if (!is_inlier(ge.second)) continue;
+            auto v0 = static_cast<VertexPose *>(ge.second.edge->vertex(0));
+            auto v1 = static_cast<VertexXYZ *>(ge.second.edge->vertex(1));
+            if (v1->fixed()) continue;
+            (marginalized_poses.count(v0) ? landmarks : kept_observed).insert(v1);
+        }
+        for (auto iter = landmarks.begin(); iter != landmarks.end();) {
+            if (kept_observed.count(*iter)) {
+                shared_landmarks.insert(*iter);
+                iter = landmarks.erase(iter);
+            } else {
+                ++iter;
             }
         }
 
+        // absorbed edges: the inlier edges of the marginalized poses, the outliers are dropped with the poses
+        std::vector<std::unordered_map<Feature *, GraphEdge>::iterator> absorbed;
+        for (auto iter = graph_edges_.begin(); iter != graph_edges_.end(); ++iter) {
+            auto v0 = static_cast<VertexPose *>(iter->second.edge->vertex(0));
+            if (marginalized_poses.count(v0) && is_inlier(iter->second)) absorbed.push_back(iter);
+        }
+
+        // dense variables, by offset: the kept ones first, the vertices of the old prior which stay and the shared
+        // landmarks, then the marginalized ones, the poses and the exclusive landmarks of the old prior;
+        // the other exclusive landmarks are eliminated first, by 3x3 blocks
+        std::unordered_set<g2o::HyperGraph::Vertex *> marginalized(marginalized_poses.begin(), marginalized_poses.end());
+        marginalized.insert(landmarks.begin(), landmarks.end());
+        std::unordered_map<g2o::HyperGraph::Vertex *, int> offset;
+        std::vector<g2o::OptimizableGraph::Vertex *> variables;
+        int dim = 0;
+        auto add_variable = [&](g2o::HyperGraph::Vertex *v) {
+            if (offset.count(v)) return;
+            auto vertex = static_cast<g2o::OptimizableGraph::Vertex *>(v);
+            offset[v] = dim;
+            variables.push_back(vertex);
+            dim += vertex->dimension();
+        };
+        if (prior_) {
+            for (auto v : prior_->vertices()) {
+                if (!marginalized.count(v)) add_variable(v);
+            }
+        }
+        for (auto v : shared_landmarks) add_variable(v);
+        const int kept = dim;
+        const size_t num_kept = variables.size();
+        for (auto v : marginalized_poses) add_variable(v);
+        if (prior_) {
+            for (auto v : prior_->vertices()) add_variable(v);
+        }
+
+        MatXX H = MatXX::Zero(dim, dim);
+        VecX b = VecX::Zero(dim);
+
+        // pose-landmark blocks of each eliminated landmark, by pose offset
+        typedef Eigen::Matrix<double, 6, 3> Mat63;
+        struct LandmarkBlock {
+            Mat33 H = Mat33::Zero();
+            Vec3 b = Vec3::Zero();
+            std::map<int, Mat63, std::less<int>, Eigen::aligned_allocator<std::pair<const int, Mat63>>> H_pose;
+        };
+        std::unordered_map<VertexXYZ *, LandmarkBlock> landmark_blocks;
+
+        for (auto &iter : absorbed) {
+            EdgeProjection *edge = iter->second.edge;
+            edge->computeError();
+            edge->linearizeOplus();
+            double chi2 = edge->error().squaredNorm();
+            Vec3 rho(chi2, 1, 0);
+            if (edge->robustKernel()) edge->robustKernel()->robustify(chi2, rho);
+            const double w = rho[1];
+            const Vec2 &e = edge->error();
+
+            int p = offset.at(edge->vertex(0));
+            const auto &Jp = edge->jacobianOplusXi();
+            H.block<6, 6>(p, p) += w * Jp.transpose() * Jp;
+            b.segment<6>(p) += w * Jp.transpose() * e;
+
+            auto v1 = static_cast<VertexXYZ *>(edge->vertex(1));
+            if (v1->fixed()) continue; // retired landmark
+            const auto &Jl = edge->jacobianOplusXj();
+            auto dense = offset.find(v1);
+            if (dense != offset.end()) {
+                int l = dense->second;
+                H.block<3, 3>(l, l) += w * Jl.transpose() * Jl;
+                H.block<6, 3>(p, l) += w * Jp.transpose() * Jl;
+                H.block<3, 6>(l, p) += w * Jl.transpose() * Jp;
+                b.segment<3>(l) += w * Jl.transpose() * e;
+                continue;
+            }
+            LandmarkBlock &block = landmark_blocks[v1];
+            block.H += w * Jl.transpose() * Jl;
+            block.b += w * Jl.transpose() * e;
+            auto H_pose = block.H_pose.find(p);
+            if (H_pose == block.H_pose.end()) {
+                block.H_pose[p] = w * Jp.transpose() * Jl;
+            } else {
+                H_pose->second += w * Jp.transpose() * Jl;
+            }
+        }
+
+        // the old prior, relinearized at the current estimates
+        if (prior_) {
+            VecX r = prior_->r0() + prior_->J() * prior_->Delta();
+            MatXX J = MatXX::Zero(r.size(), dim);
+            int col = 0;
+            for (size_t i = 0; i < prior_->vertices().size(); ++i) {
+                int d = prior_->Dims()[i];
+                J.middleCols(offset.at(prior_->vertex(i)), d) = prior_->J().middleCols(col, d);
+                col += d;
+            }
+            H += J.transpose() * J;
+            b += J.transpose() * r;
+        }
+
+        // Schur complement of the eliminated landmarks, 3x3 blocks
+        for (auto &lb : landmark_blocks) {
+            LandmarkBlock &block = lb.second;
+            Eigen::SelfAdjointEigenSolver<Mat33> eigen(block.H);
+            Vec3 inv_values = eigen.eigenvalues().unaryExpr([](double v) { return v > 1e-8 ? 1.0 / v : 0.0; });
+            Mat33 H_inv = eigen.eigenvectors() * inv_values.asDiagonal() * eigen.eigenvectors().transpose();
+            for (auto &pi : block.H_pose) {
+                Mat63 HpH_inv = pi.second * H_inv;
+                b.segment<6>(pi.first) -= HpH_inv * block.b;
+                for (auto &qi : block.H_pose) {
+                    H.block<6, 6>(pi.first, qi.first) -= HpH_inv * qi.second.transpose();
+                }
+            }
+        }
+
+        // Schur complement of the marginalized variables
+        const int marg = dim - kept;
+        MatXX H_prior;
+        VecX b_prior;
+        {
+            MatXX H_mm = 0.5 * (H.bottomRightCorner(marg, marg) + H.bottomRightCorner(marg, marg).transpose());
+            Eigen::SelfAdjointEigenSolver<MatXX> eigen(H_mm);
+            VecX inv_values = eigen.eigenvalues().unaryExpr([](double v) { return v > 1e-8 ? 1.0 / v : 0.0; });
+            MatXX H_mm_inv = eigen.eigenvectors() * inv_values.asDiagonal() * eigen.eigenvectors().transpose();
+            MatXX H_km_inv = H.topRightCorner(kept, marg) * H_mm_inv;
+            H_prior = H.topLeftCorner(kept, kept) - H_km_inv * H.bottomLeftCorner(marg, kept);
+            b_prior = b.head(kept) - H_km_inv * b.tail(marg);
+        }
+
+        // the absorbed edges and the old prior are replaced, the shared landmarks stay free
+        for (auto &iter : absorbed) {
+            absorbed_edges_[iter->first] = iter->second.feature;
+            optimizer_.removeEdge(iter->second.edge);
+            graph_edges_.erase(iter);
+        }
+        for (auto v : landmarks) {
+            v->setFixed(true);
+            retired_landmarks_.insert((v->id() - 1) / 2);
+        }
+        if (prior_) {
+            optimizer_.removeEdge(prior_);
+            prior_ = nullptr;
+        }
+        if (kept == 0) return;
+
+        // H = J^T J, b = J^T r0, on the positive eigenvalues
+        H_prior = 0.5 * (H_prior + H_prior.transpose());
+        Eigen::SelfAdjointEigenSolver<MatXX> eigen(H_prior);
+        const double eps = 1e-8 * std::max(eigen.eigenvalues().maxCoeff(), 1e-8);
+        std::vector<int> rows;
+        for (int i = 0; i < kept; ++i) {
+            if (eigen.eigenvalues()[i] > eps) rows.push_back(i);
+        }
+        if (rows.empty()) return;
+        MatXX J(rows.size(), kept);
+        VecX r0(rows.size());
+        for (size_t i = 0; i < rows.size(); ++i) {
+            double s = std::sqrt(eigen.eigenvalues()[rows[i]]);
+            J.row(i) = s * eigen.eigenvectors().col(rows[i]).transpose();
+            r0[i] = eigen.eigenvectors().col(rows[i]).dot(b_prior) / s;
+        }
+
+        std::vector<int> dims;
+        std::vector<SE3, Eigen::aligned_allocator<SE3>> poses;
+        std::vector<Vec3> points;
+        for (size_t i = 0; i < num_kept; ++i) {
+            dims.push_back(variables[i]->dimension());
+            if (dims.back() == 6) {
+                poses.push_back(static_cast<VertexPose *>(variables[i])->estimate());
+            } else {
+                points.push_back(static_cast<VertexXYZ *>(variables[i])->estimate());
+            }
+        }
+        prior_ = new EdgeMarginalPrior(dims, poses, points, J, r0);
+        for (size_t i = 0; i < num_kept; ++i) {
+            prior_->setVertex(i, variables[i]);
+        }
+        prior_->setId(next_edge_id_++);
+        optimizer_.addEdge(prior_);
+
+        LOG(INFO) << "Marginalized " << keyframe_ids.size() << " keyframes and " << landmarks.size()
+                  << " landmarks into a prior of " << rows.size() << " dims on " << poses.size() << " keyframes and "
+                  << points.size() << " landmarks, " << shared_landmarks.size() << " shared with the window";
+    }
+
+    /**
+     * @details remove vertices from a prior by minimizing its cost over them,
+     * @details r0 + J_k dx_k + J_d dx_d becomes Q (r0 + J_k dx_k), Q = I - J_d (J_d^T J_d)^+ J_d^T
+     * @param keep the vertices which stay, in the order of the vertices of the prior
+     * @param J jacobian of the vertices which stay
+     * @param r0 residual at the linearization points
+     */
+    static void ReducePrior(const EdgeMarginalPrior &prior, const std::vector<bool> &keep, MatXX &J, VecX &r0) {
+        const std::vector<int> &dims = prior.Dims();
+        int kept = 0, dropped = 0;
+        for (size_t i = 0; i < dims.size(); ++i) (keep[i] ? kept : dropped) += dims[i];
+        if (dropped == 0) {
+            J = prior.J();
+            r0 = prior.r0();
+            return;
+        }
+        MatXX J_kept(prior.J().rows(), kept), J_dropped(prior.J().rows(), dropped);
+        int col = 0;
+        kept = dropped = 0;
+        for (size_t i = 0; i < dims.size(); ++i) {
+            if (keep[i]) {
+                J_kept.middleCols(kept, dims[i]) = prior.J().middleCols(col, dims[i]);
+                kept += dims[i];
+            } else {
+                J_dropped.middleCols(dropped, dims[i]) = prior.J().middleCols(col, dims[i]);
+                dropped += dims[i];
+            }
+            col += dims[i];
+        }
+
+        Eigen::SelfAdjointEigenSolver<MatXX> eigen(J_dropped.transpose() * J_dropped);
+        VecX inv_values = eigen.eigenvalues().unaryExpr([](double v) { return v > 1e-8 ? 1.0 / v : 0.0; });
+        MatXX H_inv = eigen.eigenvectors() * inv_values.asDiagonal() * eigen.eigenvectors().transpose();
+        MatXX Q = MatXX::Identity(J_dropped.rows(), J_dropped.rows()) - J_dropped * H_inv * J_dropped.transpose();
+        J = Q * J_kept;
+        r0 = Q * prior.r0();
+    }
+
+    void Backend::RemovePriorLandmarks(unsigned long generation) {
+        if (prior_ == nullptr) return;
+        std::vector<bool> keep;
+        bool reduce = false;
+        for (size_t i = 0; i < prior_->vertices().size(); ++i) {
+            keep.push_back(prior_->Dims()[i] == 6 ||
+                           graph_landmarks_.at((prior_->vertex(i)->id() - 1) / 2).generation == generation);
+            reduce |= !keep.back();
+        }
+        if (!reduce) return;
+
+        MatXX J;
+        VecX r0;
+        ReducePrior(*prior_, keep, J, r0);
+        std::vector<int> dims;
+        std::vector<SE3, Eigen::aligned_allocator<SE3>> poses;
+        std::vector<Vec3> points;
+        std::vector<g2o::HyperGraph::Vertex *> vertices;
+        size_t pose = 0, point = 0;
+        for (size_t i = 0; i < keep.size(); ++i) {
+            const int d = prior_->Dims()[i];
+            if (keep[i]) {
+                dims.push_back(d);
+                vertices.push_back(prior_->vertex(i));
+                if (d == 6) {
+                    poses.push_back(prior_->LinearizationPoints()[pose]);
+                } else {
+                    points.push_back(prior_->PointLinearizationPoints()[point]);
+                }
+            }
+            (d == 6 ? pose : point)++;
+        }
+        optimizer_.removeEdge(prior_);
+        prior_ = nullptr;
+        if (vertices.empty()) return;
+
+        prior_ = new EdgeMarginalPrior(dims, poses, points, J, r0);
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            prior_->setVertex(i, vertices[i]);
+        }
+        prior_->setId(next_edge_id_++);
+        optimizer_.addEdge(prior_);
+    }
+
+    void Backend::ExportProblem(BAProblem &problem) const {
+        problem.K = cam_left_->K();
+        problem.cam_ext[0] = cam_left_->pose();
+        problem.cam_ext[1] = cam_right_->pose();
+        problem.huber_delta = 5.991;
+
+        std::unordered_map<const g2o::HyperGraph::Vertex *, int> index;
+        for (auto &v : graph_poses_) {
+            index[v.second.vertex] = problem.AddPose(v.second.vertex->estimate());
+        }
+        for (auto &v : graph_landmarks_) {
+            index[v.second.vertex] = problem.AddPoint(v.second.vertex->estimate(), v.second.vertex->fixed());
+        }
+        for (auto &ge : graph_edges_) {
+            const EdgeProjection *edge = ge.second.edge;
+            problem.AddObservation(index.at(edge->vertex(0)), index.at(edge->vertex(1)),
+                                   ge.second.camera, edge->measurement());
+        }
+        // the prior of the BAProblem is on poses, its landmarks are minimized out
+        if (prior_ && !prior_->LinearizationPoints().empty()) {
+            std::vector<bool> keep;
+            for (size_t i = 0; i < prior_->vertices().size(); ++i) {
+                keep.push_back(prior_->Dims()[i] == 6);
+                if (keep.back()) problem.prior_poses.push_back(index.at(prior_->vertex(i)));
+            }
+            problem.prior_linearization = prior_->LinearizationPoints();
+            ReducePrior(*prior_, keep, problem.prior_J, problem.prior_r0);
+        }
+    }
+
+    void Backend::ImportProblem(const BAProblem &problem) {
+        int i = 0;
+        for (auto &v : graph_poses_) v.second.vertex->setEstimate(problem.poses[i++]);
+        i = 0;
+        for (auto &v : graph_landmarks_) v.second.vertex->setEstimate(problem.points[i++]);
+    }
+
+    /**
+     * @details optimize the MapPoints/landmarks and camera pose
+     * @details it will be activated after map_update_ wait for the notification
+     * @details map_update_.wait(lock) in the Backend::Backend()->void Backend::BackendLoop()
+     * @param keyframes
+     * @param landmarks
+     */
+    void Backend::Optimize(const Map::KeyframesType &keyframes, const Map::LandmarksType &landmarks) {
+        ScopedTimer timer("backend.optimize");
+        auto t1 = std::chrono::steady_clock::now();
+        // the structure of the sparse block matrices is rebuilt only if the graph changed
+        structure_changed_ |= UpdateGraph(keyframes, landmarks);
+        if (graph_edges_.empty()) return;
+        if (solver_type_ == BackendSolverType::G2O && structure_changed_) {
+            optimizer_.initializeOptimization();
+            structure_changed_ = false;
+        }
+        auto t2 = std::chrono::steady_clock::now();
+
         // do optimization and estimate the outliers
-        optimizer.initializeOptimization();
-        optimizer.optimize(10);
+        double chi2_th = 5.991; // robust kernel threshold
+        if (solver_type_ == BackendSolverType::SCHUR || !record_dir_.empty()) {
+            BAProblem problem;
+            ExportProblem(problem);
+            if (!record_dir_.empty()) {
+                char name[32];
+                std::snprintf(name, sizeof(name), "/ba_%06d.bin", timing_.updates);
+                problem.Save(record_dir_ + name);
+            }
+            if (solver_type_ == BackendSolverType::SCHUR) {
+                schur_solver_.Solve(problem, 10);
+                ImportProblem(problem);
+            }
+        }
+        if (solver_type_ == BackendSolverType::G2O) {
+            optimizer_.optimize(10);
+        }
+        auto t3 = std::chrono::steady_clock::now();
+        double graph_ms = std::chrono::duration<double, std::milli>(t2 - t1).count();
+        double optimization_ms = std::chrono::duration<double, std::milli>(t3 - t2).count();
+        timing_.graph += graph_ms;
+        timing_.optimization += optimization_ms;
+        timing_.updates++;
+        if (prior_) {
+            prior_->computeError();
+            LOG(INFO) << "Backend update: graph " << graph_ms << " ms, optimization " << optimization_ms
+                      << " ms, prior " << prior_->dimension() << " dims, cost " << prior_->chi2();
+        } else {
+            LOG(INFO) << "Backend update: graph " << graph_ms << " ms, optimization " << optimization_ms << " ms";
+        }
+
+        if (solver_type_ == BackendSolverType::SCHUR) {
+            for (auto &ge : graph_edges_) ge.second.edge->computeError();
+        }
 
         int cnt_outlier = 0, cnt_inlier = 0;
         int iteration = 0;
@@ -144,8 +652,8 @@ namespace myslam {
             cnt_outlier = 0;
             cnt_inlier = 0;
             // determine if we want to adjust the outlier threshold
-            for (auto &ef : edges_and_features) {
-                if (ef.first->chi2() > chi2_th) {
+            for (auto &ge : graph_edges_) {
+                if (ge.second.edge->chi2() > chi2_th) {
                     cnt_outlier++;
                 } else {
                     cnt_inlier++;
@@ -160,26 +668,32 @@ namespace myslam {
             }
         }
 
-        for (auto &ef : edges_and_features) {
-            if (ef.first->chi2() > chi2_th) {
-                ef.second->is_outlier_ = true;
-                // remove the observation
-                ef.second->map_point_.lock()->RemoveObservation(ef.second);
+        for (auto &ge : graph_edges_) {
+            auto feat = ge.second.feature.lock();
+            if (feat == nullptr) continue;
+            if (ge.second.edge->chi2() > chi2_th) {
+                feat->is_outlier_ = true;
+                // remove the observation, the edge is removed by the next update
+                auto mp = feat->map_point_.lock();
+                if (mp) mp->RemoveObservation(feat);
             } else {
-                ef.second->is_outlier_ = false;
+                feat->is_outlier_ = false;
             }
         }
 
         LOG(INFO) << "Outlier/Inlier in optimization: " << cnt_outlier << "/" << cnt_inlier;
 
-        // set pose and landmark position
-        for (auto &v : vertices) {
-            keyframes.at(v.first)->SetPose(v.second->estimate());
+        // set pose and landmark position, as one commit
+        map_->BeginCommit();
+        for (auto &v : graph_poses_) {
+            keyframes.at(v.first)->SetPose(v.second.vertex->estimate());
         }
 
-        for (auto &v : vertices_landmarks) {
-            landmarks.at(v.first)->SetPos(v.second->estimate());
+        for (auto &v : graph_landmarks_) {
+            if (v.second.vertex->fixed()) continue;
+            landmarks.at(v.first)->SetPos(v.second.vertex->estimate());
         }
+        map_->EndCommit();
     }
 
-} // namespace myslam
\ No newline at end of file
+} // namespace myslam
@@ -0,0 +1,164 @@
+#include "myslam/cached_dataset.h"
+#include "myslam/frame.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace myslam {
+
+    namespace {
+        const char kCacheMagic[8] = {'M', 'Y', 'S', 'L', 'A', 'M', 'D', 'C'};
+        const uint32_t kCacheVersion = 1;
+        const uint64_t kImageAlignment = 64;
+
+        // memory mapping of a whole file
+        struct MappedFile {
+            void *addr = MAP_FAILED;
+            size_t size = 0;
+
+            ~MappedFile() {
+                if (addr != MAP_FAILED) munmap(addr, size);
+            }
+        };
+    } // namespace
+
+    CachedDataset::CachedDataset(const std::string &dataset_path, const std::string &cache_file)
+        : KittiDataset(dataset_path), cache_file_(cache_file) {}
+
+    bool CachedDataset::Init() {
+        // nothing to decode, the loader thread is not needed
+        prefetch_depth_ = 0;
+        if (!Dataset::Init()) return false;
+
+        int fd = open(cache_file_.c_str(), O_RDONLY);
+        if (fd < 0) {
+            LOG(ERROR) << "cannot open cache file " << cache_file_;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(CacheHeader)) {
+            LOG(ERROR) << "invalid cache file " << cache_file_;
+            close(fd);
+            return false;
+        }
+
+        auto mapped = std::make_shared<MappedFile>();
+        mapped->size = st.st_size;
+        // private and writable, so that a writer of the images gets its own copy of the page
+        mapped->addr = mmap(nullptr, mapped->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped->addr == MAP_FAILED) {
+            LOG(ERROR) << "cannot map cache file " << cache_file_;
+            return false;
+        }
+        madvise(mapped->addr, mapped->size, MADV_SEQUENTIAL);
+
+        const uint8_t *data = static_cast<const uint8_t *>(mapped->addr);
+        CacheHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+            header.version != kCacheVersion ||
+            header.index_offset + uint64_t(header.num_frames) * sizeof(CacheEntry) > mapped->size) {
+            LOG(ERROR) << "invalid cache header in " << cache_file_;
+            return false;
+        }
+
+        const CacheEntry *entries = reinterpret_cast<const CacheEntry *>(data + header.index_offset);
+        for (uint32_t i = 0; i < header.num_frames; ++i) {
+            uint64_t image_size = uint64_t(entries[i].width) * entries[i].height;
+            if (entries[i].left_offset + image_size > mapped->size ||
+                entries[i].right_offset + image_size > mapped->size) {
+                LOG(ERROR) << "invalid cache entry " << i << " in " << cache_file_;
+                return false;
+            }
+        }
+
+        mapping_ = mapped;
+        data_ = data;
+        entries_ = entries;
+        num_frames_ = header.num_frames;
+        LOG(INFO) << "Mapped " << num_frames_ << " frames from " << cache_file_;
+        return true;
+    }
+
+    Frame::Ptr CachedDataset::NextFrame() {
+        if (size_t(current_image_index_) >= num_frames_) {
+            LOG(WARNING) << "no more images in cache at index " << current_image_index_;
+            return nullptr;
+        }
+
+        const CacheEntry &entry = entries_[current_image_index_];
+        auto new_frame = Frame::CreateFrame();
+        new_frame->time_stamp_ = entry.time_stamp;
+        new_frame->left_img_ = cv::Mat(entry.height, entry.width, CV_8UC1,
+                const_cast<uint8_t *>(data_ + entry.left_offset));
+        new_frame->right_img_ = cv::Mat(entry.height, entry.width, CV_8UC1,
+                const_cast<uint8_t *>(data_ + entry.right_offset));
+        new_frame->image_storage_ = mapping_;
+        current_image_index_++;
+        return new_frame;
+    }
+
+    int CachedDataset::Write(const std::string &cache_file, Dataset &source) {
+        std::ofstream fout(cache_file, std::ios::binary | std::ios::trunc);
+        if (!fout) {
+            LOG(ERROR) << "cannot create cache file " << cache_file;
+            return -1;
+        }
+
+        // the header is written again when the index is known
+        CacheHeader header;
+        memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+        header.version = kCacheVersion;
+        header.num_frames = 0;
+        header.index_offset = 0;
+        fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        uint64_t offset = sizeof(header);
+        const char padding[kImageAlignment] = {0};
+        auto write_image = [&](const cv::Mat &img) {
+            uint64_t aligned = (offset + kImageAlignment - 1) / kImageAlignment * kImageAlignment;
+            fout.write(padding, aligned - offset);
+            for (int r = 0; r < img.rows; ++r) {
+                fout.write(img.ptr<char>(r), img.cols);
+            }
+            offset = aligned + uint64_t(img.cols) * img.rows;
+            return aligned;
+        };
+
+        std::vector<CacheEntry> entries;
+        for (Frame::Ptr frame = source.NextFrame(); frame != nullptr; frame = source.NextFrame()) {
+            if (frame->left_img_.type() != CV_8UC1 || frame->right_img_.type() != CV_8UC1 ||
+                frame->left_img_.size() != frame->right_img_.size()) {
+                LOG(ERROR) << "cache only supports 8-bit stereo pairs of same size";
+                return -1;
+            }
+            CacheEntry entry;
+            entry.width = frame->left_img_.cols;
+            entry.height = frame->left_img_.rows;
+            entry.time_stamp = frame->time_stamp_;
+            entry.left_offset = write_image(frame->left_img_);
+            entry.right_offset = write_image(frame->right_img_);
+            entries.push_back(entry);
+        }
+
+        header.num_frames = entries.size();
+        header.index_offset = (offset + alignof(CacheEntry) - 1) / alignof(CacheEntry) * alignof(CacheEntry);
+        fout.write(padding, header.index_offset - offset);
+        fout.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(CacheEntry));
+        fout.seekp(0);
+        fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        if (!fout) {
+            LOG(ERROR) << "failed to write cache file " << cache_file;
+            return -1;
+        }
+        LOG(INFO) << "Wrote " << entries.size() << " frames to " << cache_file;
+        return entries.size();
+    }
+
+} // namespace myslam
@@ -0,0 +1,219 @@
+#include "myslam/corner.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace myslam {
+
+    namespace {
+
+        // scale of the 3x3 Sobel of 8-bit images with 3x3 block, as in cv::cornerMinEigenVal
+        const float kGradientScale = 1.0f / (4 * 3 * 255);
+
+        /**
+         * @details gradient products of pixel row y, for x in [1, width - 1)
+         * @param top, mid, bot pixel rows y - 1, y, y + 1
+         */
+        void GradientProducts(const uchar *top, const uchar *mid, const uchar *bot, int width,
+                              float *xx, float *xy, float *yy) {
+            int x = 1;
+#if defined(__AVX2__)
+            const __m256 scale = _mm256_set1_ps(kGradientScale);
+            for (; x + 16 <= width - 1; x += 16) {
+                __m256i t0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (top + x - 1)));
+                __m256i t1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (top + x)));
+                __m256i t2 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (top + x + 1)));
+                __m256i m0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (mid + x - 1)));
+                __m256i m2 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (mid + x + 1)));
+                __m256i b0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (bot + x - 1)));
+                __m256i b1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (bot + x)));
+                __m256i b2 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (bot + x + 1)));
+
+                // |gx|, |gy| <= 1020, no overflow in 16 bits
+                __m256i gx = _mm256_add_epi16(_mm256_add_epi16(_mm256_sub_epi16(t2, t0), _mm256_sub_epi16(b2, b0)),
+                                              _mm256_slli_epi16(_mm256_sub_epi16(m2, m0), 1));
+                __m256i gy = _mm256_sub_epi16(
+                        _mm256_add_epi16(_mm256_add_epi16(b0, b2), _mm256_slli_epi16(b1, 1)),
+                        _mm256_add_epi16(_mm256_add_epi16(t0, t2), _mm256_slli_epi16(t1, 1)));
+
+                for (int half = 0; half < 2; ++half) {
+                    __m128i gx16 = half ? _mm256_extracti128_si256(gx, 1) : _mm256_castsi256_si128(gx);
+                    __m128i gy16 = half ? _mm256_extracti128_si256(gy, 1) : _mm256_castsi256_si128(gy);
+                    __m256 fx = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(gx16)), scale);
+                    __m256 fy = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(gy16)), scale);
+                    int i = x + half * 8;
+                    _mm256_storeu_ps(xx + i, _mm256_mul_ps(fx, fx));
+                    _mm256_storeu_ps(xy + i, _mm256_mul_ps(fx, fy));
+                    _mm256_storeu_ps(yy + i, _mm256_mul_ps(fy, fy));
+                }
+            }
+#elif defined(__SSE2__)
+            const __m128 scale = _mm_set1_ps(kGradientScale);
+            const __m128i zero = _mm_setzero_si128();
+            for (; x + 8 <= width - 1; x += 8) {
+                __m128i t0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (top + x - 1)), zero);
+                __m128i t1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (top + x)), zero);
+                __m128i t2 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (top + x + 1)), zero);
+                __m128i m0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (mid + x - 1)), zero);
+                __m128i m2 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (mid + x + 1)), zero);
+                __m128i b0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (bot + x - 1)), zero);
+                __m128i b1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (bot + x)), zero);
+                __m128i b2 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (bot + x + 1)), zero);
+
+                // |gx|, |gy| <= 1020, no overflow in 16 bits
+                __m128i gx = _mm_add_epi16(_mm_add_epi16(_mm_sub_epi16(t2, t0), _mm_sub_epi16(b2, b0)),
+                                           _mm_slli_epi16(_mm_sub_epi16(m2, m0), 1));
+                __m128i gy = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(b0, b2), _mm_slli_epi16(b1, 1)),
+                                           _mm_add_epi16(_mm_add_epi16(t0, t2), _mm_slli_epi16(t1, 1)));
+
+                for (int half = 0; half < 2; ++half) {
+                    // sign extension of 16 bits to 32 bits
+                    __m128i gx32 = half ? _mm_unpackhi_epi16(gx, gx) : _mm_unpacklo_epi16(gx, gx);
+                    __m128i gy32 = half ? _mm_unpackhi_epi16(gy, gy) : _mm_unpacklo_epi16(gy, gy);
+                    __m128 fx = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(gx32, 16)), scale);
+                    __m128 fy = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(gy32, 16)), scale);
+                    int i = x + half * 4;
+                    _mm_storeu_ps(xx + i, _mm_mul_ps(fx, fx));
+                    _mm_storeu_ps(xy + i, _mm_mul_ps(fx, fy));
+                    _mm_storeu_ps(yy + i, _mm_mul_ps(fy, fy));
+                }
+            }
+#endif
+            for (; x < width - 1; ++x) {
+                int gx = (top[x + 1] - top[x - 1]) + 2 * (mid[x + 1] - mid[x - 1]) + (bot[x + 1] - bot[x - 1]);
+                int gy = (bot[x - 1] + 2 * bot[x] + bot[x + 1]) - (top[x - 1] + 2 * top[x] + top[x + 1]);
+                float fx = gx * kGradientScale, fy = gy * kGradientScale;
+                xx[x] = fx * fx;
+                xy[x] = fx * fy;
+                yy[x] = fy * fy;
+            }
+        }
+
+        /**
+         * @details minimal eigenvalue of the box filtered structure tensor, for x in [2, width - 2)
+         * @param sxx, sxy, syy vertical sums of the products of 3 rows
+         */
+        void MinEigenValue(const float *sxx, const float *sxy, const float *syy, int width, float *score) {
+            int x = 2;
+#if defined(__AVX2__)
+            const __m256 half = _mm256_set1_ps(0.5f);
+            for (; x + 8 <= width - 2; x += 8) {
+                __m256 a = _mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps(sxx + x - 1), _mm256_loadu_ps(sxx + x)),
+                                         _mm256_loadu_ps(sxx + x + 1));
+                __m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps(sxy + x - 1), _mm256_loadu_ps(sxy + x)),
+                                         _mm256_loadu_ps(sxy + x + 1));
+                __m256 c = _mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps(syy + x - 1), _mm256_loadu_ps(syy + x)),
+                                         _mm256_loadu_ps(syy + x + 1));
+                a = _mm256_mul_ps(a, half);
+                c = _mm256_mul_ps(c, half);
+                __m256 d = _mm256_sub_ps(a, c);
+                __m256 r = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(d, d), _mm256_mul_ps(b, b)));
+                _mm256_storeu_ps(score + x, _mm256_sub_ps(_mm256_add_ps(a, c), r));
+            }
+#elif defined(__SSE2__)
+            const __m128 half = _mm_set1_ps(0.5f);
+            for (; x + 4 <= width - 2; x += 4) {
+                __m128 a = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(sxx + x - 1), _mm_loadu_ps(sxx + x)),
+                                      _mm_loadu_ps(sxx + x + 1));
+                __m128 b = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(sxy + x - 1), _mm_loadu_ps(sxy + x)),
+                                      _mm_loadu_ps(sxy + x + 1));
+                __m128 c = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(syy + x - 1), _mm_loadu_ps(syy + x)),
+                                      _mm_loadu_ps(syy + x + 1));
+                a = _mm_mul_ps(a, half);
+                c = _mm_mul_ps(c, half);
+                __m128 d = _mm_sub_ps(a, c);
+                __m128 r = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(d, d), _mm_mul_ps(b, b)));
+                _mm_storeu_ps(score + x, _mm_sub_ps(_mm_add_ps(a, c), r));
+            }
+#endif
+            for (; x < width - 2; ++x) {
+                float a = (sxx[x - 1] + sxx[x] + sxx[x + 1]) * 0.5f;
+                float b = sxy[x - 1] + sxy[x] + sxy[x + 1];
+                float c = (syy[x - 1] + syy[x] + syy[x + 1]) * 0.5f;
+                score[x] = (a + c) - std::sqrt((a - c) * (a - c) + b * b);
+            }
+        }
+
+    } // namespace
+
+    void ShiTomasiScore(const uchar *img, int width, int height, int img_stride,
+                        float *score, int score_stride) {
+        for (int y = 0; y < height; ++y) {
+            std::fill(score + y * score_stride, score + y * score_stride + width, 0.0f);
+        }
+        if (width < 5 || height < 5) return;
+
+        // 3 rows of products in a ring, and 3 rows of their vertical sums
+        thread_local std::vector<float> buffer;
+        buffer.assign(12 * width, 0.0f);
+        float *products[3][3];
+        for (int r = 0; r < 3; ++r) {
+            for (int k = 0; k < 3; ++k) {
+                products[r][k] = buffer.data() + (3 * r + k) * width;
+            }
+        }
+        float *sums[3] = {buffer.data() + 9 * width, buffer.data() + 10 * width, buffer.data() + 11 * width};
+
+        for (int y = 1; y < height - 1; ++y) {
+            float **p = products[y % 3];
+            GradientProducts(img + (y - 1) * img_stride, img + y * img_stride, img + (y + 1) * img_stride,
+                             width, p[0], p[1], p[2]);
+            if (y < 3) continue;
+
+            // score of row y - 1 from the products of rows y - 2, y - 1, y
+            float **p0 = products[(y - 2) % 3], **p1 = products[(y - 1) % 3];
+            for (int k = 0; k < 3; ++k) {
+                for (int x = 0; x < width; ++x) {
+                    sums[k][x] = p0[k][x] + p1[k][x] + p[k][x];
+                }
+            }
+            MinEigenValue(sums[0], sums[1], sums[2], width, score + (y - 1) * score_stride);
+        }
+    }
+
+    int NonMaxSuppression3x3(const float *score, int score_stride,
+                             int x0, int y0, int x1, int y1, float min_score,
+                             std::vector<cv::Point> &maxima) {
+        int cnt = 0;
+        for (int y = y0; y < y1; ++y) {
+            const float *row = score + y * score_stride;
+            const float *prev = row - score_stride;
+            const float *next = row + score_stride;
+            int x = x0;
+#if defined(__SSE2__)
+            // most pixels are below the threshold or not a maximum, reject 4 at once
+            const __m128 th = _mm_set1_ps(min_score);
+            for (; x + 4 <= x1; x += 4) {
+                __m128 s = _mm_loadu_ps(row + x);
+                __m128 m = _mm_max_ps(_mm_loadu_ps(row + x - 1), _mm_loadu_ps(row + x + 1));
+                m = _mm_max_ps(m, _mm_max_ps(_mm_loadu_ps(prev + x - 1), _mm_loadu_ps(prev + x)));
+                m = _mm_max_ps(m, _mm_max_ps(_mm_loadu_ps(prev + x + 1), _mm_loadu_ps(next + x - 1)));
+                m = _mm_max_ps(m, _mm_max_ps(_mm_loadu_ps(next + x), _mm_loadu_ps(next + x + 1)));
+                int mask = _mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(s, m), _mm_cmpgt_ps(s, th)));
+                for (int i = 0; mask; ++i, mask >>= 1) {
+                    if (mask & 1) {
+                        maxima.push_back(cv::Point(x + i, y));
+                        cnt++;
+                    }
+                }
+            }
+#endif
+            for (; x < x1; ++x) {
+                float s = row[x];
+                if (s <= min_score || s < row[x - 1] || s < row[x + 1] ||
+                    s < prev[x - 1] || s < prev[x] || s < prev[x + 1] ||
+                    s < next[x - 1] || s < next[x] || s < next[x + 1]) continue;
+                maxima.push_back(cv::Point(x, y));
+                cnt++;
+            }
+        }
+        return cnt;
+    }
+
+} // namespace myslam
@@ -1,89 +1,109 @@
 #include "myslam/dataset.h"
 #include "myslam/frame.h"
 
-#include <boost/format.hpp>
-#include <fstream>
-#include <opencv2/opencv.hpp>
-
 namespace myslam {
     Dataset::Dataset(const std::string &dataset_path): dataset_path_(dataset_path){}
 
+    Dataset::~Dataset() {
+        StopLoader();
+    }
+
     bool Dataset::Init() {
-        // read camera intrinsics and extrinsics
-        std::ifstream fin(dataset_path_ + "/calib.txt"); // read file
-        if (!fin) {
-            LOG(ERROR) << "cannot find " << dataset_path_ << "/calib.txt!";
-            return false;
+        StopLoader();
+        cameras_.clear();
+        if (!Open()) return false;
+        current_image_index_ = 0;
+        stopping_ = false;
+
+        if (prefetch_depth_ > 0) {
+            ring_.assign(prefetch_depth_, StereoPair());
+            ring_head_ = 0;
+            ring_count_ = 0;
+            dropped_ = 0;
+            loader_running_ = true;
+            loader_thread_ = std::thread(std::bind(&Dataset::LoaderLoop, this));
+        }
+        return true;
+    }
+
+    void Dataset::SetStereoCameras(double fx, double fy, double cx, double cy, double baseline) {
+        cameras_.clear();
+        cameras_.push_back(Camera::Ptr(new Camera(fx, fy, cx, cy, baseline, SE3())));
+        cameras_.push_back(Camera::Ptr(new Camera(fx, fy, cx, cy, baseline, SE3(SO3(), Vec3(-baseline, 0, 0)))));
+    }
+
+    void Dataset::StopLoader() {
+        {
+            std::unique_lock<std::mutex> lck(loader_mutex_);
+            loader_running_ = false;
+            stopping_ = true;
         }
+        slot_freed_.notify_one();
+        if (loader_thread_.joinable()) loader_thread_.join();
+    }
 
-        /**
-         * camera_name: K, t
-         * P0: 7.070912000000e+02 0.000000000000e+00 6.018873000000e+02 0.000000000000e+00
-         *     0.000000000000e+00 7.070912000000e+02 1.831104000000e+02 0.000000000000e+00
-         *     0.000000000000e+00 0.000000000000e+00 1.000000000000e+00 0.000000000000e+00
-         * P1: 7.070912000000e+02 0.000000000000e+00 6.018873000000e+02 -3.798145000000e+02
-         *     0.000000000000e+00 7.070912000000e+02 1.831104000000e+02 0.000000000000e+00
-         *     0.000000000000e+00 0.000000000000e+00 1.000000000000e+00 0.000000000000e+00
-         * P2: 7.070912000000e+02 0.000000000000e+00 6.018873000000e+02 4.688783000000e+01
-         *     0.000000000000e+00 7.070912000000e+02 1.831104000000e+02 1.178601000000e-01
-         *     0.000000000000e+00 0.000000000000e+00 1.000000000000e+00 6.203223000000e-03
-         * P3: 7.070912000000e+02 0.000000000000e+00 6.018873000000e+02 -3.334597000000e+02
-         *     0.000000000000e+00 7.070912000000e+02 1.831104000000e+02 1.930130000000e+00
-         *     0.000000000000e+00 0.000000000000e+00 1.000000000000e+00 3.318498000000e-03
-         */
-        for (int i = 0; i < 4; ++i) {
-            char camera_name[3];
-            for (int k = 0; k < 3; ++k) {
-                fin >> camera_name[k]; // read file
-                // std::cout << camera_name[k] << std::endl;
+    bool Dataset::Stopping() {
+        std::unique_lock<std::mutex> lck(loader_mutex_);
+        return stopping_;
+    }
+
+    unsigned long Dataset::NumDropped() {
+        std::unique_lock<std::mutex> lck(loader_mutex_);
+        return dropped_;
+    }
+
+    void Dataset::LoaderLoop() {
+        for (int index = 0; ; ++index) {
+            {
+                std::unique_lock<std::mutex> lck(loader_mutex_);
+                slot_freed_.wait(lck, [this] {
+                    return live_ || ring_count_ < ring_.size() || !loader_running_;
+                });
+                if (!loader_running_) return;
             }
-            double projection_data[12];
-            for (int k = 0; k < 12; ++k) {
-                fin >> projection_data[k];
+
+            // read outside the lock, NextFrame() can pop meanwhile
+            StereoPair pair;
+            pair.valid = ReadStereoPair(index, pair);
+
+            std::unique_lock<std::mutex> lck(loader_mutex_);
+            if (ring_count_ == ring_.size()) {
+                // only a live source gets here, the tracker is behind and the oldest pair is stale
+                ring_[ring_head_] = StereoPair();
+                ring_head_ = (ring_head_ + 1) % ring_.size();
+                ring_count_--;
+                dropped_++;
             }
-            Mat33 K;
-            K << projection_data[0], projection_data[1], projection_data[2],
-                 projection_data[4], projection_data[5], projection_data[6],
-                 projection_data[8], projection_data[9], projection_data[10];
-            Vec3 t;
-            t << projection_data[3], projection_data[7], projection_data[11];
-            t = K.inverse() * t;
-            K = K * 0.5;
-            Camera::Ptr new_camera(new Camera(K(0, 0), K(1, 1), K(0, 2), K(1, 2),
-                    t.norm(), SE3(SO3(), t)));
-            cameras_.push_back(new_camera);
-            LOG(INFO) << "Camera " << i << " extrinsics: " << t.transpose();
+            ring_[(ring_head_ + ring_count_) % ring_.size()] = pair;
+            ring_count_++;
+            pair_loaded_.notify_one();
+
+            // the invalid pair stays in the queue and marks the end of the sequence
+            if (!pair.valid) return;
         }
-        fin.close();
-        current_image_index_ = 0;
-        return true;
     }
 
     Frame::Ptr Dataset::NextFrame() {
-        boost::format fmt("%s/image_%d/%06d.png");
-        cv::Mat image_left, image_right;
-        // read images
-        image_left = cv::imread((fmt % dataset_path_ % 0 % current_image_index_).str(),
-                                cv::IMREAD_GRAYSCALE);
-        image_right = cv::imread((fmt % dataset_path_ % 1 % current_image_index_).str(),
-                                 cv::IMREAD_GRAYSCALE);
-
-        // cv::imshow("right", image_right);
-
-        if (image_left.data == nullptr || image_right.data == nullptr) {
-            LOG(WARNING) << "cannot find images at index " << current_image_index_;
+        StereoPair pair;
+
+        if (prefetch_depth_ > 0) {
+            std::unique_lock<std::mutex> lck(loader_mutex_);
+            pair_loaded_.wait(lck, [this] { return ring_count_ > 0; });
+            if (!ring_[ring_head_].valid) return nullptr; // end of the sequence, keep it in the queue
+            std::swap(pair, ring_[ring_head_]); // the images are owned by the frame from now on
+            ring_head_ = (ring_head_ + 1) % ring_.size();
+            ring_count_--;
+            slot_freed_.notify_one();
+        } else if (!ReadStereoPair(current_image_index_, pair)) {
             return nullptr;
         }
 
-        cv::Mat image_left_resized, image_right_resized;
-        cv::resize(image_left, image_left_resized, cv::Size(), 0.5, 0.5, cv::INTER_NEAREST);
-        cv::resize(image_right, image_right_resized, cv::Size(), 0.5, 0.5, cv::INTER_NEAREST);
-
         auto new_frame = Frame::CreateFrame();
-        new_frame->left_img_ = image_left_resized;
-        new_frame->right_img_ = image_right_resized;
+        new_frame->time_stamp_ = pair.time_stamp;
+        new_frame->left_img_ = pair.left;
+        new_frame->right_img_ = pair.right;
         current_image_index_++;
         return new_frame;
     }
 
-} // namespace myslam
\ No newline at end of file
+} // namespace myslam
@@ -0,0 +1,145 @@
+#include "myslam/detector.h"
+#include "myslam/corner.h"
+
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+
+namespace myslam {
+
+    GfttDetector::GfttDetector(int num_features, double quality_level, int min_distance)
+        : min_distance_(min_distance) {
+        // goodFeaturesToTrack
+        gftt_ = cv::GFTTDetector::create(num_features, quality_level, min_distance);
+    }
+
+    int GfttDetector::Detect(const cv::Mat &img, const std::vector<cv::Point2f> &existing,
+                             std::vector<cv::KeyPoint> &keypoints) {
+        cv::Mat mask(img.size(), CV_8UC1, 255);
+        const cv::Point2f half(min_distance_ / 2, min_distance_ / 2);
+        for (auto &pt : existing) {
+            cv::rectangle(mask, pt - half, pt + half, 0, cv::FILLED);
+        }
+
+        gftt_->detect(img, keypoints, mask);
+        return keypoints.size();
+    }
+
+    GridDetector::GridDetector(int num_features, int cell_size,
+                               double quality_level, int min_distance)
+        : num_features_(num_features), cell_size_(cell_size),
+          quality_level_(quality_level), min_distance_(min_distance) {}
+
+    void GridDetector::ComputeScore(const cv::Mat &img, cv::Mat &score) {
+        cv::cornerMinEigenVal(img, score, 3, 3);
+    }
+
+    ShiTomasiDetector::ShiTomasiDetector(int num_features, int cell_size,
+                                         double quality_level, int min_distance)
+        : GridDetector(num_features, cell_size, quality_level, min_distance) {}
+
+    void ShiTomasiDetector::ComputeScore(const cv::Mat &img, cv::Mat &score) {
+        score.create(img.size(), CV_32FC1);
+        ShiTomasiScore(img.ptr<uchar>(), img.cols, img.rows, img.step,
+                       score.ptr<float>(), score.step1());
+    }
+
+    bool GridDetector::IsOccupied(const cv::Point2f &pt) const {
+        int bx = std::min(std::max(int(pt.x) / block_size_, 0), bitmap_cols_ - 1);
+        int by = std::min(std::max(int(pt.y) / block_size_, 0), bitmap_rows_ - 1);
+        return occupancy_[by * bitmap_cols_ + bx] != 0;
+    }
+
+    void GridDetector::Occupy(const cv::Point2f &pt) {
+        const float half = min_distance_ / 2.0f;
+        int bx0 = std::max(int(pt.x - half) / block_size_, 0);
+        int by0 = std::max(int(pt.y - half) / block_size_, 0);
+        int bx1 = std::min(int(pt.x + half) / block_size_, bitmap_cols_ - 1);
+        int by1 = std::min(int(pt.y + half) / block_size_, bitmap_rows_ - 1);
+        for (int by = by0; by <= by1; ++by) {
+            for (int bx = bx0; bx <= bx1; ++bx) {
+                occupancy_[by * bitmap_cols_ + bx] = 1;
+            }
+        }
+    }
+
+    int GridDetector::Detect(const cv::Mat &img, const std::vector<cv::Point2f> &existing,
+                             std::vector<cv::KeyPoint> &keypoints) {
+        keypoints.clear();
+        if (img.empty()) return 0;
+        grid_cols_ = (img.cols + cell_size_ - 1) / cell_size_;
+        grid_rows_ = (img.rows + cell_size_ - 1) / cell_size_;
+        const int num_cells = grid_cols_ * grid_rows_;
+        const int quota = (num_features_ + num_cells - 1) / num_cells;
+
+        block_size_ = std::max(min_distance_ / 2, 1);
+        bitmap_cols_ = (img.cols + block_size_ - 1) / block_size_;
+        bitmap_rows_ = (img.rows + block_size_ - 1) / block_size_;
+        occupancy_.assign(bitmap_cols_ * bitmap_rows_, 0);
+        cell_count_.assign(num_cells, 0);
+        cell_corners_.resize(num_cells);
+        cell_max_score_.assign(num_cells, 0);
+
+        // step 1: occupancy of the existing features
+        for (auto &pt : existing) {
+            if (pt.x < 0 || pt.y < 0 || pt.x >= img.cols || pt.y >= img.rows) continue;
+            Occupy(pt);
+            cell_count_[int(pt.y) / cell_size_ * grid_cols_ + int(pt.x) / cell_size_]++;
+        }
+
+        // step 2: score the cells which are not full in parallel, keep the local maxima
+        cv::parallel_for_(cv::Range(0, num_cells), [&](const cv::Range &range) {
+            cv::Mat score;
+            std::vector<cv::Point> maxima;
+            for (int c = range.start; c < range.end; ++c) {
+                cell_corners_[c].clear();
+                if (cell_count_[c] >= quota) continue;
+
+                cv::Rect cell((c % grid_cols_) * cell_size_, (c / grid_cols_) * cell_size_,
+                              cell_size_, cell_size_);
+                cell &= cv::Rect(0, 0, img.cols, img.rows);
+                // margin for the 3x3 derivative and block, and the 3x3 non-maximum suppression
+                const int margin = 3;
+                cv::Rect roi(cell.x - margin, cell.y - margin,
+                             cell.width + 2 * margin, cell.height + 2 * margin);
+                roi &= cv::Rect(0, 0, img.cols, img.rows);
+                ComputeScore(img(roi), score);
+
+                int x0 = std::max(cell.x - roi.x, 1), x1 = std::min(cell.x + cell.width - roi.x, roi.width - 1);
+                int y0 = std::max(cell.y - roi.y, 1), y1 = std::min(cell.y + cell.height - roi.y, roi.height - 1);
+                maxima.clear();
+                if (x0 < x1 && y0 < y1) {
+                    NonMaxSuppression3x3(score.ptr<float>(), score.step1(), x0, y0, x1, y1, 0, maxima);
+                }
+
+                float max_score = 0;
+                for (auto &m : maxima) {
+                    float s = score.at<float>(m.y, m.x);
+                    cell_corners_[c].push_back({s, cv::Point2f(m.x + roi.x, m.y + roi.y)});
+                    max_score = std::max(max_score, s);
+                }
+                cell_max_score_[c] = max_score;
+            }
+        });
+
+        // step 3: relative threshold as in goodFeaturesToTrack,
+        //         then the strongest corners of each cell which keep the spacing
+        float max_score = *std::max_element(cell_max_score_.begin(), cell_max_score_.end());
+        const float threshold = quality_level_ * max_score;
+        for (int c = 0; c < num_cells; ++c) {
+            auto &corners = cell_corners_[c];
+            std::sort(corners.begin(), corners.end(),
+                      [](const Corner &a, const Corner &b) { return a.score > b.score; });
+            int free_quota = quota - cell_count_[c];
+            for (auto &corner : corners) {
+                if (free_quota <= 0 || corner.score < threshold) break;
+                if (IsOccupied(corner.pt)) continue;
+                Occupy(corner.pt);
+                keypoints.push_back(cv::KeyPoint(corner.pt, 3, -1, corner.score));
+                free_quota--;
+            }
+        }
+
+        return keypoints.size();
+    }
+
+} // namespace myslam
@@ -0,0 +1,133 @@
+#include "myslam/euroc_dataset.h"
+
+#include <fstream>
+#include <map>
+#include <opencv2/opencv.hpp>
+
+namespace myslam {
+
+    namespace {
+        // intrinsics, distortion and T_BS of a camera of the sensor.yaml
+        struct EurocCamera {
+            cv::Mat K, D;
+            Eigen::Matrix4d T_BS;
+            cv::Size size;
+        };
+
+        bool ReadSensor(const std::string &path, EurocCamera &camera) {
+            cv::FileStorage file(path, cv::FileStorage::READ);
+            if (!file.isOpened()) {
+                LOG(ERROR) << "cannot find " << path;
+                return false;
+            }
+            std::vector<double> intrinsics, distortion, T_BS;
+            std::vector<int> resolution;
+            file["intrinsics"] >> intrinsics; // fu, fv, cu, cv
+            file["distortion_coefficients"] >> distortion; // radial-tangential k1, k2, p1, p2
+            file["resolution"] >> resolution;
+            file["T_BS"]["data"] >> T_BS; // row major
+            if (intrinsics.size() != 4 || resolution.size() != 2 || T_BS.size() != 16) {
+                LOG(ERROR) << "invalid camera in " << path;
+                return false;
+            }
+            camera.K = (cv::Mat_<double>(3, 3) << intrinsics[0], 0, intrinsics[2],
+                                                 0, intrinsics[1], intrinsics[3],
+                                                 0, 0, 1);
+            camera.D = cv::Mat(distortion, true).reshape(1, 1);
+            camera.size = cv::Size(resolution[0], resolution[1]);
+            for (int i = 0; i < 16; ++i) camera.T_BS(i / 4, i % 4) = T_BS[i];
+            return true;
+        }
+
+        // time stamp in ns of data.csv to file name
+        bool ReadCsv(const std::string &path, std::map<int64_t, std::string> &files) {
+            std::ifstream fin(path);
+            if (!fin) {
+                LOG(ERROR) << "cannot find " << path;
+                return false;
+            }
+            std::string line;
+            while (std::getline(fin, line)) {
+                if (line.empty() || line[0] == '#') continue;
+                size_t comma = line.find(',');
+                if (comma == std::string::npos) continue;
+                std::string name = line.substr(comma + 1);
+                name.erase(name.find_last_not_of(" \r") + 1);
+                files[std::stoll(line.substr(0, comma))] = name;
+            }
+            return true;
+        }
+    } // namespace
+
+    EurocDataset::EurocDataset(const std::string &dataset_path) : Dataset(dataset_path) {}
+
+    EurocDataset::~EurocDataset() {
+        StopLoader();
+    }
+
+    bool EurocDataset::Open() {
+        EurocCamera camera[2];
+        std::map<int64_t, std::string> files[2];
+        for (int i = 0; i < 2; ++i) {
+            std::string dir = dataset_path_ + "/mav0/cam" + std::to_string(i);
+            if (!ReadSensor(dir + "/sensor.yaml", camera[i]) || !ReadCsv(dir + "/data.csv", files[i])) return false;
+            for (auto &file : files[i]) file.second = dir + "/data/" + file.second;
+        }
+
+        // pairs of the time stamps of both cameras
+        entries_.clear();
+        for (auto &left : files[0]) {
+            auto right = files[1].find(left.first);
+            if (right == files[1].end()) continue;
+            entries_.push_back({left.first * 1e-9, left.second, right->second});
+        }
+        LOG(INFO) << "Found " << entries_.size() << " stereo pairs in " << dataset_path_;
+
+        // rotation and translation from the left to the right camera
+        Eigen::Matrix4d T_10 = camera[1].T_BS.inverse() * camera[0].T_BS;
+        cv::Mat R(3, 3, CV_64F), t(3, 1, CV_64F);
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) R.at<double>(r, c) = T_10(r, c);
+            t.at<double>(r) = T_10(r, 3);
+        }
+        cv::Mat R_rect[2], P[2], Q;
+        cv::stereoRectify(camera[0].K, camera[0].D, camera[1].K, camera[1].D, camera[0].size, R, t,
+                          R_rect[0], R_rect[1], P[0], P[1], Q, cv::CALIB_ZERO_DISPARITY, 0);
+        for (int i = 0; i < 2; ++i) {
+            cv::initUndistortRectifyMap(camera[i].K, camera[i].D, R_rect[i], P[i], camera[0].size, CV_16SC2,
+                                        map_x_[i], map_y_[i]);
+        }
+
+        double fx = P[0].at<double>(0, 0);
+        double baseline = -P[1].at<double>(0, 3) / P[1].at<double>(0, 0);
+        SetStereoCameras(fx, P[0].at<double>(1, 1), P[0].at<double>(0, 2), P[0].at<double>(1, 2), baseline);
+        LOG(INFO) << "Rectified fx " << fx << ", baseline " << baseline;
+        return true;
+    }
+
+    bool EurocDataset::ReadStereoPair(int index, StereoPair &pair) {
+        if (size_t(index) >= entries_.size()) return false;
+        const Entry &entry = entries_[index];
+
+        cv::Mat images[2];
+        // left and right images are decoded and rectified in parallel
+        cv::parallel_for_(cv::Range(0, 2), [&](const cv::Range &range) {
+            for (int i = range.start; i < range.end; ++i) {
+                cv::Mat image = cv::imread(i == 0 ? entry.left : entry.right, cv::IMREAD_GRAYSCALE);
+                if (image.data == nullptr) continue;
+                cv::remap(image, images[i], map_x_[i], map_y_[i], cv::INTER_LINEAR);
+            }
+        });
+
+        if (images[0].data == nullptr || images[1].data == nullptr) {
+            LOG(WARNING) << "cannot find images at index " << index;
+            return false;
+        }
+
+        pair.left = images[0];
+        pair.right = images[1];
+        pair.time_stamp = entry.time_stamp;
+        return true;
+    }
+
+} // namespace myslam
@@ -1,5 +1,15 @@
 #include "myslam/feature.h"
+#include "myslam/frame.h"
+#include "myslam/pool.h"
 
 namespace myslam {
 
+    Feature::Ptr Feature::Create(std::shared_ptr<Frame> frame, const cv::KeyPoint &kp) {
+        if (frame && frame->arena_) {
+            FrameArena::Ptr arena = frame->arena_;
+            return MakeInArena<Feature>(arena, frame, kp);
+        }
+        return MakePooled<Feature>(frame, kp);
+    }
+
 }
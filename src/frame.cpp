@@ -1,21 +1,59 @@
 #include "myslam/frame.h"
+#include "myslam/pool.h"
+
+#include <opencv2/video/tracking.hpp>
 
 namespace myslam {
 
     // constructor
     Frame::Frame(long id, double time_stamp, const SE3 &pose,
             const cv::Mat &left, const cv::Mat &right)
-            : id_(id), time_stamp_(time_stamp), pose_(pose),
-            left_img_(left), right_img_(right) {}
+            : id_(id), time_stamp_(time_stamp),
+            left_img_(left), right_img_(right) {
+        SetPose(pose);
+    }
 
     // create the frame, may be not the keyframe
     Frame::Ptr Frame::CreateFrame() {
             static long factory_id = 0; // static variable in a function
-            Frame::Ptr new_frame(new Frame);
+            Frame::Ptr new_frame = MakePooled<Frame>();
             new_frame->id_ = factory_id++; // pointer
+            new_frame->arena_ = MakePooled<FrameArena>();
             return new_frame;
     }
 
+    std::vector<cv::Mat> Frame::LeftPyramid(const cv::Size &win_size, int max_level) {
+        return CachedPyramid(left_img_, left_pyramid_, win_size, max_level, true);
+    }
+
+    std::vector<cv::Mat> Frame::RightPyramid(const cv::Size &win_size, int max_level) {
+        // the right image is only the next image of LK flow, derivatives are not needed
+        return CachedPyramid(right_img_, right_pyramid_, win_size, max_level, false);
+    }
+
+    void Frame::ReleasePyramids() {
+        std::unique_lock<std::mutex> lck(pyramid_mutex_);
+        // the copies handed out keep their levels alive until they are released too
+        left_pyramid_.clear();
+        right_pyramid_.clear();
+    }
+
+    std::vector<cv::Mat> Frame::CachedPyramid(const cv::Mat &img, std::vector<cv::Mat> &pyramid,
+            const cv::Size &win_size, int max_level, bool with_derivatives) {
+        std::unique_lock<std::mutex> lck(pyramid_mutex_);
+        if (pyramid_win_size_ != win_size || pyramid_max_level_ != max_level) {
+            // pyramids built with other parameters cannot be mixed in one LK call
+            left_pyramid_.clear();
+            right_pyramid_.clear();
+            pyramid_win_size_ = win_size;
+            pyramid_max_level_ = max_level;
+        }
+        if (pyramid.empty()) {
+            cv::buildOpticalFlowPyramid(img, pyramid, win_size, max_level, with_derivatives);
+        }
+        return pyramid;
+    }
+
     // set keyframe, selected from existed frames
     void Frame::SetKeyFrame() {
         /**
@@ -2,10 +2,12 @@
 
 #include "myslam/algorithm.h"
 #include "myslam/backend.h"
+#include "myslam/detector.h"
 #include "myslam/feature.h"
 #include "myslam/frontend.h"
 #include "myslam/g2o_types.h"
 #include "myslam/map.h"
+#include "myslam/profiler.h"
 #include "myslam/viewer.h"
 
 namespace myslam {
@@ -13,16 +15,56 @@ namespace myslam {
     Frontend::Frontend() {
 
         // goodFeaturesToTrack
-        gftt_ = cv::GFTTDetector::create(num_features_, 0.01, 20);
+        detector_ = Detector::Ptr(new GfttDetector(num_features_, 0.01, 20));
+    }
+
+    Frontend::~Frontend() {
+        Stop();
+    }
+
+    void Frontend::SetDetector(DetectorType type, int cell_size) {
+        if (type == DetectorType::GRID) {
+            detector_ = Detector::Ptr(new GridDetector(num_features_, cell_size, 0.01, 20));
+        } else if (type == DetectorType::SHI_TOMASI) {
+            detector_ = Detector::Ptr(new ShiTomasiDetector(num_features_, cell_size, 0.01, 20));
+        } else {
+            detector_ = Detector::Ptr(new GfttDetector(num_features_, 0.01, 20));
+        }
+    }
 
+    void Frontend::SetOpticalFlow(OpticalFlowType type, double fb_threshold) {
+        optical_flow_type_ = type;
+        klt_.SetForwardBackwardCheck(fb_threshold);
+    }
+
+    int Frontend::CalcOpticalFlow(const std::vector<cv::Mat> &prev_pyramid,
+                                  const std::vector<cv::Mat> &next_pyramid,
+                                  const std::vector<cv::Point2f> &prev_pts,
+                                  std::vector<cv::Point2f> &next_pts,
+                                  std::vector<uchar> &status) {
+        if (optical_flow_type_ == OpticalFlowType::KLT) {
+            return klt_.Track(prev_pyramid, next_pyramid, prev_pts, next_pts, status);
+        }
+
+        cv::Mat error;
+        // return status, error
+        cv::calcOpticalFlowPyrLK(
+                prev_pyramid, next_pyramid, prev_pts, next_pts, status, error,
+                lk_win_size_, lk_max_level_,
+                cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 30, 0.01),
+                cv::OPTFLOW_USE_INITIAL_FLOW);
+        return std::count(status.begin(), status.end(), 1);
     }
 
     bool Frontend::AddFrame(Frame::Ptr frame) {
+        ScopedTimer timer("frontend.add_frame");
 
         current_frame_ = frame;
+        latest_frame_id_.store(frame->id_);
 
         switch (status_) {
             case FrontendStatus::INITING:
+                WaitForKeyframeJobs();
                 StereoInit();
                 break;
 
@@ -31,15 +73,31 @@ namespace myslam {
                 Track();
                 break;
             case FrontendStatus::LOST:
+                WaitForKeyframeJobs();
                 Reset();
                 break;
         }
         // std::cout << "Adding frame, done!" << std::endl;
 
+        // keyframes keep their pyramids until they are removed from the active window
+        if (last_frame_ && !last_frame_->is_keyframe_) {
+            last_frame_->ReleasePyramids();
+        }
         last_frame_ = current_frame_;
         return true; // status: TRACKING_GOOD
     }
 
+    void Frontend::Stop() {
+        if (!keyframe_thread_.joinable()) return; // not pipelined, or stopped already
+        WaitForKeyframeJobs();
+        {
+            std::unique_lock<std::mutex> lck(keyframe_mutex_);
+            keyframe_running_.store(false);
+        }
+        keyframe_cv_.notify_one();
+        keyframe_thread_.join();
+    }
+
     bool Frontend::Track() {
 
         if (last_frame_) {
@@ -54,6 +112,8 @@ namespace myslam {
         int num_track_last = TrackLastFrame();
 
         tracking_inliers_ = EstimateCurrentPose();
+        Profiler::Instance().RecordCounter("frontend.tracked_features", num_track_last);
+        Profiler::Instance().RecordCounter("frontend.inliers", tracking_inliers_);
 
         // [20, 50]
         if (tracking_inliers_ > num_features_tracking_) {
@@ -70,12 +130,13 @@ namespace myslam {
             status_ = FrontendStatus::LOST;
         }
 
-        InsertKeyframe();
+        bool queued = InsertKeyframe() && pipelined_;
 
         // calculate the relative motion, inverse() is important
         relative_motion_ = current_frame_->Pose() * last_frame_->Pose().inverse();
 
-        if (viewer_) viewer_->AddCurrentFrame(current_frame_);
+        // the job of a queued keyframe still appends to its features, the worker publishes it when done
+        if (viewer_ && !queued) viewer_->AddCurrentFrame(current_frame_);
 
         return true;
     }
@@ -86,6 +147,11 @@ namespace myslam {
             // still have enough features, don't insert keyframe
             return false;
         }
+        if (degraded_.load() && tracking_inliers_ > num_features_tracking_) {
+            // late and still tracking good, the keyframe is left to a frame on time
+            Profiler::Instance().RecordCounter("frontend.deferred_keyframes", 1);
+            return false;
+        }
 
         /**
          * if the tracking_inliers_ is relative small
@@ -93,27 +159,95 @@ namespace myslam {
          * then insert the current frame into keyframes group
          */
 
+        // the map may remove an old keyframe here and walk its features, which a job must not be
+        // appending to; TrackLastFrame() has waited already, so this does not block
+        WaitForKeyframeJobs();
+
         current_frame_->SetKeyFrame();
         map_->InsertKeyFrame(current_frame_);
         LOG(INFO) << "Set frame " << current_frame_->id_ << " as keyframe "
                     << current_frame_->keyframe_id_;
 
-        // step 1: detect and extract new features
         SetObservationsForKeyFrame();
-        DetectFeatures();
+
+        if (!pipelined_) {
+            ProcessKeyframe(current_frame_);
+            return true;
+        }
+
+        /**
+         * the keyframe job only appends features to current_frame_,
+         * the features it has now are kept aside, so that the next frame
+         * can track them while the job is running
+         */
+        pending_keyframe_.frame = current_frame_;
+        pending_keyframe_.tracked_features = current_frame_->features_left_;
+
+        if (!keyframe_thread_.joinable()) {
+            // the worker starts with the first job
+            keyframe_running_.store(true);
+            keyframe_thread_ = std::thread(std::bind(&Frontend::KeyframeLoop, this));
+        }
+        std::unique_lock<std::mutex> lck(keyframe_mutex_);
+        keyframe_queue_.push_back({current_frame_, pending_keyframe_.tracked_features.size()});
+        keyframe_cv_.notify_one();
+
+        return true;
+    }
+
+    void Frontend::ProcessKeyframe(Frame::Ptr frame, size_t first_feature) {
+        ScopedTimer timer("frontend.process_keyframe");
+
+        // step 1: detect and extract new features
+        DetectFeatures(frame);
 
         // step 2.1: find the corresponding features in right image
-        FindFeaturesInRight();
+        FindFeaturesInRight(frame);
         // step 2.2: triangulate map points, and compute new landmarks
-        TriangulateNewPoints();
+        TriangulateNewPoints(frame, first_feature);
 
         // step 3: add the new keyframe and landmarks into the map,
         //         and activate a backend optimization process
-        backend_->UpdateMap();
+        RequestBackendUpdate();
 
         if (viewer_) viewer_->UpdateMap();
+    }
 
-        return true;
+    void Frontend::RequestBackendUpdate() {
+        unsigned long generation = backend_->UpdateMap();
+        if (backend_wait_ms_ > 0 && !degraded_.load() &&
+            !backend_->WaitForGeneration(generation, std::chrono::milliseconds(backend_wait_ms_))) {
+            LOG(INFO) << "Backend generation " << generation << " not done in " << backend_wait_ms_ << " ms";
+        }
+    }
+
+    void Frontend::KeyframeLoop() {
+        while (true) {
+            std::pair<Frame::Ptr, size_t> job;
+            {
+                std::unique_lock<std::mutex> lck(keyframe_mutex_);
+                keyframe_cv_.wait(lck, [this] {
+                    return !keyframe_queue_.empty() || !keyframe_running_.load();
+                });
+                if (keyframe_queue_.empty()) break; // stopped
+                job = keyframe_queue_.front();
+            }
+
+            ProcessKeyframe(job.first, job.second);
+            // unless the tracker has published a newer frame meanwhile
+            if (viewer_ && job.first->id_ >= latest_frame_id_.load()) viewer_->AddCurrentFrame(job.first);
+
+            std::unique_lock<std::mutex> lck(keyframe_mutex_);
+            keyframe_queue_.pop_front();
+            keyframe_done_.notify_all();
+        }
+    }
+
+    void Frontend::WaitForKeyframeJobs() {
+        ScopedTimer timer("frontend.wait_keyframe_jobs");
+        std::unique_lock<std::mutex> lck(keyframe_mutex_);
+        keyframe_done_.wait(lck, [this] { return keyframe_queue_.empty(); });
+        pending_keyframe_ = PendingKeyframe();
     }
 
     void Frontend::SetObservationsForKeyFrame() {
@@ -128,64 +262,74 @@ namespace myslam {
 
     }
 
-    int Frontend::TriangulateNewPoints() {
+    int Frontend::TriangulateNewPoints(Frame::Ptr frame, size_t first_feature) {
+        ScopedTimer timer("frontend.triangulate_new_points");
 
-        std::vector<SE3> poses{camera_left_->pose(), camera_right_->pose()};
+        SE3 current_pose_Twc = frame->Pose().inverse();
 
-        SE3 current_pose_Twc = current_frame_->Pose().inverse();
+        /**
+         * For each feature in current frame,
+         * if there is no associated 3D MapPoint/landmark
+         * corresponding to the feature in the left image,
+         * and there is a corresponding feature in right image,
+         * then, use triangulation to estimate the MapPoint/landmark,
+         * and finally, insert the new MapPoint/landmark into the existed map
+         */
+        std::vector<size_t> feature_indices;
+        triangulation_batch_.Clear();
+        for (size_t i = first_feature; i < frame->features_left_.size(); ++i) {
+            if (frame->features_left_[i]->map_point_.expired() &&
+                frame->features_right_[i] != nullptr) {
+                // features are represented by camera coordinate
+                triangulation_batch_.Add(
+                        camera_left_->pixel2camera(toVec2(frame->features_left_[i]->position_.pt)),
+                        camera_right_->pixel2camera(toVec2(frame->features_right_[i]->position_.pt)));
+                feature_indices.push_back(i);
+            }
+        }
+        triangulation(camera_left_->pose(), camera_right_->pose(), triangulation_batch_);
 
         int cnt_triangulated_pts = 0;
+        std::vector<MapPoint::Ptr> new_map_points;
 
-        for (size_t i = 0; i < current_frame_->features_left_.size(); ++i) {
-            /**
-             * For each feature in current frame,
-             * if there is no associated 3D MapPoint/landmark
-             * corresponding to the feature in the left image,
-             * and there is a corresponding feature in right image,
-             * then, use triangulation to estimate the MapPoint/landmark,
-             * and finally, insert the new MapPoint/landmark into the existed map
-             */
-            if (current_frame_->features_left_[i]->map_point_.expired() &&
-                current_frame_->features_right_[i] != nullptr) {
-
-                std::vector<Vec3> points{
-                    camera_left_->pixel2camera( // feature is represented by camera coordinate
-                            Vec2(current_frame_->features_left_[i]->position_.pt.x,
-                                    current_frame_->features_left_[i]->position_.pt.y)),
-                    camera_right_->pixel2camera( // feature is represented by camera coordinate
-                            Vec2(current_frame_->features_right_[i]->position_.pt.x,
-                                 current_frame_->features_right_[i]->position_.pt.y))
-                };
-
-                // 3D point in the camera coordinate
-                Vec3 pworld = Vec3::Zero();
-
-                if (triangulation(poses, points, pworld) && pworld[2] > 0) {
-                    // if triangulation is successful, and pworld is the new calculated MapPoint/landmark
-                    auto new_map_point = MapPoint::CreateNewMappoint();
-                    pworld = current_pose_Twc * pworld; // in the world coordinate
-                    new_map_point->SetPos(pworld);
-
-                    // link the new 3D MapPoint/landmark and features of left and right current frames
-                    new_map_point->AddObservation(current_frame_->features_left_[i]);
-                    new_map_point->AddObservation(current_frame_->features_right_[i]);
-                    current_frame_->features_left_[i]->map_point_ = new_map_point;
-                    current_frame_->features_right_[i]->map_point_ = new_map_point;
-
-                    // insert the new 3D MapPoint/landmark into the existed map
-                    map_->InsertMapPoint(new_map_point);
-
-                    cnt_triangulated_pts++;
-                }
+        for (size_t k = 0; k < feature_indices.size(); ++k) {
+            size_t i = feature_indices[k];
+
+            // 3D point in the camera coordinate
+            Vec3 pworld = triangulation_batch_.Point(k);
+
+            if (triangulation_batch_.success[k] && pworld[2] > 0) {
+                // if triangulation is successful, and pworld is the new calculated MapPoint/landmark
+                auto new_map_point = MapPoint::CreateNewMappoint();
+                pworld = current_pose_Twc * pworld; // in the world coordinate
+                new_map_point->SetPos(pworld);
+
+                // link the new 3D MapPoint/landmark and features of left and right current frames
+                new_map_point->AddObservation(frame->features_left_[i]);
+                new_map_point->AddObservation(frame->features_right_[i]);
+                frame->features_left_[i]->map_point_ = new_map_point;
+                frame->features_right_[i]->map_point_ = new_map_point;
+
+                new_map_points.push_back(new_map_point);
+
+                cnt_triangulated_pts++;
             }
         }
+        // insert the new 3D MapPoints/landmarks into the existed map, published once
+        map_->InsertMapPoints(new_map_points);
 
         LOG(INFO) << "There are " << cnt_triangulated_pts << " new landmarks inserted into the existed 3D map.";
+        Profiler::Instance().RecordCounter("frontend.new_landmarks", cnt_triangulated_pts);
 
         return cnt_triangulated_pts;
     }
 
     int Frontend::EstimateCurrentPose() {
+        ScopedTimer timer("frontend.estimate_current_pose");
+        if (pose_solver_type_ == PoseSolverType::DIRECT) {
+            return EstimateCurrentPoseDirect();
+        }
+
         // setup g2o
         typedef g2o::BlockSolver_6_3 BlockSolverType;
         typedef g2o::LinearSolverDense<BlockSolverType::PoseMatrixType> LinearSolverType;
@@ -211,30 +355,40 @@ namespace myslam {
         std::vector<EdgeProjectionPoseOnly *> edges;
         std::vector<Feature::Ptr> features;
 
+        // landmark positions of one backend commit
+        std::vector<Vec3> positions;
+        map_->ConsistentRead([&] {
+            features.clear();
+            positions.clear();
+            for (auto &feat : current_frame_->features_left_) {
+                auto mp = feat->map_point_.lock();
+                if (mp) {
+                    features.push_back(feat);
+                    positions.push_back(mp->Pos());
+                }
+            }
+        });
+
         // many 2D features correspond to many MapPoints/landmarks
         // each edge corresponds to a MapPoint-2D features, id is index (index++)
         // all these edges correspond to only one camera pose
-        for (size_t i = 0; i < current_frame_->features_left_.size(); ++i) {
-            auto mp = current_frame_->features_left_[i]->map_point_.lock();
-            if (mp) {
-                features.push_back(current_frame_->features_left_[i]);
-                EdgeProjectionPoseOnly* edge = new EdgeProjectionPoseOnly(mp->pos_, K);
-                edge->setId(index);
+        for (size_t i = 0; i < features.size(); ++i) {
+            EdgeProjectionPoseOnly* edge = new EdgeProjectionPoseOnly(positions[i], K);
+            edge->setId(index);
 
-                // set the connected vertex
-                edge->setVertex(0, vertex_pose); // only for camera pose
+            // set the connected vertex
+            edge->setVertex(0, vertex_pose); // only for camera pose
 
-                // set measurement/practical value, z
-                edge->setMeasurement(toVec2(current_frame_->features_left_[i]->position_.pt));
+            // set measurement/practical value, z
+            edge->setMeasurement(toVec2(features[i]->position_.pt));
 
-                // information matrix
-                edge->setInformation(Eigen::Matrix2d::Identity());
+            // information matrix
+            edge->setInformation(Eigen::Matrix2d::Identity());
 
-                edge->setRobustKernel(new g2o::RobustKernelHuber);
-                edges.push_back(edge);
-                optimizer.addEdge(edge);
-                index++;
-            }
+            edge->setRobustKernel(new g2o::RobustKernelHuber);
+            edges.push_back(edge);
+            optimizer.addEdge(edge);
+            index++;
         }
 
         // determine the outliers
@@ -286,10 +440,73 @@ namespace myslam {
         return features.size() - cnt_outlier;
     }
 
+    int Frontend::EstimateCurrentPoseDirect() {
+        pose_solver_.SetCamera(camera_left_->K());
+        // landmark positions of one backend commit
+        map_->ConsistentRead([&] {
+            pose_solver_.Clear();
+            pose_features_.clear();
+            for (auto &feat : current_frame_->features_left_) {
+                auto mp = feat->map_point_.lock();
+                if (mp) {
+                    pose_features_.push_back(feat);
+                    pose_solver_.AddObservation(mp->Pos(), toVec2(feat->position_.pt));
+                }
+            }
+        });
+
+        SE3 pose = current_frame_->Pose();
+        int cnt_inlier = pose_solver_.Solve(pose);
+
+        LOG(INFO) << "Outlier/Inlier in pose estimating: "
+                  << pose_features_.size() - cnt_inlier << "/" << cnt_inlier;
+
+        current_frame_->SetPose(pose);
+
+        LOG(INFO) << "Current Pose = \n" << current_frame_->Pose().matrix();
+
+        for (size_t i = 0; i < pose_features_.size(); ++i) {
+            if (pose_solver_.IsOutlier(i)) {
+                pose_features_[i]->map_point_.reset();
+            }
+        }
+        pose_features_.clear();
+
+        return cnt_inlier;
+    }
+
     int Frontend::TrackLastFrame() {
-        // use LK flow to estimate 2D features in the right frame
+        ScopedTimer timer("frontend.track_last_frame");
+
+        // step 1: track the features of last frame, the job of a keyframe may still append to them
+        int num_good_pts;
+        if (pending_keyframe_.frame == last_frame_) {
+            num_good_pts = TrackFeatures(last_frame_, pending_keyframe_.tracked_features);
+        } else {
+            num_good_pts = TrackFeatures(last_frame_, last_frame_->features_left_);
+        }
+
+        // step 2: wait for the job of the last keyframe and track the features it created,
+        // so that they count in the keyframe decision and mask the detection of this frame
+        if (pending_keyframe_.frame) {
+            Frame::Ptr keyframe = pending_keyframe_.frame;
+            const size_t first_new = pending_keyframe_.tracked_features.size();
+            WaitForKeyframeJobs();
+            std::vector<Feature::Ptr> new_features(keyframe->features_left_.begin() + first_new,
+                                                   keyframe->features_left_.end());
+            if (!new_features.empty()) {
+                num_good_pts += TrackFeatures(keyframe, new_features);
+            }
+        }
+
+        return num_good_pts;
+    }
+
+    int Frontend::TrackFeatures(Frame::Ptr from, const std::vector<Feature::Ptr> &last_features) {
+        // use LK flow to estimate 2D features in the current frame
         std::vector<cv::Point2f> kps_last, kps_current;
-        for (auto &kp : last_frame_->features_left_) {
+        const SE3 pose = current_frame_->Pose();
+        for (auto &kp : last_features) {
             if (kp->map_point_.lock()) {
                 /**
                  * public member function
@@ -324,7 +541,7 @@ namespace myslam {
                  */
                 // use project point
                 auto mp = kp->map_point_.lock();
-                auto px = camera_left_->world2pixel(mp->pos_, current_frame_->Pose());
+                auto px = camera_left_->world2pixel(mp->Pos(), pose);
                 kps_last.push_back(kp->position_.pt);
                 kps_current.push_back(cv::Point2f(px[0], px[1]));
             } else {
@@ -334,12 +551,10 @@ namespace myslam {
         }
 
         std::vector<uchar> status;
-        cv::Mat error;
-        cv::calcOpticalFlowPyrLK(
-                last_frame_->left_img_, current_frame_->left_img_, kps_last,
-                kps_current, status, error, cv::Size(11, 11), 3,
-                cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 30, 0.01),
-                cv::OPTFLOW_USE_INITIAL_FLOW);
+        // the pyramid of last frame is cached since it was the current frame, keyframes keep theirs
+        CalcOpticalFlow(from->LeftPyramid(lk_win_size_, lk_max_level_),
+                        current_frame_->LeftPyramid(lk_win_size_, lk_max_level_),
+                        kps_last, kps_current, status);
 
         int num_good_pts = 0;
 
@@ -364,8 +579,8 @@ namespace myslam {
                  *    int _class_id = -1
                  *    );
                  */
-                Feature::Ptr feature(new Feature(current_frame_, kp));
-                feature->map_point_ = last_frame_->features_left_[i]->map_point_;
+                Feature::Ptr feature = Feature::Create(current_frame_, kp);
+                feature->map_point_ = last_features[i]->map_point_;
                 current_frame_->features_left_.push_back(feature);
                 num_good_pts++;
             }
@@ -376,8 +591,8 @@ namespace myslam {
     }
 
     bool Frontend::StereoInit() {
-        int num_features_left = DetectFeatures();
-        int num_coor_features = FindFeaturesInRight();
+        int num_features_left = DetectFeatures(current_frame_);
+        int num_coor_features = FindFeaturesInRight(current_frame_);
         if (num_coor_features < num_features_init_)
             return false;
 
@@ -393,35 +608,38 @@ namespace myslam {
         return false;
     }
 
-    int Frontend::DetectFeatures() {
-        cv::Mat mask(current_frame_->left_img_.size(), CV_8UC1, 255);
-        for (auto &feat : current_frame_->features_left_) {
-            cv::rectangle(mask, feat->position_.pt - cv::Point2f(10, 10),
-                    feat->position_.pt + cv::Point2f(10, 10), 0, cv::FILLED);
+    int Frontend::DetectFeatures(Frame::Ptr frame) {
+        ScopedTimer timer("frontend.detect_features");
+        std::vector<cv::Point2f> existing;
+        existing.reserve(frame->features_left_.size());
+        for (auto &feat : frame->features_left_) {
+            existing.push_back(feat->position_.pt);
         }
 
         std::vector<cv::KeyPoint> keypoints;
-        gftt_->detect(current_frame_->left_img_, keypoints, mask);
+        detector_->Detect(frame->left_img_, existing, keypoints);
         int cnt_detected = 0;
         for (auto &kp : keypoints) {
-            current_frame_->features_left_.push_back(
-                    Feature::Ptr(new Feature(current_frame_, kp)));
+            frame->features_left_.push_back(Feature::Create(frame, kp));
             cnt_detected++;
         }
 
         LOG(INFO) << "Detect " << cnt_detected << " new features.";
+        Profiler::Instance().RecordCounter("frontend.detected_features", cnt_detected);
         return cnt_detected;
     }
 
-    int Frontend::FindFeaturesInRight() {
+    int Frontend::FindFeaturesInRight(Frame::Ptr frame) {
+        ScopedTimer timer("frontend.find_features_in_right");
         // use LK flow to estimate points in the right image
         std::vector<cv::Point2f> kps_left, kps_right;
-        for (auto &kp : current_frame_->features_left_) {
+        const SE3 pose = frame->Pose();
+        for (auto &kp : frame->features_left_) {
             kps_left.push_back(kp->position_.pt);
             auto mp = kp->map_point_.lock();
             if (mp) {
                 // use projected points as initial value
-                auto px = camera_right_->world2pixel(mp->pos_, current_frame_->Pose());
+                auto px = camera_right_->world2pixel(mp->Pos(), pose);
                 kps_right.push_back(cv::Point2f(px[0], px[1]));
             } else {
                 // use the pixel as same as the left image
@@ -430,47 +648,59 @@ namespace myslam {
         }
 
         std::vector<uchar> status;
-        cv::Mat error;
-        // return status, error
-        cv::calcOpticalFlowPyrLK(
-                current_frame_->left_img_, current_frame_->right_img_, kps_left,
-                kps_right, status, error, cv::Size(11, 11), 3,
-                cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS,
-                        30, 0.01), cv::OPTFLOW_USE_INITIAL_FLOW);
+        if (stereo_matching_type_ == StereoMatchingType::SCANLINE) {
+            // rectified pair, the disparity of the initial values bounds the search
+            std::vector<float> predicted_disparity(kps_left.size(), -1);
+            for (size_t i = 0; i < kps_left.size(); ++i) {
+                if (!frame->features_left_[i]->map_point_.expired()) {
+                    predicted_disparity[i] = kps_left[i].x - kps_right[i].x;
+                }
+            }
+            stereo_matcher_.Match(frame->left_img_, frame->right_img_, kps_left,
+                                  predicted_disparity, kps_right, status);
+        } else {
+            CalcOpticalFlow(frame->LeftPyramid(lk_win_size_, lk_max_level_),
+                            frame->RightPyramid(lk_win_size_, lk_max_level_),
+                            kps_left, kps_right, status);
+        }
 
         int num_good_pts = 0;
         for (size_t i = 0; i < status.size(); ++i) {
             if (status[i]) {
                 cv::KeyPoint kp(kps_right[i], 7);
-                Feature::Ptr feat(new Feature(current_frame_, kp));
+                Feature::Ptr feat = Feature::Create(frame, kp);
                 feat->is_on_left_image_ = false;
-                current_frame_->features_right_.push_back(feat);
+                frame->features_right_.push_back(feat);
                 num_good_pts++;
             } else {
-                current_frame_->features_right_.push_back(nullptr);
+                frame->features_right_.push_back(nullptr);
             }
         }
         LOG(INFO) << "Find " << num_good_pts << " in the right image.";
+        Profiler::Instance().RecordCounter("frontend.right_features", num_good_pts);
         return num_good_pts;
     }
 
     bool Frontend::BuildInitMap() {
-        std::vector<SE3> poses{camera_left_->pose(), camera_right_->pose()};
-        size_t cnt_init_landmarks = 0;
+        std::vector<size_t> feature_indices;
+        triangulation_batch_.Clear();
         for (size_t i = 0; i < current_frame_->features_left_.size(); ++i) {
             if (current_frame_->features_right_[i] == nullptr) continue;
             // create map point from triangulation
-            std::vector<Vec3> points{
-                camera_left_->pixel2camera(
-                        Vec2(current_frame_->features_left_[i]->position_.pt.x,
-                                current_frame_->features_left_[i]->position_.pt.y)),
-                camera_right_->pixel2camera(
-                        Vec2(current_frame_->features_right_[i]->position_.pt.x,
-                             current_frame_->features_right_[i]->position_.pt.y))
-            };
-            Vec3 pworld = Vec3 ::Zero();
-
-            if (triangulation(poses, points, pworld) && pworld[2] > 0) {
+            triangulation_batch_.Add(
+                    camera_left_->pixel2camera(toVec2(current_frame_->features_left_[i]->position_.pt)),
+                    camera_right_->pixel2camera(toVec2(current_frame_->features_right_[i]->position_.pt)));
+            feature_indices.push_back(i);
+        }
+        triangulation(camera_left_->pose(), camera_right_->pose(), triangulation_batch_);
+
+        size_t cnt_init_landmarks = 0;
+        std::vector<MapPoint::Ptr> new_map_points;
+        for (size_t k = 0; k < feature_indices.size(); ++k) {
+            size_t i = feature_indices[k];
+            Vec3 pworld = triangulation_batch_.Point(k);
+
+            if (triangulation_batch_.success[k] && pworld[2] > 0) {
                 auto new_map_point = MapPoint::CreateNewMappoint();
                 new_map_point->SetPos(pworld);
                 new_map_point->AddObservation(current_frame_->features_left_[i]);
@@ -478,12 +708,13 @@ namespace myslam {
                 current_frame_->features_left_[i]->map_point_ = new_map_point;
                 current_frame_->features_right_[i]->map_point_ = new_map_point;
                 cnt_init_landmarks++;
-                map_->InsertMapPoint(new_map_point);
+                new_map_points.push_back(new_map_point);
             }
         }
+        map_->InsertMapPoints(new_map_points);
         current_frame_->SetKeyFrame();
         map_->InsertKeyFrame(current_frame_);
-        backend_->UpdateMap();
+        RequestBackendUpdate();
 
         LOG(INFO) << "Initial map created with " << cnt_init_landmarks << " map points";
 
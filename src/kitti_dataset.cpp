@@ -0,0 +1,94 @@
+#include "myslam/kitti_dataset.h"
+
+#include <boost/format.hpp>
+#include <fstream>
+#include <opencv2/opencv.hpp>
+
+namespace myslam {
+    KittiDataset::KittiDataset(const std::string &dataset_path) : Dataset(dataset_path) {}
+
+    KittiDataset::~KittiDataset() {
+        StopLoader();
+    }
+
+    bool KittiDataset::Open() {
+        // read camera intrinsics and extrinsics
+        std::ifstream fin(dataset_path_ + "/calib.txt"); // read file
+        if (!fin) {
+            LOG(ERROR) << "cannot find " << dataset_path_ << "/calib.txt!";
+            return false;
+        }
+
+        /**
+         * camera_name: K, t
+         * P0: 7.070912000000e+02 0.000000000000e+00 6.018873000000e+02 0.000000000000e+00
+         *     0.000000000000e+00 7.070912000000e+02 1.831104000000e+02 0.000000000000e+00
+         *     0.000000000000e+00 0.000000000000e+00 1.000000000000e+00 0.000000000000e+00
+         * P1: 7.070912000000e+02 0.000000000000e+00 6.018873000000e+02 -3.798145000000e+02
+         *     0.000000000000e+00 7.070912000000e+02 1.831104000000e+02 0.000000000000e+00
+         *     0.000000000000e+00 0.000000000000e+00 1.000000000000e+00 0.000000000000e+00
+         * P2: 7.070912000000e+02 0.000000000000e+00 6.018873000000e+02 4.688783000000e+01
+         *     0.000000000000e+00 7.070912000000e+02 1.831104000000e+02 1.178601000000e-01
+         *     0.000000000000e+00 0.000000000000e+00 1.000000000000e+00 6.203223000000e-03
+         * P3: 7.070912000000e+02 0.000000000000e+00 6.018873000000e+02 -3.334597000000e+02
+         *     0.000000000000e+00 7.070912000000e+02 1.831104000000e+02 1.930130000000e+00
+         *     0.000000000000e+00 0.000000000000e+00 1.000000000000e+00 3.318498000000e-03
+         */
+        for (int i = 0; i < 4; ++i) {
+            char camera_name[3];
+            for (int k = 0; k < 3; ++k) {
+                fin >> camera_name[k]; // read file
+                // std::cout << camera_name[k] << std::endl;
+            }
+            double projection_data[12];
+            for (int k = 0; k < 12; ++k) {
+                fin >> projection_data[k];
+            }
+            Mat33 K;
+            K << projection_data[0], projection_data[1], projection_data[2],
+                 projection_data[4], projection_data[5], projection_data[6],
+                 projection_data[8], projection_data[9], projection_data[10];
+            Vec3 t;
+            t << projection_data[3], projection_data[7], projection_data[11];
+            t = K.inverse() * t;
+            K = K * 0.5;
+            Camera::Ptr new_camera(new Camera(K(0, 0), K(1, 1), K(0, 2), K(1, 2),
+                    t.norm(), SE3(SO3(), t)));
+            cameras_.push_back(new_camera);
+            LOG(INFO) << "Camera " << i << " extrinsics: " << t.transpose();
+        }
+        fin.close();
+
+        // one time stamp in s per line, the sequences are recorded at 10 Hz if it is missing
+        time_stamps_.clear();
+        std::ifstream times(dataset_path_ + "/times.txt");
+        for (double t; times >> t;) time_stamps_.push_back(t);
+        if (time_stamps_.empty()) LOG(WARNING) << "cannot find " << dataset_path_ << "/times.txt, assume 10 Hz";
+        return true;
+    }
+
+    bool KittiDataset::ReadStereoPair(int index, StereoPair &pair) {
+        cv::Mat images[2];
+        // left and right images are decoded and downscaled in parallel
+        cv::parallel_for_(cv::Range(0, 2), [&](const cv::Range &range) {
+            for (int i = range.start; i < range.end; ++i) {
+                boost::format fmt("%s/image_%d/%06d.png");
+                cv::Mat image = cv::imread((fmt % dataset_path_ % i % index).str(),
+                                           cv::IMREAD_GRAYSCALE);
+                if (image.data == nullptr) continue;
+                cv::resize(image, images[i], cv::Size(), 0.5, 0.5, cv::INTER_NEAREST);
+            }
+        });
+
+        if (images[0].data == nullptr || images[1].data == nullptr) {
+            LOG(WARNING) << "cannot find images at index " << index;
+            return false;
+        }
+
+        pair.left = images[0];
+        pair.right = images[1];
+        pair.time_stamp = size_t(index) < time_stamps_.size() ? time_stamps_[index] : index * 0.1;
+        return true;
+    }
+
+} // namespace myslam
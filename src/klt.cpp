@@ -0,0 +1,199 @@
+#include "myslam/klt.h"
+
+#include <cfloat>
+#include <cmath>
+#include <opencv2/core/utility.hpp>
+
+namespace myslam {
+
+    namespace {
+
+        // patch buffers of a thread, reused between points and calls
+        struct KltScratch {
+            std::vector<float> patch; // template with 1 pixel margin for the gradient
+            std::vector<float> ix, iy; // template gradient
+        };
+
+        KltScratch &Scratch() {
+            thread_local KltScratch scratch;
+            return scratch;
+        }
+
+        /**
+         * @details bilinear interpolation of a cols x rows patch with top-left at (x, y)
+         * @details the rows are contiguous, the inner loop is vectorized by the compiler
+         */
+        void InterpolatePatch(const cv::Mat &img, float x, float y, int cols, int rows, float *patch) {
+            int ix = std::floor(x), iy = std::floor(y);
+            float a = x - ix, b = y - iy;
+            const float w00 = (1 - a) * (1 - b), w01 = a * (1 - b), w10 = (1 - a) * b, w11 = a * b;
+            const size_t step = img.step;
+            // the pixels may be in the border of the level, outside of the Mat header
+            const uchar *src = img.data + std::ptrdiff_t(iy) * std::ptrdiff_t(step) + ix;
+            for (int r = 0; r < rows; ++r, src += step) {
+                const uchar *p0 = src, *p1 = src + step;
+                float *out = patch + r * cols;
+                for (int c = 0; c < cols; ++c) {
+                    out[c] = w00 * p0[c] + w01 * p0[c + 1] + w10 * p1[c] + w11 * p1[c + 1];
+                }
+            }
+        }
+
+        // true if the cols x rows patch at (x, y) and its interpolation neighbours can be read
+        template <typename Level>
+        bool Inside(const Level &level, float x, float y, int cols, int rows) {
+            int ix = std::floor(x), iy = std::floor(y);
+            return ix >= level.x_min && iy >= level.y_min &&
+                   ix + cols + 1 <= level.x_max && iy + rows + 1 <= level.y_max;
+        }
+
+    } // namespace
+
+    std::vector<KltTracker::Level> KltTracker::Levels(const std::vector<cv::Mat> &pyramid) {
+        // pyramids with derivatives interleave image and derivative levels
+        size_t step = (pyramid.size() > 1 && pyramid[1].type() == CV_16SC2) ? 2 : 1;
+        std::vector<Level> levels;
+        for (size_t i = 0; i < pyramid.size(); i += step) {
+            const cv::Mat &img = pyramid[i];
+            cv::Size whole;
+            cv::Point ofs;
+            img.locateROI(whole, ofs);
+            levels.push_back({&img, -ofs.x, -ofs.y, whole.width - ofs.x, whole.height - ofs.y});
+        }
+        return levels;
+    }
+
+    bool KltTracker::TrackPoint(const Level *prev_levels, const Level *next_levels, int num_levels,
+                                const cv::Point2f &prev_pt, cv::Point2f &next_pt) const {
+        const int w = win_size_.width, h = win_size_.height;
+        const cv::Point2f half_win((w - 1) * 0.5f, (h - 1) * 0.5f);
+        // cv::calcOpticalFlowPyrLK default minEigThreshold, its matrix is scaled by 1 / 1024
+        const float min_eig_threshold = 1e-4f * 1024 * w * h;
+        const float eps2 = epsilon_ * epsilon_;
+
+        KltScratch &scratch = Scratch();
+        scratch.patch.resize((w + 2) * (h + 2));
+        scratch.ix.resize(w * h);
+        scratch.iy.resize(w * h);
+        float *patch = scratch.patch.data(), *ix = scratch.ix.data(), *iy = scratch.iy.data();
+
+        cv::Point2f next = next_pt * (1.0f / (1 << (num_levels - 1)));
+        for (int level = num_levels - 1; level >= 0; --level) {
+            const Level &prev_level = prev_levels[level], &next_level = next_levels[level];
+            if (level != num_levels - 1) next *= 2.0f;
+            cv::Point2f prev = prev_pt * (1.0f / (1 << level)) - half_win;
+            next -= half_win;
+
+            // template and its Scharr gradient, on the patch with 1 pixel margin
+            if (!Inside(prev_level, prev.x - 1, prev.y - 1, w + 2, h + 2)) {
+                if (level == 0) return false;
+                next += half_win;
+                continue;
+            }
+            InterpolatePatch(*prev_level.img, prev.x - 1, prev.y - 1, w + 2, h + 2, patch);
+            float a11 = 0, a12 = 0, a22 = 0;
+            const int ps = w + 2;
+            for (int r = 0; r < h; ++r) {
+                const float *p0 = patch + r * ps, *p1 = p0 + ps, *p2 = p1 + ps;
+                float *gx = ix + r * w, *gy = iy + r * w;
+                for (int c = 0; c < w; ++c) {
+                    gx[c] = (3 * (p0[c + 2] - p0[c]) + 10 * (p1[c + 2] - p1[c]) + 3 * (p2[c + 2] - p2[c])) *
+                            (1.0f / 32);
+                    gy[c] = (3 * (p2[c] - p0[c]) + 10 * (p2[c + 1] - p0[c + 1]) + 3 * (p2[c + 2] - p0[c + 2])) *
+                            (1.0f / 32);
+                }
+                for (int c = 0; c < w; ++c) {
+                    a11 += gx[c] * gx[c];
+                    a12 += gx[c] * gy[c];
+                    a22 += gy[c] * gy[c];
+                }
+            }
+
+            float det = a11 * a22 - a12 * a12;
+            float min_eig = (a22 + a11 - std::sqrt((a11 - a22) * (a11 - a22) + 4 * a12 * a12)) * 0.5f;
+            if (min_eig < min_eig_threshold || det < FLT_EPSILON) {
+                if (level == 0) return false;
+                next += half_win;
+                continue;
+            }
+            det = 1.0f / det;
+
+            cv::Point2f prev_delta;
+            for (int j = 0; j < max_iterations_; ++j) {
+                if (!Inside(next_level, next.x, next.y, w, h)) {
+                    if (level == 0) return false;
+                    break;
+                }
+
+                // residual against the interpolated patch of the next image
+                int jx = std::floor(next.x), jy = std::floor(next.y);
+                float a = next.x - jx, b = next.y - jy;
+                const float w00 = (1 - a) * (1 - b), w01 = a * (1 - b), w10 = (1 - a) * b, w11 = a * b;
+                const size_t step = next_level.img->step;
+                const uchar *src = next_level.img->data + std::ptrdiff_t(jy) * std::ptrdiff_t(step) + jx;
+                const float *t = patch + ps + 1;
+                float b1 = 0, b2 = 0;
+                for (int r = 0; r < h; ++r, src += step, t += ps) {
+                    const uchar *q0 = src, *q1 = src + step;
+                    const float *gx = ix + r * w, *gy = iy + r * w;
+                    for (int c = 0; c < w; ++c) {
+                        float diff = w00 * q0[c] + w01 * q0[c + 1] + w10 * q1[c] + w11 * q1[c + 1] - t[c];
+                        b1 += diff * gx[c];
+                        b2 += diff * gy[c];
+                    }
+                }
+
+                cv::Point2f delta((a12 * b2 - a22 * b1) * det, (a12 * b1 - a11 * b2) * det);
+                next += delta;
+                // converged
+                if (delta.x * delta.x + delta.y * delta.y <= eps2) break;
+                // oscillating around the minimum
+                if (j > 0 && std::abs(delta.x + prev_delta.x) < 0.01f &&
+                    std::abs(delta.y + prev_delta.y) < 0.01f) {
+                    next -= delta * 0.5f;
+                    break;
+                }
+                prev_delta = delta;
+            }
+            next += half_win;
+        }
+
+        next_pt = next;
+        return true;
+    }
+
+    int KltTracker::Track(const std::vector<cv::Mat> &prev_pyramid, const std::vector<cv::Mat> &next_pyramid,
+                          const std::vector<cv::Point2f> &prev_pts, std::vector<cv::Point2f> &next_pts,
+                          std::vector<uchar> &status) const {
+        std::vector<Level> prev_levels = Levels(prev_pyramid), next_levels = Levels(next_pyramid);
+        const int num_levels = std::min(prev_levels.size(), next_levels.size());
+        const int n = prev_pts.size();
+        status.assign(n, 0);
+        next_pts.resize(n);
+        if (num_levels == 0 || n == 0) return 0;
+
+        const float fb_threshold2 = fb_threshold_ * fb_threshold_;
+        // batches of 16 points
+        cv::parallel_for_(cv::Range(0, n), [&](const cv::Range &range) {
+            for (int i = range.start; i < range.end; ++i) {
+                if (!TrackPoint(prev_levels.data(), next_levels.data(), num_levels, prev_pts[i], next_pts[i])) {
+                    continue;
+                }
+                if (fb_threshold_ > 0) {
+                    cv::Point2f back = prev_pts[i];
+                    if (!TrackPoint(next_levels.data(), prev_levels.data(), num_levels, next_pts[i], back)) {
+                        continue;
+                    }
+                    cv::Point2f d = back - prev_pts[i];
+                    if (d.x * d.x + d.y * d.y > fb_threshold2) continue;
+                }
+                status[i] = 1;
+            }
+        }, (n + 15) / 16);
+
+        int cnt = 0;
+        for (auto s : status) cnt += s;
+        return cnt;
+    }
+
+} // namespace myslam
@@ -4,43 +4,62 @@
 namespace myslam {
 
     void Map::InsertKeyFrame(Frame::Ptr frame) {
+        std::unique_lock<std::mutex> lck(write_mutex_);
         current_frame_ = frame;
 
-        if (keyframes_.find(frame->keyframe_id_) == keyframes_.end()) {
+        keyframes_.changed = true;
+        active_keyframes_.changed = true;
+        if (keyframes_.data.find(frame->keyframe_id_) == keyframes_.data.end()) {
             /**
              * if current frame is not included in keyframes,
              * insert it into the keyframe, and activate it.
              * To activate it, this frame needs to be inserted
              * into the active_keyframes_ variable
              */
-            keyframes_.insert(std::make_pair(frame->keyframe_id_, frame));
-            active_keyframes_.insert(std::make_pair(frame->keyframe_id_, frame));
+            keyframes_.data.insert(std::make_pair(frame->keyframe_id_, frame));
+            active_keyframes_.data.insert(std::make_pair(frame->keyframe_id_, frame));
         } else {
             /**
              * if the current is include in existed keyframes,
              * find it according to its id, and activate it
              */
-            keyframes_[frame->keyframe_id_] = frame;
-            active_keyframes_[frame->keyframe_id_] = frame;
+            keyframes_.data[frame->keyframe_id_] = frame;
+            active_keyframes_.data[frame->keyframe_id_] = frame;
         }
 
-        if (active_keyframes_.size() > num_active_keyframes_) {
+        if (active_keyframes_.data.size() > num_active_keyframes_) {
             RemoveOldKeyframe();
         }
+
+        Publish(active_keyframes_);
+        Publish(active_landmarks_);
     }
 
     void Map::InsertMapPoint(MapPoint::Ptr map_point) {
-        if (landmarks_.find(map_point->id_) == landmarks_.end()) {
-            // if there is a new landmark, insert to existed landmarks_ map with format of (id, MapPoint)
-            // and then activate it
-            landmarks_.insert(std::make_pair(map_point->id_, map_point));
-            active_landmarks_.insert(std::make_pair(map_point->id_, map_point));
-        } else {
-            // if this landmark has already been in existed landmarks_ map
-            // find and activate it
-            landmarks_[map_point->id_] = map_point;
-            active_landmarks_[map_point->id_] = map_point;
+        InsertMapPoints(std::vector<MapPoint::Ptr>(1, map_point));
+    }
+
+    void Map::InsertMapPoints(const std::vector<MapPoint::Ptr> &map_points) {
+        if (map_points.empty()) return;
+        // called by the keyframe worker of the frontend, concurrent with the backend
+        std::unique_lock<std::mutex> lck(write_mutex_);
+        landmarks_.changed = true;
+        active_landmarks_.changed = true;
+        for (auto &map_point : map_points) {
+            if (landmarks_.data.find(map_point->id_) == landmarks_.data.end()) {
+                // if there is a new landmark, insert to existed landmarks_ map with format of (id, MapPoint)
+                // and then activate it
+                landmarks_.data.insert(std::make_pair(map_point->id_, map_point));
+                active_landmarks_.data.insert(std::make_pair(map_point->id_, map_point));
+            } else {
+                // if this landmark has already been in existed landmarks_ map
+                // find and activate it
+                landmarks_.data[map_point->id_] = map_point;
+                active_landmarks_.data[map_point->id_] = map_point;
+            }
         }
+
+        Publish(active_landmarks_);
     }
 
     // only 7 frames are keyframes
@@ -50,7 +69,7 @@ namespace myslam {
         double max_dis = 0, min_dis = 9999;
         double max_kf_id = 0, min_kf_id = 0;
         auto Twc = current_frame_->Pose().inverse(); // SE3, cv::Mat Twc =Tcw.inv()
-        for (auto& kf : active_keyframes_) {
+        for (auto& kf : active_keyframes_.data) {
             // map.first, map.second
             if (kf.second == current_frame_) continue;
             auto dis = (kf.second->Pose() * Twc).log().norm();
@@ -70,16 +89,17 @@ namespace myslam {
         if (min_dis < min_dis_th) {
             // if one keyframe have small distance with current frame, remove it
             // the current will replace this keyframe as a new keyframe
-            frame_to_remove = keyframes_.at(min_kf_id);
+            frame_to_remove = keyframes_.data.at(min_kf_id);
         } else {
             // remove the farest keyframe
-            frame_to_remove = keyframes_.at(max_kf_id);
+            frame_to_remove = keyframes_.data.at(max_kf_id);
         }
 
         LOG(INFO) << "remove keyframe " << frame_to_remove->keyframe_id_;
         // remove keyframe and its corresponding landmarks/MapPoints/observations
         // by detecting feature points in the frame
-        active_keyframes_.erase(frame_to_remove->keyframe_id_);
+        active_keyframes_.data.erase(frame_to_remove->keyframe_id_);
+        frame_to_remove->ReleasePyramids();
         // left frame
         for (auto feat : frame_to_remove->features_left_) {
             // std::vector<std::shared_ptr<Feature>> features_left_;
@@ -98,20 +118,27 @@ namespace myslam {
             }
         }
 
-        CleanMap();
+        RemoveUnobservedLandmarks();
     }
 
     // clean active MapPoints/landmarks
     void Map::CleanMap() {
+        std::unique_lock<std::mutex> lck(write_mutex_);
+        RemoveUnobservedLandmarks();
+        Publish(active_landmarks_);
+    }
+
+    void Map::RemoveUnobservedLandmarks() {
         int cnt_landmark_removed = 0;
-        for (auto iter = active_landmarks_.begin(); iter != active_landmarks_.end();) {
+        for (auto iter = active_landmarks_.data.begin(); iter != active_landmarks_.data.end();) {
             if (iter->second->observed_times_ == 0) {
-                iter = active_landmarks_.erase(iter);
+                iter = active_landmarks_.data.erase(iter);
                 cnt_landmark_removed++;
             } else {
                 ++iter;
             }
         }
+        if (cnt_landmark_removed > 0) active_landmarks_.changed = true;
         LOG(INFO) << "Removed " << cnt_landmark_removed << " active landmarks";
     }
 
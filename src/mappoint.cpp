@@ -1,39 +1,48 @@
 #include "myslam/mappoint.h"
 #include "myslam/feature.h"
+#include "myslam/pool.h"
 
 namespace myslam {
 
-    MapPoint::MapPoint(long id, Vec3 position) : id_(id), pos_(position) {}
+    MapPoint::MapPoint(long id, Vec3 position) : id_(id) { SetPos(position); }
 
     // create a new MapPoint/landmark and set a new id
     // landmarks_.find(map_point->id_) == landmarks_.end() in map.cpp
     MapPoint::Ptr MapPoint::CreateNewMappoint() { // Static functions in a class
         static long factory_id = 0; // static variable in a function, lifetime
-        MapPoint::Ptr new_mappoint(new MapPoint);
+        MapPoint::Ptr new_mappoint = MakePooled<MapPoint>(); // recycles the blocks of removed landmarks
         new_mappoint->id_ = factory_id++;
         return new_mappoint;
     }
 
+    void MapPoint::AddObservation(std::shared_ptr<Feature> feature) {
+        std::unique_lock<std::mutex> lck(data_mutex_);
+        feature->observation_index_ = observations_.size();
+        observations_.push_back(feature);
+        observed_times_++;
+    }
+
+    // same feature, compared by control block without locking obs
+    static bool SameFeature(const std::weak_ptr<Feature> &obs, const std::shared_ptr<Feature> &feat) {
+        return !obs.owner_before(feat) && !feat.owner_before(obs);
+    }
+
     void MapPoint::RemoveObservation(std::shared_ptr<Feature> feat) {
         std::unique_lock<std::mutex> lck(data_mutex_);
-        for (auto iter = observations_.begin(); iter != observations_.end(); iter++) {
-            if (iter->lock() == feat) {
-
-                observations_.erase(iter); // remove this feature
-                /**
-                 * // Erasing elements in between the list using
-                 * // erase(position) member function. Let's iterate to 3rd position
-                 * it = listOfNumbers.begin();
-                 * it++;
-                 * it++;
-                 * // Iterator 'it' is at 3rd position. Now erase this element.
-                 * listOfNumbers.erase(it);
-                 */
-
-                feat->map_point_.reset();
-                observed_times_--;
-                break;
-            }
+        size_t index = feat->observation_index_;
+        if (index >= observations_.size() || !SameFeature(observations_[index], feat)) {
+            // the feature is not an observation of this MapPoint
+            return;
+        }
+
+        // the last observation takes the place of the removed one
+        observations_.swap_remove(index);
+        if (index < observations_.size()) {
+            auto moved = observations_[index].lock();
+            if (moved) moved->observation_index_ = index;
         }
+
+        feat->map_point_.reset();
+        observed_times_--;
     }
 } // namespace myslam
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "myslam/pipe_dataset.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace myslam {
+
+    namespace {
+        const char kPipeMagic[4] = {'M', 'S', 'P', 'P'};
+        // how often a read waiting for the producer checks if the loader stops
+        const int kPollTimeoutMs = 100;
+    } // namespace
+
+    PipeDataset::PipeDataset(const std::string &pipe, const Camera &camera)
+        : Dataset(pipe), camera_(camera) {
+        live_ = true;
+    }
+
+    PipeDataset::~PipeDataset() {
+        StopLoader();
+        if (fd_ >= 0) close(fd_);
+    }
+
+    bool PipeDataset::Open() {
+        if (fd_ >= 0) close(fd_);
+        LOG(INFO) << "Waiting for the producer of " << dataset_path_;
+        fd_ = open(dataset_path_.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            LOG(ERROR) << "cannot open pipe " << dataset_path_ << ": " << strerror(errno);
+            return false;
+        }
+        SetStereoCameras(camera_.fx_, camera_.fy_, camera_.cx_, camera_.cy_, camera_.baseline_);
+        return true;
+    }
+
+    bool PipeDataset::ReadFully(void *data, size_t size) {
+        char *p = static_cast<char *>(data);
+        while (size > 0) {
+            pollfd pfd = {fd_, POLLIN, 0};
+            int ready = poll(&pfd, 1, kPollTimeoutMs);
+            if (ready < 0 && errno != EINTR) return false;
+            if (ready <= 0) {
+                if (Stopping()) return false;
+                continue;
+            }
+            ssize_t n = read(fd_, p, size);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false; // end of the stream
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    bool PipeDataset::ReadStereoPair(int index, StereoPair &pair) {
+        PipeHeader header;
+        if (!ReadFully(&header, sizeof(header))) return false;
+        if (memcmp(header.magic, kPipeMagic, sizeof(kPipeMagic)) != 0 || header.width == 0 || header.height == 0) {
+            LOG(ERROR) << "invalid stereo pair in " << dataset_path_;
+            return false;
+        }
+
+        pair.left = cv::Mat(header.height, header.width, CV_8UC1);
+        pair.right = cv::Mat(header.height, header.width, CV_8UC1);
+        const size_t image_size = size_t(header.width) * header.height;
+        if (!ReadFully(pair.left.data, image_size) || !ReadFully(pair.right.data, image_size)) {
+            LOG(WARNING) << "incomplete stereo pair in " << dataset_path_;
+            return false;
+        }
+        pair.time_stamp = header.time_stamp;
+        return true;
+    }
+
+    bool PipeDataset::Write(int fd, double time_stamp, const cv::Mat &left, const cv::Mat &right) {
+        if (left.type() != CV_8UC1 || right.type() != CV_8UC1 || left.rows != right.rows ||
+            left.cols != right.cols) {
+            LOG(ERROR) << "pipe only supports 8-bit stereo pairs of same size";
+            return false;
+        }
+
+        auto write_fully = [fd](const void *data, size_t size) {
+            const char *p = static_cast<const char *>(data);
+            while (size > 0) {
+                ssize_t n = write(fd, p, size);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return false;
+                p += n;
+                size -= n;
+            }
+            return true;
+        };
+
+        PipeHeader header;
+        memcpy(header.magic, kPipeMagic, sizeof(kPipeMagic));
+        header.width = left.cols;
+        header.height = left.rows;
+        header.reserved = 0;
+        header.time_stamp = time_stamp;
+        if (!write_fully(&header, sizeof(header))) return false;
+        for (const cv::Mat *image : {&left, &right}) {
+            for (int r = 0; r < image->rows; ++r) {
+                if (!write_fully(image->ptr<uchar>(r), image->cols)) return false;
+            }
+        }
+        return true;
+    }
+
+} // namespace myslam
@@ -0,0 +1,143 @@
+#include "myslam/pool.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace myslam {
+
+    namespace {
+        // all the pools, for TotalStats
+        std::mutex &RegistryMutex() {
+            static std::mutex *mutex = new std::mutex;
+            return *mutex;
+        }
+
+        std::vector<BlockPool *> &Registry() {
+            static std::vector<BlockPool *> *pools = new std::vector<BlockPool *>;
+            return *pools;
+        }
+    } // namespace
+
+    BlockPool::BlockPool(size_t block_size, size_t alignment, size_t blocks_per_chunk)
+            : alignment_(alignment), blocks_per_chunk_(std::max<size_t>(blocks_per_chunk, 1)) {
+        // a free block holds the link of the free list, and every block is aligned
+        block_size_ = std::max(block_size, sizeof(FreeBlock));
+        block_size_ = (block_size_ + alignment_ - 1) / alignment_ * alignment_;
+
+        std::unique_lock<std::mutex> lck(RegistryMutex());
+        Registry().push_back(this);
+    }
+
+    BlockPool::~BlockPool() {
+        {
+            std::unique_lock<std::mutex> lck(RegistryMutex());
+            auto &pools = Registry();
+            pools.erase(std::remove(pools.begin(), pools.end(), this), pools.end());
+        }
+        for (void *chunk : chunks_) ::operator delete(chunk);
+    }
+
+    void *BlockPool::Allocate() {
+        std::unique_lock<std::mutex> lck(mutex_);
+        if (free_ == nullptr) {
+            // a new chunk, with room to align its first block
+            char *chunk = static_cast<char *>(::operator new(block_size_ * blocks_per_chunk_ + alignment_));
+            chunks_.push_back(chunk);
+            stats_.heap_allocations++;
+            uintptr_t first = (reinterpret_cast<uintptr_t>(chunk) + alignment_ - 1) / alignment_ * alignment_;
+            char *block = reinterpret_cast<char *>(first);
+            // in address order in the free list
+            for (size_t i = blocks_per_chunk_; i-- > 0;) {
+                FreeBlock *free_block = reinterpret_cast<FreeBlock *>(block + i * block_size_);
+                free_block->next = free_;
+                free_ = free_block;
+            }
+        }
+        FreeBlock *block = free_;
+        free_ = block->next;
+        stats_.allocations++;
+        stats_.live++;
+        return block;
+    }
+
+    void BlockPool::Deallocate(void *block) {
+        std::unique_lock<std::mutex> lck(mutex_);
+        FreeBlock *free_block = static_cast<FreeBlock *>(block);
+        free_block->next = free_;
+        free_ = free_block;
+        stats_.live--;
+    }
+
+    PoolStats BlockPool::Stats() {
+        std::unique_lock<std::mutex> lck(mutex_);
+        return stats_;
+    }
+
+    PoolStats BlockPool::TotalStats() {
+        std::unique_lock<std::mutex> lck(RegistryMutex());
+        PoolStats total;
+        for (BlockPool *pool : Registry()) {
+            PoolStats stats = pool->Stats();
+            total.allocations += stats.allocations;
+            total.heap_allocations += stats.heap_allocations;
+            total.live += stats.live;
+        }
+        return total;
+    }
+
+    const size_t FrameArena::kChunkSize;
+
+    FrameArena::~FrameArena() {
+        for (void *chunk : chunks_) ChunkPool().Deallocate(chunk);
+        for (void *block : large_) ::operator delete(block);
+    }
+
+    void *FrameArena::Allocate(size_t size, size_t alignment) {
+        std::unique_lock<std::mutex> lck(mutex_);
+        live_++;
+        if (size + alignment > kChunkSize) {
+            // operator new aligns to max_align_t only
+            void *block = ::operator new(size + alignment);
+            large_.push_back(block);
+            uintptr_t aligned = (reinterpret_cast<uintptr_t>(block) + alignment - 1) / alignment * alignment;
+            return reinterpret_cast<void *>(aligned);
+        }
+
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(head_) + alignment - 1) / alignment * alignment;
+        if (head_ == nullptr || aligned + size > reinterpret_cast<uintptr_t>(end_)) {
+            // the rest of the current chunk is left unused
+            char *chunk = static_cast<char *>(ChunkPool().Allocate());
+            chunks_.push_back(chunk);
+            end_ = chunk + kChunkSize;
+            aligned = (reinterpret_cast<uintptr_t>(chunk) + alignment - 1) / alignment * alignment;
+        }
+        head_ = reinterpret_cast<char *>(aligned + size);
+        return reinterpret_cast<void *>(aligned);
+    }
+
+    void FrameArena::Deallocate(void *) {
+        std::unique_lock<std::mutex> lck(mutex_);
+        live_--;
+    }
+
+    size_t FrameArena::NumChunks() {
+        std::unique_lock<std::mutex> lck(mutex_);
+        return chunks_.size();
+    }
+
+    size_t FrameArena::NumLive() {
+        std::unique_lock<std::mutex> lck(mutex_);
+        return live_;
+    }
+
+    PoolStats FrameArena::ChunkStats() {
+        return ChunkPool().Stats();
+    }
+
+    BlockPool &FrameArena::ChunkPool() {
+        // never destroyed, like the pools of the types, arenas may be released at exit
+        static BlockPool *pool = new BlockPool(kChunkSize, 64, 16);
+        return *pool;
+    }
+
+} // namespace myslam
@@ -0,0 +1,150 @@
+#include "myslam/pose_solver.h"
+
+#include <cmath>
+#include <Eigen/Cholesky>
+
+namespace myslam {
+
+    void PoseSolver::Clear() {
+        px_.clear(); py_.clear(); pz_.clear();
+        u_.clear(); v_.clear();
+        chi2_.clear();
+        outlier_.clear();
+    }
+
+    void PoseSolver::AddObservation(const Vec3 &pos, const Vec2 &measurement) {
+        px_.push_back(pos[0]); py_.push_back(pos[1]); pz_.push_back(pos[2]);
+        u_.push_back(measurement[0]); v_.push_back(measurement[1]);
+        chi2_.push_back(0);
+        outlier_.push_back(0);
+    }
+
+    int PoseSolver::Solve(SE3 &pose) {
+        const SE3 initial_pose = pose;
+        std::fill(outlier_.begin(), outlier_.end(), 0);
+
+        int cnt_outlier = 0;
+        for (int round = 0; round < num_rounds_; ++round) {
+            // each round starts from the initial pose, as the g2o version does
+            pose = initial_pose;
+            Optimize(pose, round < 3);
+
+            // classify all observations, outliers included
+            ComputeChi2(pose);
+            cnt_outlier = 0;
+            for (size_t i = 0; i < Size(); ++i) {
+                outlier_[i] = chi2_[i] > chi2_th_;
+                cnt_outlier += outlier_[i];
+            }
+        }
+
+        return Size() - cnt_outlier;
+    }
+
+    void PoseSolver::Robustify(double e2, bool robust, double &rho0, double &rho1) const {
+        const double dsqr = huber_delta_ * huber_delta_;
+        if (!robust || e2 <= dsqr) {
+            rho0 = e2;
+            rho1 = 1;
+        } else {
+            const double sqrte = std::sqrt(e2);
+            rho0 = 2 * sqrte * huber_delta_ - dsqr;
+            rho1 = huber_delta_ / sqrte;
+        }
+    }
+
+    double PoseSolver::BuildNormalEquations(const SE3 &pose, bool robust, Mat66 &H, Vec6 &b) const {
+        const Mat33 R = pose.rotationMatrix();
+        const Vec3 t = pose.translation();
+        const double fx = K_(0, 0), fy = K_(1, 1), cx = K_(0, 2), cy = K_(1, 2);
+
+        H.setZero();
+        b.setZero();
+        double chi2 = 0;
+        Eigen::Matrix<double, 2, 6> J;
+        for (size_t i = 0; i < Size(); ++i) {
+            if (outlier_[i]) continue;
+            const double X = R(0, 0) * px_[i] + R(0, 1) * py_[i] + R(0, 2) * pz_[i] + t[0];
+            const double Y = R(1, 0) * px_[i] + R(1, 1) * py_[i] + R(1, 2) * pz_[i] + t[1];
+            const double Z = R(2, 0) * px_[i] + R(2, 1) * py_[i] + R(2, 2) * pz_[i] + t[2];
+            const double Zinv = 1.0 / (Z + 1e-18);
+            const double Zinv2 = Zinv * Zinv;
+            const Vec2 e(u_[i] - (fx * X * Zinv + cx), v_[i] - (fy * Y * Zinv + cy));
+
+            double rho0, rho1;
+            Robustify(e.squaredNorm(), robust, rho0, rho1);
+            chi2 += rho0;
+
+            // d e / d update, update is left multiplied on SE3, same as EdgeProjectionPoseOnly
+            J << -fx * Zinv, 0, fx * X * Zinv2, fx * X * Y * Zinv2,
+                 -fx - fx * X * X * Zinv2, fx * Y * Zinv, 0, -fy * Zinv,
+                 fy * Y * Zinv2, fy + fy * Y * Y * Zinv2, -fy * X * Y * Zinv2, -fy * X * Zinv;
+            H.noalias() += rho1 * J.transpose() * J;
+            b.noalias() -= rho1 * J.transpose() * e;
+        }
+        return chi2;
+    }
+
+    double PoseSolver::RobustChi2(const SE3 &pose, bool robust) const {
+        const double fx = K_(0, 0), fy = K_(1, 1), cx = K_(0, 2), cy = K_(1, 2);
+        double chi2 = 0;
+        for (size_t i = 0; i < Size(); ++i) {
+            if (outlier_[i]) continue;
+            const Vec3 pc = pose * Vec3(px_[i], py_[i], pz_[i]);
+            const Vec2 e(u_[i] - (fx * pc[0] / pc[2] + cx), v_[i] - (fy * pc[1] / pc[2] + cy));
+            double rho0, rho1;
+            Robustify(e.squaredNorm(), robust, rho0, rho1);
+            chi2 += rho0;
+        }
+        return chi2;
+    }
+
+    void PoseSolver::Optimize(SE3 &pose, bool robust) const {
+        Mat66 H;
+        Vec6 b;
+        double lambda = -1; // set in the first iteration
+        double ni = 2;
+        for (int iteration = 0; iteration < num_iterations_; ++iteration) {
+            double chi2 = BuildNormalEquations(pose, robust, H, b);
+            if (lambda < 0) {
+                // same initial damping as g2o::OptimizationAlgorithmLevenberg
+                lambda = 1e-5 * H.diagonal().maxCoeff();
+            }
+
+            // try damping factors until the cost decreases
+            bool accepted = false;
+            for (int trial = 0; trial < 10 && !accepted; ++trial) {
+                Mat66 H_damped = H;
+                H_damped.diagonal().array() += lambda;
+                Vec6 dx = H_damped.ldlt().solve(b);
+                if (!dx.allFinite()) break;
+
+                SE3 new_pose = SE3::exp(dx) * pose;
+                double new_chi2 = RobustChi2(new_pose, robust);
+                double rho = (chi2 - new_chi2) / (dx.dot(lambda * dx + b) + 1e-3);
+                if (rho > 0 && std::isfinite(new_chi2)) {
+                    pose = new_pose;
+                    double alpha = 1 - std::pow(2 * rho - 1, 3);
+                    lambda *= std::max(1.0 / 3.0, std::min(alpha, 2.0 / 3.0));
+                    ni = 2;
+                    accepted = true;
+                } else {
+                    lambda *= ni;
+                    ni *= 2;
+                }
+            }
+            if (!accepted) break; // converged, or no decrease possible
+        }
+    }
+
+    void PoseSolver::ComputeChi2(const SE3 &pose) {
+        const double fx = K_(0, 0), fy = K_(1, 1), cx = K_(0, 2), cy = K_(1, 2);
+        for (size_t i = 0; i < Size(); ++i) {
+            const Vec3 pc = pose * Vec3(px_[i], py_[i], pz_[i]);
+            const double du = u_[i] - (fx * pc[0] / pc[2] + cx);
+            const double dv = v_[i] - (fy * pc[1] / pc[2] + cy);
+            chi2_[i] = du * du + dv * dv;
+        }
+    }
+
+} // namespace myslam
@@ -0,0 +1,183 @@
+#include "myslam/profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <map>
+
+namespace myslam {
+
+    Profiler &Profiler::Instance() {
+        // never destroyed, threads may record while the process exits
+        static Profiler *profiler = new Profiler;
+        return *profiler;
+    }
+
+    Profiler::Ring &Profiler::ThreadRing() {
+        thread_local Ring *ring = nullptr;
+        if (ring == nullptr) {
+            std::unique_lock<std::mutex> lck(rings_mutex_);
+            rings_.emplace_back(new Ring(rings_.size()));
+            ring = rings_.back().get();
+        }
+        return *ring;
+    }
+
+    void Profiler::Push(const Event &event) {
+        Ring &ring = ThreadRing();
+        const size_t head = ring.head.load(std::memory_order_relaxed);
+        if (head - ring.tail.load(std::memory_order_acquire) >= Ring::kCapacity) {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring.events[head % Ring::kCapacity] = event;
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    void Profiler::RecordSpan(const char *name, int64_t start_ns, int64_t end_ns) {
+        if (!Enabled()) return;
+        Push({name, start_ns, end_ns - start_ns, 0});
+    }
+
+    void Profiler::RecordCounter(const char *name, double value) {
+        if (!Enabled()) return;
+        Push({name, Now(), -1, value});
+    }
+
+    void Profiler::Collect() {
+        std::unique_lock<std::mutex> lck(collect_mutex_);
+        std::vector<Ring *> rings;
+        {
+            std::unique_lock<std::mutex> rings_lck(rings_mutex_);
+            for (auto &ring : rings_) rings.push_back(ring.get());
+        }
+        for (Ring *ring : rings) {
+            const size_t head = ring->head.load(std::memory_order_acquire);
+            size_t tail = ring->tail.load(std::memory_order_relaxed);
+            for (; tail != head; ++tail) {
+                events_.push_back({ring->thread_index, ring->events[tail % Ring::kCapacity]});
+            }
+            ring->tail.store(tail, std::memory_order_release);
+        }
+    }
+
+    namespace {
+        // nearest rank percentile of sorted values
+        double Percentile(const std::vector<double> &sorted, double p) {
+            size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+            return sorted[std::max<size_t>(rank, 1) - 1];
+        }
+
+        // names of the profiler are literals, only quotes and backslashes are escaped
+        std::string JsonString(const std::string &s) {
+            std::string out = "\"";
+            for (char c : s) {
+                if (c == '"' || c == '\\') out += '\\';
+                out += c;
+            }
+            return out + "\"";
+        }
+    } // namespace
+
+    std::vector<Profiler::Summary> Profiler::Summaries() {
+        std::map<std::string, std::vector<double>> spans, counters;
+        {
+            std::unique_lock<std::mutex> lck(collect_mutex_);
+            for (auto &event : events_) {
+                if (event.second.duration_ns >= 0) {
+                    spans[event.second.name].push_back(event.second.duration_ns * 1e-6);
+                } else {
+                    counters[event.second.name].push_back(event.second.value);
+                }
+            }
+        }
+
+        std::vector<Summary> summaries;
+        auto summarize = [&](std::map<std::string, std::vector<double>> &values, bool is_span) {
+            for (auto &named : values) {
+                std::vector<double> &v = named.second;
+                std::sort(v.begin(), v.end());
+                Summary summary;
+                summary.name = named.first;
+                summary.is_span = is_span;
+                summary.count = v.size();
+                double sum = 0;
+                for (double x : v) sum += x;
+                summary.mean = sum / v.size();
+                summary.p50 = Percentile(v, 0.50);
+                summary.p95 = Percentile(v, 0.95);
+                summary.p99 = Percentile(v, 0.99);
+                summary.max = v.back();
+                summaries.push_back(summary);
+            }
+        };
+        summarize(spans, true);
+        summarize(counters, false);
+        std::sort(summaries.begin(), summaries.end(),
+                  [](const Summary &a, const Summary &b) { return a.name < b.name; });
+        return summaries;
+    }
+
+    unsigned long Profiler::NumDropped() {
+        std::unique_lock<std::mutex> lck(rings_mutex_);
+        unsigned long dropped = 0;
+        for (auto &ring : rings_) dropped += ring->dropped.load(std::memory_order_relaxed);
+        return dropped;
+    }
+
+    bool Profiler::WriteJson(const std::string &path) {
+        std::ofstream file(path);
+        if (!file) return false;
+        file << std::setprecision(9);
+        file << "{\n  \"dropped\": " << NumDropped() << ",\n  \"unit\": \"ms\",\n  \"stats\": [";
+        std::vector<Summary> summaries = Summaries();
+        for (size_t i = 0; i < summaries.size(); ++i) {
+            const Summary &s = summaries[i];
+            file << (i ? ",\n" : "\n") << "    {\"name\": " << JsonString(s.name)
+                 << ", \"type\": \"" << (s.is_span ? "span" : "counter") << "\", \"count\": " << s.count
+                 << ", \"mean\": " << s.mean << ", \"p50\": " << s.p50 << ", \"p95\": " << s.p95
+                 << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << "}";
+        }
+        file << "\n  ]\n}\n";
+        return file.good();
+    }
+
+    bool Profiler::WriteCsv(const std::string &path) {
+        std::ofstream file(path);
+        if (!file) return false;
+        file << std::setprecision(9);
+        file << "name,type,count,mean,p50,p95,p99,max\n";
+        for (const Summary &s : Summaries()) {
+            file << s.name << ',' << (s.is_span ? "span" : "counter") << ',' << s.count << ',' << s.mean
+                 << ',' << s.p50 << ',' << s.p95 << ',' << s.p99 << ',' << s.max << '\n';
+        }
+        return file.good();
+    }
+
+    bool Profiler::WriteChromeTrace(const std::string &path) {
+        std::ofstream file(path);
+        if (!file) return false;
+        file << std::fixed << std::setprecision(3);
+        file << "{\"traceEvents\": [";
+        std::unique_lock<std::mutex> lck(collect_mutex_);
+        for (size_t i = 0; i < events_.size(); ++i) {
+            const Event &event = events_[i].second;
+            file << (i ? ",\n" : "\n") << "{\"name\": " << JsonString(event.name) << ", \"pid\": 0, \"tid\": "
+                 << events_[i].first << ", \"ts\": " << event.start_ns * 1e-3;
+            if (event.duration_ns >= 0) {
+                file << ", \"ph\": \"X\", \"dur\": " << event.duration_ns * 1e-3 << "}";
+            } else {
+                file << ", \"ph\": \"C\", \"args\": {\"value\": " << event.value << "}}";
+            }
+        }
+        file << "\n], \"displayTimeUnit\": \"ms\"}\n";
+        return file.good();
+    }
+
+    void Profiler::Clear() {
+        std::unique_lock<std::mutex> lck(collect_mutex_);
+        events_.clear();
+    }
+
+} // namespace myslam
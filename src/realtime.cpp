@@ -0,0 +1,61 @@
+#include "myslam/realtime.h"
+
+namespace myslam {
+
+    namespace {
+        double Milliseconds(RealtimeScheduler::Clock::duration d) {
+            return std::chrono::duration<double, std::milli>(d).count();
+        }
+    } // namespace
+
+    RealtimeScheduler::RealtimeScheduler(double speed, double deadline_ms)
+        : speed_(speed > 0 ? speed : 1.0), deadline_ms_(deadline_ms) {}
+
+    RealtimeScheduler::Clock::time_point RealtimeScheduler::Release(double time_stamp) {
+        if (!started_) {
+            started_ = true;
+            start_ = Clock::now();
+            first_time_stamp_ = last_time_stamp_ = time_stamp;
+        }
+        auto offset = std::chrono::duration<double>((time_stamp - first_time_stamp_) / speed_);
+        return start_ + std::chrono::duration_cast<Clock::duration>(offset);
+    }
+
+    RealtimeScheduler::Decision RealtimeScheduler::Decide(double time_stamp, Clock::time_point now) {
+        release_ = Release(time_stamp);
+        stats_.frames++;
+
+        // a source without time stamps keeps the last period
+        if (time_stamp > last_time_stamp_) period_ms_ = (time_stamp - last_time_stamp_) * 1e3 / speed_;
+        last_time_stamp_ = time_stamp;
+        double deadline_ms = deadline_ms_ > 0 ? deadline_ms_ : period_ms_;
+        if (deadline_ms <= 0) {
+            // the first frame, nothing to catch up with yet
+            deadline_ = Clock::time_point::max();
+            stats_.processed++;
+            return Decision::PROCESS;
+        }
+        deadline_ = release_ + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::milli>(deadline_ms));
+
+        double lateness_ms = Milliseconds(now - release_);
+        if (lateness_ms > deadline_ms && stats_.processed > 0) {
+            stats_.dropped++;
+            return Decision::DROP;
+        }
+        stats_.processed++;
+        if (lateness_ms > deadline_ms / 2) {
+            stats_.degraded++;
+            return Decision::DEGRADE;
+        }
+        return Decision::PROCESS;
+    }
+
+    double RealtimeScheduler::Finish(Clock::time_point now) {
+        if (now > deadline_) stats_.deadline_misses++;
+        double latency_ms = Milliseconds(now - release_);
+        stats_.max_latency_ms = std::max(stats_.max_latency_ms, latency_ms);
+        return latency_ms;
+    }
+
+} // namespace myslam
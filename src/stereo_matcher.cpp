@@ -0,0 +1,97 @@
+#include "myslam/stereo_matcher.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <opencv2/core/utility.hpp>
+
+namespace myslam {
+
+    int StereoMatcher::Search(const cv::Mat &left, const cv::Mat &right, int x, int y,
+                              int d_min, int d_max, int *costs) const {
+        const int h = half_block_, size = 2 * h + 1;
+        for (int d = d_min; d <= d_max; ++d) {
+            int sad = 0;
+            for (int r = -h; r <= h; ++r) {
+                const uchar *pl = left.ptr<uchar>(y + r) + x - h;
+                const uchar *pr = right.ptr<uchar>(y + r) + x - d - h;
+                for (int c = 0; c < size; ++c) {
+                    sad += std::abs(int(pl[c]) - int(pr[c]));
+                }
+            }
+            costs[d - d_min] = sad;
+        }
+
+        int best = 0;
+        for (int i = 1; i <= d_max - d_min; ++i) {
+            if (costs[i] < costs[best]) best = i;
+        }
+        // second best away from the neighbours of the minimum
+        int second = -1;
+        for (int i = 0; i <= d_max - d_min; ++i) {
+            if (std::abs(i - best) <= 1) continue;
+            if (second < 0 || costs[i] < costs[second]) second = i;
+        }
+        if (second >= 0 && costs[best] >= uniqueness_ratio_ * costs[second]) return -1;
+        return best + d_min;
+    }
+
+    int StereoMatcher::Match(const cv::Mat &left, const cv::Mat &right,
+                             const std::vector<cv::Point2f> &left_pts,
+                             const std::vector<float> &predicted_disparity,
+                             std::vector<cv::Point2f> &right_pts, std::vector<uchar> &status) const {
+        const int n = left_pts.size();
+        right_pts.resize(n);
+        status.assign(n, 0);
+
+        cv::parallel_for_(cv::Range(0, n), [&](const cv::Range &range) {
+            std::vector<int> costs(max_disparity_ + 1);
+            for (int i = range.start; i < range.end; ++i) {
+                const int x = std::lround(left_pts[i].x), y = std::lround(left_pts[i].y);
+                const int h = half_block_;
+                if (x - h < 0 || y - h < 0 || x + h >= left.cols || y + h >= left.rows) continue;
+                // the block in the right image must be inside too
+                const int d_limit = std::min(max_disparity_, x - h);
+                if (d_limit < 0) continue;
+
+                int d_min = 0, d_max = d_limit, d = -1;
+                float prediction = i < int(predicted_disparity.size()) ? predicted_disparity[i] : -1;
+                if (prediction >= 0) {
+                    d_min = std::max(0, int(std::floor(prediction)) - search_margin_);
+                    d_max = std::min(d_limit, int(std::ceil(prediction)) + search_margin_);
+                    if (d_min <= d_max) {
+                        d = Search(left, right, x, y, d_min, d_max, costs.data());
+                        // ambiguous, the minimum at a bound of the window, or a poor local minimum,
+                        // the prediction is off
+                        if (d < 0 || (d == d_min && d_min > 0) || (d == d_max && d_max < d_limit) ||
+                            costs[d - d_min] > max_mean_cost_ * (2 * h + 1) * (2 * h + 1)) d = -2;
+                    }
+                    if (d == -2 || d_min > d_max) {
+                        d_min = 0;
+                        d_max = d_limit;
+                        d = Search(left, right, x, y, d_min, d_max, costs.data());
+                    }
+                } else {
+                    d = Search(left, right, x, y, d_min, d_max, costs.data());
+                }
+                if (d < 0) continue;
+
+                // parabola through the costs of d - 1, d, d + 1
+                float disparity = d;
+                if (d > d_min && d < d_max) {
+                    float c0 = costs[d - 1 - d_min], c1 = costs[d - d_min], c2 = costs[d + 1 - d_min];
+                    float denom = c0 - 2 * c1 + c2;
+                    if (denom > 0) {
+                        disparity += std::max(-0.5f, std::min(0.5f, 0.5f * (c0 - c2) / denom));
+                    }
+                }
+                right_pts[i] = cv::Point2f(left_pts[i].x - disparity, left_pts[i].y);
+                status[i] = 1;
+            }
+        });
+
+        int cnt = 0;
+        for (auto s : status) cnt += s;
+        return cnt;
+    }
+
+} // namespace myslam
@@ -0,0 +1,137 @@
+#include "myslam/synthetic_dataset.h"
+
+#include <limits>
+#include <random>
+
+namespace myslam {
+
+    namespace {
+        // corridor, x of the walls and y of the floor and the ceiling (y points down)
+        const double kWallX = 6.0, kFloorY = 1.6, kCeilingY = -3.0;
+        // distance at which the texture has faded to half, far texture would alias
+        const double kFadeDistance = 40.0;
+        // weaving of the trajectory, amplitude in m and period in m
+        const double kWeaveAmplitude = 1.5, kWeavePeriod = 150.0;
+
+        uint64_t Mix(uint64_t x) {
+            // splitmix64 finalizer
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ULL;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebULL;
+            x ^= x >> 31;
+            return x;
+        }
+
+        double SmoothStep(double x) { return x * x * (3 - 2 * x); }
+    } // namespace
+
+    SyntheticDataset::SyntheticDataset(const Options &options)
+            : Dataset("synthetic"), options_(options) {}
+
+    SyntheticDataset::~SyntheticDataset() {
+        StopLoader();
+    }
+
+    bool SyntheticDataset::Open() {
+        SetStereoCameras(options_.fx, options_.fy, options_.width / 2.0, options_.height / 2.0, options_.baseline);
+
+        // forward along z, weaving along x and heading along the tangent
+        ground_truth_.clear();
+        const double w = 2 * M_PI / kWeavePeriod;
+        for (int i = 0; i < options_.num_frames; ++i) {
+            double z = options_.speed * i;
+            double x = kWeaveAmplitude * std::sin(w * z);
+            double yaw = std::atan(kWeaveAmplitude * w * std::cos(w * z));
+            ground_truth_.push_back(SE3(SO3::exp(Vec3(0, yaw, 0)), Vec3(x, 0, z)));
+        }
+        return true;
+    }
+
+    double SyntheticDataset::Hash(int plane, int64_t i, int64_t j, int octave) const {
+        uint64_t h = Mix(options_.seed + 0x9e3779b97f4a7c15ULL * (plane * 4 + octave + 1));
+        h = Mix(h ^ static_cast<uint64_t>(i));
+        h = Mix(h ^ static_cast<uint64_t>(j));
+        return (h >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    double SyntheticDataset::Texture(int plane, double a, double b) const {
+        // blocks, their edges and corners are the features
+        const double block = 2 * options_.texture_scale;
+        double blocks = Hash(plane, std::floor(a / block), std::floor(b / block), 0);
+
+        // two octaves of value noise
+        double noise = 0, weight = 0.7;
+        for (int octave = 1; octave <= 2; ++octave, weight = 0.3) {
+            const double scale = options_.texture_scale / (octave == 1 ? 1.0 : 2.5);
+            double fa = a / scale, fb = b / scale;
+            int64_t ia = std::floor(fa), ib = std::floor(fb);
+            double ta = SmoothStep(fa - ia), tb = SmoothStep(fb - ib);
+            double v00 = Hash(plane, ia, ib, octave), v10 = Hash(plane, ia + 1, ib, octave);
+            double v01 = Hash(plane, ia, ib + 1, octave), v11 = Hash(plane, ia + 1, ib + 1, octave);
+            noise += weight * ((v00 * (1 - ta) + v10 * ta) * (1 - tb) + (v01 * (1 - ta) + v11 * ta) * tb);
+        }
+        return 0.6 * blocks + 0.4 * noise;
+    }
+
+    double SyntheticDataset::Shade(const SE3 &Twc, double u, double v) const {
+        const Vec3 o = Twc.translation();
+        const Vec3 d = Twc.so3().matrix() * Vec3((u - cameras_[0]->cx_) / options_.fx,
+                                                 (v - cameras_[0]->cy_) / options_.fy, 1);
+
+        // nearest of the four planes in front of the camera
+        double t = std::numeric_limits<double>::infinity();
+        int plane = -1;
+        auto hit = [&](double distance, int id) {
+            if (distance > 0 && distance < t) {
+                t = distance;
+                plane = id;
+            }
+        };
+        if (d[0] != 0) {
+            hit((-kWallX - o[0]) / d[0], 0);
+            hit((kWallX - o[0]) / d[0], 1);
+        }
+        if (d[1] != 0) {
+            hit((kFloorY - o[1]) / d[1], 2);
+            hit((kCeilingY - o[1]) / d[1], 3);
+        }
+        if (plane < 0) return 128;
+
+        const Vec3 p = o + t * d;
+        double texture = plane < 2 ? Texture(plane, p[2], p[1]) : Texture(plane, p[0], p[2]);
+        double range = t * d.norm();
+        double fade = kFadeDistance / (kFadeDistance + range);
+        return 128 + fade * 200 * (texture - 0.5);
+    }
+
+    void SyntheticDataset::Render(const SE3 &Tcw, const Camera &camera, int camera_id, int index,
+                                  cv::Mat &image) const {
+        const SE3 Twc = (camera.pose() * Tcw).inverse();
+        image = cv::Mat(options_.height, options_.width, CV_8UC1);
+        cv::parallel_for_(cv::Range(0, options_.height), [&](const cv::Range &range) {
+            for (int v = range.start; v < range.end; ++v) {
+                // noise of each row is seeded by frame, camera and row, the same for any num of threads
+                std::mt19937 rng(Mix(Mix(options_.seed ^ index) ^ (camera_id * 65536 + v)));
+                std::normal_distribution<double> noise(0, options_.noise);
+                uchar *row = image.ptr<uchar>(v);
+                for (int u = 0; u < options_.width; ++u) {
+                    double value = Shade(Twc, u, v);
+                    if (options_.noise > 0) value += noise(rng);
+                    row[u] = static_cast<uchar>(std::min(255.0, std::max(0.0, std::round(value))));
+                }
+            }
+        });
+    }
+
+    bool SyntheticDataset::ReadStereoPair(int index, StereoPair &pair) {
+        if (index >= static_cast<int>(ground_truth_.size())) return false;
+
+        const SE3 Tcw = ground_truth_[index].inverse();
+        Render(Tcw, *cameras_[0], 0, index, pair.left);
+        Render(Tcw, *cameras_[1], 1, index, pair.right);
+        pair.time_stamp = index / options_.fps;
+        return true;
+    }
+
+} // namespace myslam
@@ -0,0 +1,68 @@
+#include "myslam/trajectory.h"
+
+#include <fstream>
+#include <Eigen/Geometry>
+
+namespace myslam {
+
+    bool LoadKittiPoses(const std::string &path, Trajectory &poses) {
+        std::ifstream fin(path);
+        if (!fin) {
+            LOG(ERROR) << "cannot find " << path;
+            return false;
+        }
+        poses.clear();
+        Mat33 R;
+        Vec3 t;
+        while (fin >> R(0, 0) >> R(0, 1) >> R(0, 2) >> t[0]
+                   >> R(1, 0) >> R(1, 1) >> R(1, 2) >> t[1]
+                   >> R(2, 0) >> R(2, 1) >> R(2, 2) >> t[2]) {
+            // the rotations of the file have 9 digits, orthonormalize them
+            poses.push_back(SE3(Eigen::Quaterniond(R).normalized(), t));
+        }
+        return true;
+    }
+
+    TrajectoryError EvaluateTrajectory(const Trajectory &estimate, const Trajectory &ground_truth, int delta) {
+        TrajectoryError error;
+        const size_t n = std::min(estimate.size(), ground_truth.size());
+        error.num_poses = n;
+        if (n == 0) return error;
+
+        // alignment of the positions
+        Eigen::Matrix<double, 3, Eigen::Dynamic> src(3, n), dst(3, n);
+        for (size_t i = 0; i < n; ++i) {
+            src.col(i) = estimate[i].translation();
+            dst.col(i) = ground_truth[i].translation();
+        }
+        SE3 align;
+        if (n >= 3) {
+            Eigen::Matrix4d T = Eigen::umeyama(src, dst, false);
+            align = SE3(Eigen::Quaterniond(Mat33(T.block<3, 3>(0, 0))).normalized(), T.block<3, 1>(0, 3));
+        }
+        double sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            sum += (align * estimate[i].translation() - ground_truth[i].translation()).squaredNorm();
+        }
+        error.ate = std::sqrt(sum / n);
+
+        // relative poses do not depend on the alignment
+        double sum_t = 0, sum_r = 0;
+        size_t num_pairs = 0;
+        for (size_t i = 0; i + delta < n; ++i) {
+            SE3 relative_estimate = estimate[i].inverse() * estimate[i + delta];
+            SE3 relative_truth = ground_truth[i].inverse() * ground_truth[i + delta];
+            SE3 e = relative_truth.inverse() * relative_estimate;
+            sum_t += e.translation().squaredNorm();
+            double angle = e.so3().log().norm() * 180 / M_PI;
+            sum_r += angle * angle;
+            num_pairs++;
+        }
+        if (num_pairs > 0) {
+            error.rpe_translation = std::sqrt(sum_t / num_pairs);
+            error.rpe_rotation = std::sqrt(sum_r / num_pairs);
+        }
+        return error;
+    }
+
+} // namespace myslam
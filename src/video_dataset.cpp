@@ -0,0 +1,49 @@
+#include "myslam/video_dataset.h"
+
+#include <opencv2/opencv.hpp>
+
+namespace myslam {
+    VideoDataset::VideoDataset(const std::string &video, const Camera &camera)
+        : Dataset(video), camera_(camera) {
+        device_ = !video.empty() && video.find_first_not_of("0123456789") == std::string::npos;
+        // a device is not waiting for the tracker
+        live_ = device_;
+    }
+
+    VideoDataset::~VideoDataset() {
+        StopLoader();
+    }
+
+    bool VideoDataset::Open() {
+        if (device_) {
+            capture_.open(std::stoi(dataset_path_));
+        } else {
+            capture_.open(dataset_path_);
+        }
+        if (!capture_.isOpened()) {
+            LOG(ERROR) << "cannot open video " << dataset_path_;
+            return false;
+        }
+        SetStereoCameras(camera_.fx_, camera_.fy_, camera_.cx_, camera_.cy_, camera_.baseline_);
+        start_ = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    bool VideoDataset::ReadStereoPair(int index, StereoPair &pair) {
+        cv::Mat image;
+        if (!capture_.read(image) || image.empty()) return false;
+        if (image.channels() != 1) cv::cvtColor(image, image, cv::COLOR_BGR2GRAY);
+        if (device_) {
+            pair.time_stamp = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+        } else {
+            pair.time_stamp = capture_.get(cv::CAP_PROP_POS_MSEC) * 1e-3;
+        }
+
+        // the halves are copied, so that the rows of each image are continuous
+        const int width = image.cols / 2;
+        pair.left = image(cv::Rect(0, 0, width, image.rows)).clone();
+        pair.right = image(cv::Rect(width, 0, width, image.rows)).clone();
+        return true;
+    }
+
+} // namespace myslam
@@ -153,13 +153,14 @@ namespace myslam {
 
     void Viewer::DrawMapPoints() {
         const float red[3] = {1.0, 0, 0};
-        for (auto& kf : active_keyframes_) {
+        if (!active_keyframes_ || !active_landmarks_) return;
+        for (auto& kf : *active_keyframes_) {
             DrawFrame(kf.second, red);
         }
 
         glPointSize(2);
         glBegin(GL_POINTS);
-        for (auto& landmark : active_landmarks_) {
+        for (auto& landmark : *active_landmarks_) {
             auto pos = landmark.second->Pos();
             glColor3f(red[0], red[1], red[2]);
             glVertex3d(pos[0], pos[1], pos[2]);
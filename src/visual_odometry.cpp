@@ -1,7 +1,26 @@
 #include "myslam/visual_odometry.h"
+#include "myslam/cached_dataset.h"
+#include "myslam/euroc_dataset.h"
+#include "myslam/pipe_dataset.h"
+#include "myslam/pool.h"
+#include "myslam/profiler.h"
+#include "myslam/synthetic_dataset.h"
+#include "myslam/video_dataset.h"
 #include <chrono>
 
 namespace myslam {
+    namespace {
+        // read a parameter from config file, or return the default value if it is missing
+        template <typename T>
+        T ReadParam(const cv::FileStorage &file, const std::string &key, T default_value) {
+            cv::FileNode node = file[key];
+            if (node.empty()) return default_value;
+            T value;
+            node >> value;
+            return value;
+        }
+    } // namespace
+
     VisualOdometry::VisualOdometry(std::string &config_path):config_file_path_(config_path) {}
 
     bool VisualOdometry::Init() {
@@ -9,28 +28,91 @@ namespace myslam {
         // read from config file
         cv::FileStorage file_(config_file_path_.c_str(), cv::FileStorage::READ);
 
-        dataset_ = Dataset::Ptr(new Dataset(file_["dataset_dir"]));
+        std::string dataset_type = ReadParam(file_, "dataset.type", std::string("kitti"));
+        std::string cache_file = ReadParam(file_, "dataset.cache_file", std::string());
+        if (dataset_type == "synthetic") {
+            SyntheticDataset::Options options;
+            options.width = ReadParam(file_, "synthetic.width", options.width);
+            options.height = ReadParam(file_, "synthetic.height", options.height);
+            options.num_frames = ReadParam(file_, "synthetic.num_frames", options.num_frames);
+            options.fps = ReadParam(file_, "synthetic.fps", options.fps);
+            options.speed = ReadParam(file_, "synthetic.speed", options.speed);
+            options.texture_scale = ReadParam(file_, "synthetic.texture_scale", options.texture_scale);
+            options.noise = ReadParam(file_, "synthetic.noise", options.noise);
+            options.seed = ReadParam(file_, "synthetic.seed", static_cast<int>(options.seed));
+            dataset_ = Dataset::Ptr(new SyntheticDataset(options));
+        } else if (dataset_type == "euroc") {
+            dataset_ = Dataset::Ptr(new EurocDataset(file_["dataset_dir"]));
+        } else if (dataset_type == "video" || dataset_type == "pipe") {
+            // rectified pairs, the calibration is not part of the source
+            Camera camera(ReadParam(file_, "camera.fx", 0.0), ReadParam(file_, "camera.fy", 0.0),
+                          ReadParam(file_, "camera.cx", 0.0), ReadParam(file_, "camera.cy", 0.0),
+                          ReadParam(file_, "camera.baseline", 0.0), SE3());
+            std::string source = ReadParam(file_, "dataset.source", std::string());
+            if (dataset_type == "video") {
+                dataset_ = Dataset::Ptr(new VideoDataset(source, camera));
+            } else {
+                dataset_ = Dataset::Ptr(new PipeDataset(source, camera));
+            }
+        } else if (cache_file.empty()) {
+            dataset_ = Dataset::Ptr(new KittiDataset(file_["dataset_dir"]));
+        } else {
+            // pre-decoded images, see convert_kitti_cache
+            dataset_ = Dataset::Ptr(new CachedDataset(file_["dataset_dir"], cache_file));
+        }
+        dataset_->SetPrefetchDepth(ReadParam(file_, "dataset.prefetch_depth", 4));
         CHECK_EQ(dataset_->Init(), true);
 
         // create components and links
         frontend_ = Frontend::Ptr(new Frontend);
         backend_ = Backend::Ptr(new Backend);
         map_ = Map::Ptr(new Map);
-        viewer_ = Viewer::Ptr(new Viewer);
+        if (!headless_ && ReadParam(file_, "viewer.enabled", 1) != 0) {
+            viewer_ = Viewer::Ptr(new Viewer);
+        }
 
         frontend_->SetBackend(backend_);
         frontend_->SetMap(map_);
         frontend_->SetViewer(viewer_);
         frontend_->SetCameras(dataset_->GetCamera(0), dataset_->GetCamera(1));
+        frontend_->SetPipelined(ReadParam(file_, "frontend.pipelined", 1) != 0);
+        frontend_->SetBackendWait(ReadParam(file_, "frontend.backend_wait_ms", 0));
+        std::string pose_solver = ReadParam(file_, "frontend.pose_solver", std::string("g2o"));
+        frontend_->SetPoseSolver(pose_solver == "direct" ? PoseSolverType::DIRECT : PoseSolverType::G2O);
+        std::string detector = ReadParam(file_, "frontend.detector", std::string("gftt"));
+        DetectorType detector_type = DetectorType::GFTT;
+        if (detector == "grid") detector_type = DetectorType::GRID;
+        if (detector == "shi_tomasi") detector_type = DetectorType::SHI_TOMASI;
+        frontend_->SetDetector(detector_type, ReadParam(file_, "frontend.grid_cell_size", 40));
+        std::string optical_flow = ReadParam(file_, "frontend.optical_flow", std::string("opencv"));
+        frontend_->SetOpticalFlow(optical_flow == "klt" ? OpticalFlowType::KLT : OpticalFlowType::OPENCV,
+                                  ReadParam(file_, "frontend.klt_fb_threshold", 0.0));
+        std::string stereo_matching = ReadParam(file_, "frontend.stereo_matching", std::string("optical_flow"));
+        frontend_->SetStereoMatching(
+                stereo_matching == "scanline" ? StereoMatchingType::SCANLINE : StereoMatchingType::OPTICAL_FLOW,
+                ReadParam(file_, "frontend.stereo_max_disparity", 96));
 
         backend_->SetMap(map_);
         backend_->SetCameras(dataset_->GetCamera(0), dataset_->GetCamera(1));
+        backend_->SetMarginalization(ReadParam(file_, "backend.marginalization", 0) != 0);
+        std::string backend_solver = ReadParam(file_, "backend.solver", std::string("g2o"));
+        backend_->SetSolver(backend_solver == "schur" ? BackendSolverType::SCHUR : BackendSolverType::G2O);
+        backend_->SetRecordDir(ReadParam(file_, "backend.record_dir", std::string()));
+
+        if (viewer_) viewer_->SetMap(map_);
 
-        viewer_->SetMap(map_);
+        SetRealtime(ReadParam(file_, "realtime.speed", 0.0), ReadParam(file_, "realtime.deadline_ms", 0.0));
+
+        Profiler::Instance().SetEnabled(ReadParam(file_, "profiler.enabled", 0) != 0);
+        profile_output_ = ReadParam(file_, "profiler.output", std::string());
 
         return true;
     }
 
+    void VisualOdometry::SetRealtime(double speed, double deadline_ms) {
+        scheduler_ = speed > 0 ? RealtimeScheduler::Ptr(new RealtimeScheduler(speed, deadline_ms)) : nullptr;
+    }
+
     void VisualOdometry::Run() {
         while (1) {
             LOG(INFO) << "VO is running";
@@ -39,8 +121,41 @@ namespace myslam {
             }
         }
 
+        Shutdown();
+    }
+
+    void VisualOdometry::Shutdown() {
+        frontend_->Stop();
         backend_->Stop();
-        viewer_->Close();
+        if (viewer_) viewer_->Close();
+
+        if (scheduler_) {
+            const RealtimeStats &stats = scheduler_->Stats();
+            LOG(INFO) << "Real-time frames: " << stats.frames << ", processed " << stats.processed
+                      << ", dropped " << stats.dropped << ", degraded " << stats.degraded
+                      << ", deadline misses " << stats.deadline_misses << ", max latency "
+                      << stats.max_latency_ms << " ms";
+        }
+        if (dataset_->IsLive()) LOG(INFO) << "Stereo pairs dropped by the source: " << dataset_->NumDropped();
+
+        PoolStats pool_stats = BlockPool::TotalStats();
+        LOG(INFO) << "Pool allocations: " << pool_stats.allocations << ", heap allocations "
+                  << pool_stats.heap_allocations << ", live " << pool_stats.live;
+
+        Profiler &profiler = Profiler::Instance();
+        if (profiler.Enabled()) {
+            profiler.Collect();
+            for (auto &s : profiler.Summaries()) {
+                LOG(INFO) << s.name << (s.is_span ? " ms" : "") << ": count " << s.count << ", mean " << s.mean
+                          << ", p50 " << s.p50 << ", p95 " << s.p95 << ", p99 " << s.p99 << ", max " << s.max;
+            }
+            if (!profile_output_.empty()) {
+                bool written = profiler.WriteJson(profile_output_ + ".json") &&
+                               profiler.WriteCsv(profile_output_ + ".csv") &&
+                               profiler.WriteChromeTrace(profile_output_ + ".trace.json");
+                if (!written) LOG(WARNING) << "cannot write the profile to " << profile_output_;
+            }
+        }
 
         LOG(INFO) << "VO exit";
     }
@@ -48,12 +163,38 @@ namespace myslam {
     bool VisualOdometry::Step() {
         Frame::Ptr new_frame = dataset_->NextFrame();
         if (new_frame == nullptr) return false;
+        return AddFrame(new_frame);
+    }
+
+    bool VisualOdometry::AddFrame(Frame::Ptr new_frame) {
+        Profiler &profiler = Profiler::Instance();
+        if (scheduler_) {
+            std::this_thread::sleep_until(scheduler_->Release(new_frame->time_stamp_));
+            RealtimeScheduler::Decision decision = scheduler_->Decide(new_frame->time_stamp_,
+                                                                      RealtimeScheduler::Clock::now());
+            if (decision == RealtimeScheduler::Decision::DROP) {
+                // stale, the next frame is tracked from the last processed one
+                LOG(INFO) << "Drop frame " << new_frame->id_ << ", past its deadline";
+                profiler.RecordCounter("vo.dropped_frames", 1);
+                return true;
+            }
+            frontend_->SetDegraded(decision == RealtimeScheduler::Decision::DEGRADE);
+        }
 
         auto t1 = std::chrono::steady_clock::now();
         bool success = frontend_->AddFrame(new_frame);
         auto t2 = std::chrono::steady_clock::now();
         auto time_used = std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1);
         LOG(INFO) << "VO cost time: " << time_used.count() << " seconds.";
+        if (scheduler_) profiler.RecordCounter("vo.latency_ms", scheduler_->Finish(t2));
+
+        // allocations of the entity pools during this frame, of all threads
+        PoolStats pool_stats = BlockPool::TotalStats();
+        profiler.RecordCounter("vo.pool_allocations", pool_stats.allocations - pool_allocations_);
+        profiler.RecordCounter("vo.heap_allocations", pool_stats.heap_allocations - heap_allocations_);
+        pool_allocations_ = pool_stats.allocations;
+        heap_allocations_ = pool_stats.heap_allocations;
+        if (profiler.Enabled()) profiler.Collect();
         return success;
     }
 }
\ No newline at end of file
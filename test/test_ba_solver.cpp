@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <random>
+#include <opencv2/core/utility.hpp>
+#include "myslam/common_include.h"
+#include "myslam/ba_solver.h"
+
+// stereo window of keyframes moving forward, perturbed poses and points, a prior on the first pose
+static myslam::BAProblem MakeProblem(std::vector<SE3, Eigen::aligned_allocator<SE3>> &poses_true) {
+    myslam::BAProblem problem;
+    problem.K << 350, 0, 300,
+                 0, 350, 100,
+                 0, 0, 1;
+    problem.cam_ext[1] = SE3(SO3(), Vec3(-0.537, 0, 0));
+
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> uniform(-1, 1);
+    std::normal_distribution<double> noise(0, 0.5);
+    poses_true.clear();
+    for (int i = 0; i < 5; ++i) {
+        SE3 pose_true(SO3::exp(Vec3(0, 0.01 * i, 0)), Vec3(0, 0, -1.0 * i));
+        poses_true.push_back(pose_true);
+        Vec6 delta;
+        delta << uniform(rng) * 0.05, uniform(rng) * 0.05, uniform(rng) * 0.05,
+                 uniform(rng) * 0.005, uniform(rng) * 0.005, uniform(rng) * 0.005;
+        problem.AddPose(i == 0 ? pose_true : SE3::exp(delta) * pose_true);
+    }
+
+    for (int j = 0; j < 300; ++j) {
+        Vec3 pw(uniform(rng) * 10, uniform(rng) * 3, 25 + uniform(rng) * 10);
+        int point = problem.AddPoint(pw + 0.1 * Vec3(uniform(rng), uniform(rng), uniform(rng)), j % 50 == 0);
+        if (j % 50 == 0) problem.points[point] = pw;
+        for (int i = 0; i < 5; ++i) {
+            for (int camera = 0; camera < 2; ++camera) {
+                Vec3 pc = problem.cam_ext[camera] * (poses_true[i] * pw);
+                Vec2 pixel(problem.K(0, 0) * pc[0] / pc[2] + problem.K(0, 2) + noise(rng),
+                           problem.K(1, 1) * pc[1] / pc[2] + problem.K(1, 2) + noise(rng));
+                if ((i * 300 + j) % 97 == 0) pixel += Vec2(25, -15); // outlier
+                problem.AddObservation(i, point, camera, pixel);
+            }
+        }
+    }
+
+    problem.prior_poses.push_back(0);
+    problem.prior_linearization.push_back(poses_true[0]);
+    problem.prior_J = 1e3 * MatXX::Identity(6, 6);
+    problem.prior_r0 = VecX::Zero(6);
+    return problem;
+}
+
+TEST(MyslamTest, SchurBASolver) {
+    std::vector<SE3, Eigen::aligned_allocator<SE3>> poses_true;
+    myslam::BAProblem schur = MakeProblem(poses_true);
+    myslam::BAProblem g2o = schur;
+    const double initial_cost = schur.Cost();
+
+    myslam::SchurBASolver schur_solver;
+    myslam::G2OBASolver g2o_solver;
+    double schur_cost = schur_solver.Solve(schur, 10);
+    double g2o_cost = g2o_solver.Solve(g2o, 10);
+
+    EXPECT_LT(schur_cost, initial_cost);
+    EXPECT_NEAR(schur_cost, g2o_cost, 1e-3 * g2o_cost);
+    EXPECT_NEAR(schur_cost, schur.Cost(), 1e-9 * schur_cost);
+    for (size_t i = 0; i < schur.poses.size(); ++i) {
+        EXPECT_NEAR((schur.poses[i].inverse() * g2o.poses[i]).log().norm(), 0, 1e-3);
+    }
+    for (size_t j = 0; j < schur.points.size(); ++j) {
+        EXPECT_NEAR((schur.points[j] - g2o.points[j]).norm(), 0, 1e-2);
+    }
+    for (size_t i = 0; i < schur.poses.size(); ++i) {
+        EXPECT_NEAR((schur.poses[i].inverse() * poses_true[i]).log().norm(), 0, 0.05);
+    }
+}
+
+// the batches, points and chunks of the parallel evaluation are reduced in a fixed order
+TEST(MyslamTest, SchurBASolverThreads) {
+    std::vector<SE3, Eigen::aligned_allocator<SE3>> poses_true;
+    myslam::BAProblem serial = MakeProblem(poses_true);
+    myslam::BAProblem parallel = serial;
+    const int num_threads = cv::getNumThreads();
+
+    cv::setNumThreads(1);
+    double serial_cost = myslam::SchurBASolver().Solve(serial, 10);
+    cv::setNumThreads(std::max(4, num_threads));
+    double parallel_cost = myslam::SchurBASolver().Solve(parallel, 10);
+    cv::setNumThreads(num_threads);
+
+    EXPECT_EQ(serial_cost, parallel_cost);
+    for (size_t i = 0; i < serial.poses.size(); ++i) {
+        EXPECT_TRUE(serial.poses[i].matrix() == parallel.poses[i].matrix()) << "pose " << i;
+    }
+    for (size_t j = 0; j < serial.points.size(); ++j) {
+        EXPECT_TRUE(serial.points[j] == parallel.points[j]) << "point " << j;
+    }
+}
+
+TEST(MyslamTest, BAProblemSaveLoad) {
+    std::vector<SE3, Eigen::aligned_allocator<SE3>> poses_true;
+    myslam::BAProblem problem = MakeProblem(poses_true);
+    std::string path = ::testing::TempDir() + "ba_problem.bin";
+    ASSERT_TRUE(problem.Save(path));
+
+    myslam::BAProblem loaded;
+    ASSERT_TRUE(loaded.Load(path));
+    std::remove(path.c_str());
+    EXPECT_EQ(loaded.poses.size(), problem.poses.size());
+    EXPECT_EQ(loaded.points.size(), problem.points.size());
+    EXPECT_EQ(loaded.NumObservations(), problem.NumObservations());
+    EXPECT_EQ(loaded.prior_poses, problem.prior_poses);
+    EXPECT_NEAR(loaded.Cost(), problem.Cost(), 1e-9 * problem.Cost());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include "myslam/backend.h"
+#include "myslam/common_include.h"
+#include "myslam/feature.h"
+#include "myslam/map.h"
+#include "myslam/mappoint.h"
+
+// stereo keyframe at z observing all the landmarks, in the left and right images
+static myslam::Frame::Ptr CreateKeyframe(double z, const std::vector<myslam::MapPoint::Ptr> &landmarks,
+                                         myslam::Camera::Ptr left, myslam::Camera::Ptr right) {
+    auto frame = myslam::Frame::CreateFrame();
+    frame->SetPose(SE3(SO3(), Vec3(0, 0, -z)));
+    for (auto &mp : landmarks) {
+        Vec2 pl = left->world2pixel(mp->Pos(), frame->Pose());
+        Vec2 pr = right->world2pixel(mp->Pos(), frame->Pose());
+        auto feat_left = myslam::Feature::Create(frame, cv::KeyPoint(cv::Point2f(pl[0], pl[1]), 7));
+        auto feat_right = myslam::Feature::Create(frame, cv::KeyPoint(cv::Point2f(pr[0], pr[1]), 7));
+        feat_right->is_on_left_image_ = false;
+        feat_left->map_point_ = mp;
+        feat_right->map_point_ = mp;
+        mp->AddObservation(feat_left);
+        mp->AddObservation(feat_right);
+        frame->features_left_.push_back(feat_left);
+        frame->features_right_.push_back(feat_right);
+    }
+    frame->SetKeyFrame();
+    return frame;
+}
+
+TEST(MyslamTest, BackendMarginalizationPrior) {
+    myslam::Camera::Ptr left(new myslam::Camera(500, 500, 320, 240, 0.5, SE3()));
+    myslam::Camera::Ptr right(new myslam::Camera(500, 500, 320, 240, 0.5, SE3(SO3(), Vec3(-0.5, 0, 0))));
+
+    std::vector<myslam::MapPoint::Ptr> landmarks;
+    for (int i = 0; i < 40; ++i) {
+        auto mp = myslam::MapPoint::CreateNewMappoint();
+        mp->SetPos(Vec3(-4 + 0.2 * i, -2 + 0.5 * (i % 9), 12 + 2 * (i % 5)));
+        landmarks.push_back(mp);
+    }
+
+    myslam::Map::Ptr map(new myslam::Map);
+    myslam::Backend::Ptr backend(new myslam::Backend);
+    backend->SetMap(map);
+    backend->SetCameras(left, right);
+    backend->SetMarginalization(true);
+
+    // the window holds 7 keyframes, the 8th one makes the first one leave
+    std::vector<myslam::Frame::Ptr> keyframes;
+    for (int i = 0; i < 8; ++i) {
+        keyframes.push_back(CreateKeyframe(0.5 * i, landmarks, left, right));
+        map->InsertKeyFrame(keyframes.back());
+        if (i == 0) map->InsertMapPoints(landmarks);
+        ASSERT_TRUE(backend->WaitForGeneration(backend->UpdateMap(), std::chrono::milliseconds(60000)));
+        if (i < 7) EXPECT_EQ(backend->PriorDimension(), 0);
+    }
+
+    // all the landmarks of the first keyframe are shared with the window, the prior is on them
+    EXPECT_GT(backend->PriorDimension(), 0);
+    EXPECT_EQ(map->GetActiveKeyFrames()->count(keyframes[0]->keyframe_id_), 0u);
+    backend->Stop();
+}
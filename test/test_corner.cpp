@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include "myslam/common_include.h"
+#include "myslam/corner.h"
+
+TEST(MyslamTest, ShiTomasiScore) {
+    // odd width to run the scalar tails of the vectorized loops, stride larger than width
+    const int width = 101, height = 37, stride = 112;
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<int> pixel(0, 255);
+    std::vector<uchar> img(stride * height);
+    for (auto &p : img) p = pixel(rng);
+
+    std::vector<float> score(width * height, -1);
+    myslam::ShiTomasiScore(img.data(), width, height, stride, score.data(), width);
+
+    // reference: sobel, 3x3 box and minimal eigenvalue in double
+    auto I = [&](int x, int y) { return double(img[y * stride + x]); };
+    const double scale = 1.0 / (4 * 3 * 255);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            float s = score[y * width + x];
+            if (x < 2 || y < 2 || x >= width - 2 || y >= height - 2) {
+                EXPECT_EQ(s, 0);
+                continue;
+            }
+            double a = 0, b = 0, c = 0;
+            for (int v = y - 1; v <= y + 1; ++v) {
+                for (int u = x - 1; u <= x + 1; ++u) {
+                    double gx = (I(u + 1, v - 1) - I(u - 1, v - 1)) + 2 * (I(u + 1, v) - I(u - 1, v)) +
+                                (I(u + 1, v + 1) - I(u - 1, v + 1));
+                    double gy = (I(u - 1, v + 1) + 2 * I(u, v + 1) + I(u + 1, v + 1)) -
+                                (I(u - 1, v - 1) + 2 * I(u, v - 1) + I(u + 1, v - 1));
+                    gx *= scale;
+                    gy *= scale;
+                    a += gx * gx;
+                    b += gx * gy;
+                    c += gy * gy;
+                }
+            }
+            double expected = (a + c) / 2 - std::sqrt((a - c) * (a - c) / 4 + b * b);
+            EXPECT_NEAR(s, expected, 1e-5 * (a + c) + 1e-12);
+        }
+    }
+}
+
+TEST(MyslamTest, NonMaxSuppression3x3) {
+    const int width = 23, height = 9;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> uniform(0, 1);
+    std::vector<float> score(width * height);
+    for (auto &s : score) s = uniform(rng);
+
+    std::vector<cv::Point> maxima;
+    int cnt = myslam::NonMaxSuppression3x3(score.data(), width, 1, 1, width - 1, height - 1, 0.5f, maxima);
+    ASSERT_EQ(cnt, int(maxima.size()));
+
+    std::vector<cv::Point> expected;
+    for (int y = 1; y < height - 1; ++y) {
+        for (int x = 1; x < width - 1; ++x) {
+            float s = score[y * width + x];
+            bool is_max = s > 0.5f;
+            for (int v = -1; v <= 1; ++v)
+                for (int u = -1; u <= 1; ++u)
+                    if (score[(y + v) * width + x + u] > s) is_max = false;
+            if (is_max) expected.push_back(cv::Point(x, y));
+        }
+    }
+    ASSERT_EQ(maxima.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(maxima[i].x, expected[i].x);
+        EXPECT_EQ(maxima[i].y, expected[i].y);
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
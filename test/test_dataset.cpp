@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include "myslam/common_include.h"
+#include "myslam/pipe_dataset.h"
+
+// pairs of 4x2 images filled with the index, at 10 Hz
+class CountingDataset : public myslam::Dataset {
+public:
+    explicit CountingDataset(int num_pairs) : Dataset("counting"), num_pairs_(num_pairs) {}
+
+    ~CountingDataset() { StopLoader(); }
+
+protected:
+    bool Open() override {
+        SetStereoCameras(100, 100, 2, 1, 0.5);
+        return true;
+    }
+
+    bool ReadStereoPair(int index, StereoPair &pair) override {
+        if (index >= num_pairs_) return false;
+        pair.left = cv::Mat(2, 4, CV_8UC1);
+        pair.right = cv::Mat(2, 4, CV_8UC1);
+        for (int r = 0; r < 2; ++r) {
+            for (int c = 0; c < 4; ++c) {
+                pair.left.at<uchar>(r, c) = index;
+                pair.right.at<uchar>(r, c) = 255 - index;
+            }
+        }
+        pair.time_stamp = index * 0.1;
+        return true;
+    }
+
+private:
+    int num_pairs_;
+};
+
+TEST(MyslamTest, DatasetPrefetchInOrder) {
+    for (int depth : {0, 1, 4}) {
+        CountingDataset dataset(20);
+        dataset.SetPrefetchDepth(depth);
+        ASSERT_TRUE(dataset.Init());
+        EXPECT_DOUBLE_EQ(dataset.GetCamera(1)->pose().translation()[0], -0.5);
+        for (int i = 0; i < 20; ++i) {
+            myslam::Frame::Ptr frame = dataset.NextFrame();
+            ASSERT_TRUE(frame != nullptr);
+            EXPECT_EQ(frame->left_img_.at<uchar>(1, 3), i);
+            EXPECT_EQ(frame->right_img_.at<uchar>(0, 0), 255 - i);
+            EXPECT_DOUBLE_EQ(frame->time_stamp_, i * 0.1);
+        }
+        EXPECT_TRUE(dataset.NextFrame() == nullptr);
+        EXPECT_TRUE(dataset.NextFrame() == nullptr);
+        EXPECT_EQ(dataset.NumDropped(), 0u);
+    }
+}
+
+TEST(MyslamTest, DatasetLiveDropsOldest) {
+    CountingDataset dataset(20);
+    dataset.SetPrefetchDepth(2);
+    dataset.SetLive(true);
+    ASSERT_TRUE(dataset.Init());
+
+    // the source does not wait for the tracker, the queue keeps the newest pair and the end
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (dataset.NumDropped() < 19 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(dataset.NumDropped(), 19u);
+    myslam::Frame::Ptr frame = dataset.NextFrame();
+    ASSERT_TRUE(frame != nullptr);
+    EXPECT_DOUBLE_EQ(frame->time_stamp_, 1.9);
+    EXPECT_TRUE(dataset.NextFrame() == nullptr);
+}
+
+TEST(MyslamTest, PipeDatasetReadsProducer) {
+    std::string pipe = "/tmp/myslam_test_pipe_" + std::to_string(getpid());
+    ASSERT_EQ(mkfifo(pipe.c_str(), 0600), 0);
+
+    std::thread producer([&pipe] {
+        int fd = open(pipe.c_str(), O_WRONLY);
+        ASSERT_GE(fd, 0);
+        for (int i = 0; i < 3; ++i) {
+            cv::Mat left(3, 5, CV_8UC1), right(3, 5, CV_8UC1);
+            for (int r = 0; r < 3; ++r) {
+                for (int c = 0; c < 5; ++c) {
+                    left.at<uchar>(r, c) = 10 * i + r;
+                    right.at<uchar>(r, c) = 10 * i + c;
+                }
+            }
+            EXPECT_TRUE(myslam::PipeDataset::Write(fd, 0.05 * i, left, right));
+        }
+        close(fd);
+    });
+
+    myslam::Camera camera(200, 200, 2.5, 1.5, 0.1, SE3());
+    myslam::PipeDataset dataset(pipe, camera);
+    EXPECT_TRUE(dataset.IsLive());
+    dataset.SetPrefetchDepth(8);
+    ASSERT_TRUE(dataset.Init());
+    EXPECT_DOUBLE_EQ(dataset.GetCamera(0)->fx_, 200);
+    EXPECT_DOUBLE_EQ(dataset.GetCamera(1)->pose().translation()[0], -0.1);
+    for (int i = 0; i < 3; ++i) {
+        myslam::Frame::Ptr frame = dataset.NextFrame();
+        ASSERT_TRUE(frame != nullptr);
+        EXPECT_EQ(frame->left_img_.rows, 3);
+        EXPECT_EQ(frame->left_img_.cols, 5);
+        EXPECT_EQ(frame->left_img_.at<uchar>(2, 4), 10 * i + 2);
+        EXPECT_EQ(frame->right_img_.at<uchar>(2, 4), 10 * i + 4);
+        EXPECT_DOUBLE_EQ(frame->time_stamp_, 0.05 * i);
+    }
+    // the producer closed the pipe
+    EXPECT_TRUE(dataset.NextFrame() == nullptr);
+    EXPECT_EQ(dataset.NumDropped(), 0u);
+
+    producer.join();
+    unlink(pipe.c_str());
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include "myslam/backend.h"
+#include "myslam/common_include.h"
+#include "myslam/feature.h"
+#include "myslam/frontend.h"
+#include "myslam/mappoint.h"
+#include "myslam/synthetic_dataset.h"
+
+// keyframes and landmarks of a run of the frontend on the synthetic sequence
+struct PipelineRun {
+    size_t num_keyframes = 0;
+    size_t num_landmarks = 0;
+    int duplicates = 0; // landmarks of a keyframe at the same pixel as another one
+};
+
+static PipelineRun RunFrontend(bool pipelined) {
+    myslam::SyntheticDataset::Options options;
+    options.width = 320;
+    options.height = 120;
+    options.fx = options.fy = 185;
+    options.num_frames = 40;
+    options.seed = 3;
+    myslam::SyntheticDataset dataset(options);
+    EXPECT_TRUE(dataset.Init());
+
+    myslam::Map::Ptr map(new myslam::Map);
+    myslam::Backend::Ptr backend(new myslam::Backend);
+    backend->SetMap(map);
+    backend->SetCameras(dataset.GetCamera(0), dataset.GetCamera(1));
+    myslam::Frontend frontend;
+    frontend.SetMap(map);
+    frontend.SetBackend(backend);
+    frontend.SetCameras(dataset.GetCamera(0), dataset.GetCamera(1));
+    frontend.SetPipelined(pipelined);
+    // each keyframe starts from the optimized window, so both runs see the same map
+    frontend.SetBackendWait(60000);
+
+    for (myslam::Frame::Ptr frame = dataset.NextFrame(); frame; frame = dataset.NextFrame()) {
+        frontend.AddFrame(frame);
+    }
+    frontend.Stop();
+    backend->Stop();
+
+    PipelineRun run;
+    auto keyframes = map->GetAllKeyFrames();
+    run.num_keyframes = keyframes->size();
+    run.num_landmarks = map->GetAllMapPoints()->size();
+    for (auto &keyframe : *keyframes) {
+        std::vector<std::pair<cv::Point2f, myslam::MapPoint::Ptr>> observed;
+        for (auto &feat : keyframe.second->features_left_) {
+            auto mp = feat->map_point_.lock();
+            if (mp == nullptr) continue;
+            for (auto &other : observed) {
+                if (other.second != mp && cv::norm(other.first - feat->position_.pt) < 1.0) run.duplicates++;
+            }
+            observed.push_back({feat->position_.pt, mp});
+        }
+    }
+    return run;
+}
+
+TEST(MyslamTest, FrontendPipelineMatchesSerial) {
+    PipelineRun serial = RunFrontend(false);
+    PipelineRun pipelined = RunFrontend(true);
+    ASSERT_GT(serial.num_keyframes, 1u);
+
+    // the job of a keyframe is waited for before the next keyframe decision
+    EXPECT_EQ(pipelined.num_keyframes, serial.num_keyframes);
+    EXPECT_EQ(pipelined.num_landmarks, serial.num_landmarks);
+    // no corner is detected and triangulated again by the next keyframe
+    EXPECT_EQ(pipelined.duplicates, serial.duplicates);
+}
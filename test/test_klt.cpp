@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <opencv2/opencv.hpp>
+#include "myslam/common_include.h"
+#include "myslam/klt.h"
+
+TEST(MyslamTest, KltTracker) {
+    // textured image and the same image shifted by a sub-pixel offset
+    cv::Mat img(188, 620, CV_8UC1);
+    cv::RNG rng(0);
+    rng.fill(img, cv::RNG::UNIFORM, 0, 256);
+    cv::GaussianBlur(img, img, cv::Size(7, 7), 2.0);
+    const cv::Point2f shift(2.3f, -1.7f);
+    cv::Mat warp = (cv::Mat_<double>(2, 3) << 1, 0, shift.x, 0, 1, shift.y);
+    cv::Mat shifted;
+    cv::warpAffine(img, shifted, warp, img.size(), cv::INTER_LINEAR, cv::BORDER_REFLECT_101);
+
+    const cv::Size win_size(11, 11);
+    std::vector<cv::Mat> prev_pyramid, next_pyramid;
+    cv::buildOpticalFlowPyramid(img, prev_pyramid, win_size, 3, true);
+    cv::buildOpticalFlowPyramid(shifted, next_pyramid, win_size, 3, false);
+
+    std::vector<cv::Point2f> prev_pts;
+    for (int y = 20; y < img.rows - 20; y += 15) {
+        for (int x = 20; x < img.cols - 20; x += 15) {
+            prev_pts.push_back(cv::Point2f(x, y));
+        }
+    }
+
+    myslam::KltTracker klt(win_size);
+    klt.SetForwardBackwardCheck(0.5);
+    std::vector<cv::Point2f> next_pts = prev_pts;
+    std::vector<uchar> status;
+    int num_tracked = klt.Track(prev_pyramid, next_pyramid, prev_pts, next_pts, status);
+    EXPECT_GT(num_tracked, int(prev_pts.size() * 0.95));
+
+    for (size_t i = 0; i < prev_pts.size(); ++i) {
+        if (!status[i]) continue;
+        cv::Point2f err = next_pts[i] - prev_pts[i] - shift;
+        EXPECT_LT(std::abs(err.x), 0.1);
+        EXPECT_LT(std::abs(err.y), 0.1);
+    }
+
+    // a point outside of the image is not tracked
+    std::vector<cv::Point2f> outside{cv::Point2f(-50, -50)}, outside_next = outside;
+    EXPECT_EQ(klt.Track(prev_pyramid, next_pyramid, outside, outside_next, status), 0);
+    EXPECT_EQ(status[0], 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
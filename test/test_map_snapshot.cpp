@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include "myslam/common_include.h"
+#include "myslam/map.h"
+
+TEST(MyslamTest, MapSnapshotShared) {
+    myslam::Map map;
+    std::vector<myslam::MapPoint::Ptr> map_points;
+    for (int i = 0; i < 10; ++i) {
+        map_points.push_back(myslam::MapPoint::CreateNewMappoint());
+    }
+    // a batch of active landmarks is published once, all landmarks are not
+    map.InsertMapPoints(map_points);
+    EXPECT_EQ(map.NumSnapshotsPublished(), 1u);
+
+    // readers share the published snapshot, without copying
+    auto landmarks = map.GetActiveMapPoints();
+    EXPECT_EQ(landmarks->size(), 10u);
+    EXPECT_EQ(map.GetActiveMapPoints(), landmarks);
+    EXPECT_EQ(map.NumSnapshotsPublished(), 1u);
+
+    // a change publishes a new snapshot, the old one is unchanged
+    map.InsertMapPoint(myslam::MapPoint::CreateNewMappoint());
+    EXPECT_EQ(map.NumSnapshotsPublished(), 2u);
+    auto updated = map.GetActiveMapPoints();
+    EXPECT_NE(updated, landmarks);
+    EXPECT_EQ(landmarks->size(), 10u);
+    EXPECT_EQ(updated->size(), 11u);
+    EXPECT_EQ(map.NumSnapshotsPublished(), 2u);
+
+    // all landmarks are copied on the first read after a change only
+    auto all = map.GetAllMapPoints();
+    EXPECT_EQ(all->size(), 11u);
+    EXPECT_EQ(map.GetAllMapPoints(), all);
+    EXPECT_EQ(map.NumSnapshotsPublished(), 3u);
+
+    // the landmarks are not observed, cleaning removes them from the new snapshot only
+    map.CleanMap();
+    auto cleaned = map.GetActiveMapPoints();
+    EXPECT_TRUE(cleaned->empty());
+    EXPECT_EQ(updated->size(), 11u);
+
+    // cleaning without removal keeps the snapshot
+    map.CleanMap();
+    EXPECT_EQ(map.GetActiveMapPoints(), cleaned);
+    EXPECT_EQ(map.NumSnapshotsPublished(), 4u);
+}
+
+TEST(MyslamTest, MapSnapshotKeyframes) {
+    myslam::Map map;
+    EXPECT_TRUE(map.GetActiveKeyFrames()->empty());
+    auto frame = myslam::Frame::CreateFrame();
+    frame->SetKeyFrame();
+    map.InsertKeyFrame(frame);
+
+    auto keyframes = map.GetActiveKeyFrames();
+    ASSERT_EQ(keyframes->size(), 1u);
+    EXPECT_EQ(keyframes->at(frame->keyframe_id_), frame);
+    EXPECT_EQ(map.GetActiveKeyFrames(), keyframes);
+}
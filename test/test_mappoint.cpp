@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include "myslam/common_include.h"
+#include "myslam/feature.h"
+#include "myslam/mappoint.h"
+#include "myslam/small_vector.h"
+
+TEST(MyslamTest, SmallVectorGrow) {
+    myslam::SmallVector<std::shared_ptr<int>, 2> values;
+    for (int i = 0; i < 5; ++i) values.push_back(std::make_shared<int>(i));
+    ASSERT_EQ(values.size(), 5u);
+    for (int i = 0; i < 5; ++i) EXPECT_EQ(*values[i], i);
+
+    values.swap_remove(1);
+    ASSERT_EQ(values.size(), 4u);
+    EXPECT_EQ(*values[1], 4);
+
+    // the removed elements are released
+    auto last = values.back();
+    values.pop_back();
+    EXPECT_EQ(last.use_count(), 1);
+}
+
+TEST(MyslamTest, MapPointRemoveObservation) {
+    auto mp = myslam::MapPoint::CreateNewMappoint();
+    std::vector<myslam::Feature::Ptr> features;
+    for (int i = 0; i < 12; ++i) {
+        auto feat = std::make_shared<myslam::Feature>();
+        feat->map_point_ = mp;
+        mp->AddObservation(feat);
+        features.push_back(feat);
+    }
+
+    // remove in an order which moves observations from the end
+    for (int i : {0, 5, 11, 3}) {
+        mp->RemoveObservation(features[i]);
+        EXPECT_TRUE(features[i]->map_point_.expired());
+    }
+    EXPECT_EQ(mp->observed_times_, 8);
+
+    // a feature which is not an observation is ignored
+    auto other = std::make_shared<myslam::Feature>();
+    other->map_point_ = mp;
+    mp->RemoveObservation(other);
+    EXPECT_FALSE(other->map_point_.expired());
+    EXPECT_EQ(mp->observed_times_, 8);
+
+    std::set<myslam::Feature *> observed;
+    mp->ForEachObservation([&](const myslam::Feature::Ptr &feat) { observed.insert(feat.get()); });
+    std::set<myslam::Feature *> expected;
+    for (int i : {1, 2, 4, 6, 7, 8, 9, 10}) expected.insert(features[i].get());
+    EXPECT_EQ(observed, expected);
+
+    // released features are skipped
+    mp->RemoveObservation(features[1]);
+    features[2].reset();
+    int count = 0;
+    mp->ForEachObservation([&](const myslam::Feature::Ptr &) { count++; });
+    EXPECT_EQ(count, 6);
+}
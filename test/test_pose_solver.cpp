@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "myslam/common_include.h"
+#include "myslam/pose_solver.h"
+
+TEST(MyslamTest, PoseSolver) {
+    Mat33 K;
+    K << 350, 0, 300,
+         0, 350, 100,
+         0, 0, 1;
+    SE3 pose_true(SO3::exp(Vec3(0.05, -0.1, 0.02)), Vec3(0.3, -0.1, 1.0));
+
+    myslam::PoseSolver solver;
+    solver.SetCamera(K);
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> uniform(-1, 1);
+    std::normal_distribution<double> noise(0, 0.5);
+    const int num_points = 150;
+    for (int i = 0; i < num_points; ++i) {
+        Vec3 pw(uniform(rng) * 10, uniform(rng) * 3, 25 + uniform(rng) * 15);
+        Vec3 pc = pose_true * pw;
+        Vec2 pixel(K(0, 0) * pc[0] / pc[2] + K(0, 2) + noise(rng),
+                   K(1, 1) * pc[1] / pc[2] + K(1, 2) + noise(rng));
+        if (i % 10 == 0) pixel += Vec2(30, -20); // outlier
+        solver.AddObservation(pw, pixel);
+    }
+
+    SE3 pose(SO3(), Vec3(0.2, 0, 0.8));
+    int num_inliers = solver.Solve(pose);
+
+    EXPECT_EQ(num_inliers, num_points - num_points / 10);
+    for (int i = 0; i < num_points; i += 10) {
+        EXPECT_TRUE(solver.IsOutlier(i));
+    }
+    EXPECT_NEAR((pose.inverse() * pose_true).log().norm(), 0, 0.05);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
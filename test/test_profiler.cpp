@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include "myslam/common_include.h"
+#include "myslam/pool.h"
+#include "myslam/profiler.h"
+
+TEST(MyslamTest, BlockPoolRecycles) {
+    myslam::BlockPool pool(40, 16, 4);
+    std::vector<void *> blocks;
+    for (int i = 0; i < 6; ++i) {
+        blocks.push_back(pool.Allocate());
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(blocks.back()) % 16, 0u);
+    }
+    EXPECT_EQ(pool.Stats().heap_allocations, 2u);
+
+    // freed blocks are handed out again without a new chunk
+    for (void *block : blocks) pool.Deallocate(block);
+    for (int i = 0; i < 6; ++i) pool.Allocate();
+    myslam::PoolStats stats = pool.Stats();
+    EXPECT_EQ(stats.heap_allocations, 2u);
+    EXPECT_EQ(stats.allocations, 12u);
+    EXPECT_EQ(stats.live, 6u);
+}
+
+TEST(MyslamTest, MakePooledShared) {
+    auto a = myslam::MakePooled<std::vector<int>>(3, 7);
+    std::weak_ptr<std::vector<int>> weak = a;
+    EXPECT_EQ(a->size(), 3u);
+    a.reset();
+    EXPECT_TRUE(weak.expired());
+    weak.reset();
+
+    // the block of the released object and its control block is reused
+    unsigned long heap = myslam::BlockPool::TotalStats().heap_allocations;
+    auto b = myslam::MakePooled<std::vector<int>>(2, 1);
+    EXPECT_EQ(myslam::BlockPool::TotalStats().heap_allocations, heap);
+}
+
+TEST(MyslamTest, FrameArenaReleasedWithObjects) {
+    const unsigned long live_chunks = myslam::FrameArena::ChunkStats().live;
+    {
+        auto arena = myslam::MakePooled<myslam::FrameArena>();
+        std::vector<std::shared_ptr<Vec4>> objects;
+        for (int i = 0; i < 1000; ++i) {
+            objects.push_back(myslam::MakeInArena<Vec4>(arena, Vec4::Constant(i)));
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(objects.back().get()) % 16, 0u);
+        }
+        EXPECT_GT(arena->NumChunks(), 1u);
+        EXPECT_EQ(arena->NumLive(), 1000u);
+        EXPECT_EQ((*objects[999])[3], 999);
+
+        // the objects keep the arena and its chunks
+        std::weak_ptr<myslam::FrameArena> weak = arena;
+        arena.reset();
+        EXPECT_FALSE(weak.expired());
+        EXPECT_GT(myslam::FrameArena::ChunkStats().live, live_chunks);
+        objects.clear();
+        EXPECT_TRUE(weak.expired());
+    }
+    EXPECT_EQ(myslam::FrameArena::ChunkStats().live, live_chunks);
+
+    // the chunks are reused by the next arena
+    const unsigned long heap = myslam::FrameArena::ChunkStats().heap_allocations;
+    auto arena = myslam::MakePooled<myslam::FrameArena>();
+    std::vector<std::shared_ptr<Vec4>> objects;
+    for (int i = 0; i < 1000; ++i) objects.push_back(myslam::MakeInArena<Vec4>(arena));
+    EXPECT_EQ(myslam::FrameArena::ChunkStats().heap_allocations, heap);
+}
+
+TEST(MyslamTest, ProfilerSummaries) {
+    myslam::Profiler &profiler = myslam::Profiler::Instance();
+    profiler.Clear();
+    profiler.SetEnabled(true);
+    std::thread worker([&] {
+        for (int i = 1; i <= 100; ++i) profiler.RecordCounter("test.counter", i);
+    });
+    for (int i = 0; i < 10; ++i) {
+        myslam::ScopedTimer timer("test.span");
+    }
+    worker.join();
+    profiler.Collect();
+    profiler.SetEnabled(false);
+    profiler.RecordCounter("test.counter", 1000); // disabled, not recorded
+    profiler.Collect();
+
+    auto summaries = profiler.Summaries();
+    ASSERT_EQ(summaries.size(), 2u);
+    EXPECT_EQ(summaries[0].name, "test.counter");
+    EXPECT_EQ(summaries[0].count, 100u);
+    EXPECT_EQ(summaries[0].p50, 50);
+    EXPECT_EQ(summaries[0].p95, 95);
+    EXPECT_EQ(summaries[0].p99, 99);
+    EXPECT_EQ(summaries[0].max, 100);
+    EXPECT_EQ(summaries[1].name, "test.span");
+    EXPECT_TRUE(summaries[1].is_span);
+    EXPECT_EQ(summaries[1].count, 10u);
+
+    const std::string path = "test_profiler.trace.json";
+    ASSERT_TRUE(profiler.WriteChromeTrace(path));
+    std::ifstream file(path);
+    std::string trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_NE(trace.find("\"ph\": \"X\""), std::string::npos);
+    EXPECT_NE(trace.find("\"ph\": \"C\""), std::string::npos);
+    std::remove(path.c_str());
+    profiler.Clear();
+}
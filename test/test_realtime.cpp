@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include "myslam/common_include.h"
+#include "myslam/realtime.h"
+
+using Decision = myslam::RealtimeScheduler::Decision;
+
+static std::chrono::steady_clock::duration Ms(double ms) {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double, std::milli>(ms));
+}
+
+static double ToMs(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+TEST(MyslamTest, RealtimeReleaseAtTimeStamps) {
+    // twice the camera rate
+    myslam::RealtimeScheduler scheduler(2.0);
+    auto start = scheduler.Release(10.0);
+    EXPECT_EQ(scheduler.Release(10.0), start);
+    EXPECT_NEAR(ToMs(scheduler.Release(10.1) - start), 50, 1e-3);
+    EXPECT_NEAR(ToMs(scheduler.Release(11.0) - start), 500, 1e-3);
+}
+
+TEST(MyslamTest, RealtimeDropsStaleFrames) {
+    // 10 Hz, the deadline is the period
+    myslam::RealtimeScheduler scheduler;
+    auto start = scheduler.Release(0.0);
+
+    // the first frame is never dropped
+    EXPECT_EQ(scheduler.Decide(0.0, start + Ms(500)), Decision::PROCESS);
+    scheduler.Finish(start + Ms(520));
+
+    // frames 1 to 4 were released while the first was processed
+    EXPECT_EQ(scheduler.Decide(0.1, start + Ms(520)), Decision::DROP);
+    EXPECT_EQ(scheduler.Decide(0.2, start + Ms(520)), Decision::DROP);
+    EXPECT_EQ(scheduler.Decide(0.3, start + Ms(520)), Decision::DROP);
+    EXPECT_EQ(scheduler.Decide(0.4, start + Ms(520)), Decision::DROP);
+    // late by more than half of the period, without the optional work
+    EXPECT_EQ(scheduler.Decide(0.5, start + Ms(570)), Decision::DEGRADE);
+    EXPECT_NEAR(scheduler.Finish(start + Ms(590)), 90, 1e-3);
+    // on time, but finished after the deadline
+    EXPECT_EQ(scheduler.Decide(0.6, start + Ms(610)), Decision::PROCESS);
+    EXPECT_NEAR(scheduler.Finish(start + Ms(750)), 150, 1e-3);
+
+    const myslam::RealtimeStats &stats = scheduler.Stats();
+    EXPECT_EQ(stats.frames, 7u);
+    EXPECT_EQ(stats.processed, 3u);
+    EXPECT_EQ(stats.dropped, 4u);
+    EXPECT_EQ(stats.degraded, 1u);
+    EXPECT_EQ(stats.deadline_misses, 1u); // the first frame has no period, so no deadline
+    EXPECT_NEAR(stats.max_latency_ms, 520, 1e-3);
+}
+
+TEST(MyslamTest, RealtimeFixedDeadline) {
+    myslam::RealtimeScheduler scheduler(1.0, 300);
+    auto start = scheduler.Release(0.0);
+    EXPECT_EQ(scheduler.Decide(0.0, start), Decision::PROCESS);
+    scheduler.Finish(start + Ms(240));
+    // within the deadline of 300 ms although later than the period
+    EXPECT_EQ(scheduler.Decide(0.1, start + Ms(240)), Decision::PROCESS);
+    scheduler.Finish(start + Ms(260));
+    EXPECT_EQ(scheduler.Decide(0.2, start + Ms(400)), Decision::DEGRADE);
+    EXPECT_EQ(scheduler.Stats().deadline_misses, 0u);
+}
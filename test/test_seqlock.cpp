@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "myslam/common_include.h"
+#include "myslam/seqlock.h"
+
+TEST(MyslamTest, SeqLockedNotTorn) {
+    myslam::SeqLocked<3> value;
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (int i = 1; i <= 200000; ++i) {
+            const double v[3] = {double(i), double(i), double(i)};
+            value.Store(v);
+        }
+        done = true;
+    });
+
+    int torn = 0;
+    double last = 0;
+    bool monotonic = true;
+    while (!done) {
+        double v[3];
+        value.Load(v);
+        torn += v[0] != v[1] || v[1] != v[2];
+        monotonic &= v[0] >= last;
+        last = v[0];
+    }
+    writer.join();
+
+    double v[3];
+    value.Load(v);
+    EXPECT_EQ(torn, 0);
+    EXPECT_TRUE(monotonic);
+    EXPECT_EQ(v[0], 200000);
+}
+
+TEST(MyslamTest, SeqLockWriters) {
+    // two writers of the same data are serialized
+    myslam::SeqLock lock;
+    long counter = 0;
+    auto write = [&] {
+        for (int i = 0; i < 100000; ++i) {
+            lock.WriteLock();
+            counter++;
+            lock.WriteUnlock();
+        }
+    };
+    std::thread a(write), b(write);
+    a.join();
+    b.join();
+    EXPECT_EQ(counter, 200000);
+
+    uint64_t seq = lock.ReadBegin();
+    EXPECT_FALSE(lock.ReadRetry(seq));
+    lock.WriteLock();
+    lock.WriteUnlock();
+    EXPECT_TRUE(lock.ReadRetry(seq));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
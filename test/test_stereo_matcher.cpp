@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include <opencv2/opencv.hpp>
+#include "myslam/common_include.h"
+#include "myslam/stereo_matcher.h"
+
+TEST(MyslamTest, StereoMatcher) {
+    // rectified pair of a fronto-parallel plane, constant disparity
+    cv::Mat left(188, 620, CV_8UC1);
+    cv::RNG rng(0);
+    rng.fill(left, cv::RNG::UNIFORM, 0, 256);
+    cv::GaussianBlur(left, left, cv::Size(5, 5), 1.2);
+    const float disparity = 12.4f;
+    cv::Mat warp = (cv::Mat_<double>(2, 3) << 1, 0, -disparity, 0, 1, 0);
+    cv::Mat right;
+    cv::warpAffine(left, right, warp, left.size(), cv::INTER_LINEAR, cv::BORDER_REFLECT_101);
+
+    std::vector<cv::Point2f> left_pts;
+    for (int y = 10; y < left.rows - 10; y += 12) {
+        for (int x = 110; x < left.cols - 10; x += 12) {
+            left_pts.push_back(cv::Point2f(x, y));
+        }
+    }
+
+    myslam::StereoMatcher matcher;
+    std::vector<cv::Point2f> right_pts;
+    std::vector<uchar> status;
+    // without prediction, with a close prediction and with a prediction too far to bound the search
+    for (float prediction : {-1.0f, 11.0f, 25.0f}) {
+        std::vector<float> predicted(left_pts.size(), prediction);
+        int num_matched = matcher.Match(left, right, left_pts, predicted, right_pts, status);
+        EXPECT_GT(num_matched, int(left_pts.size() * 0.95));
+        for (size_t i = 0; i < left_pts.size(); ++i) {
+            if (!status[i]) continue;
+            EXPECT_EQ(right_pts[i].y, left_pts[i].y);
+            EXPECT_NEAR(left_pts[i].x - right_pts[i].x, disparity, 0.3);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
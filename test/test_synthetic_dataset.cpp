@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include "myslam/common_include.h"
+#include "myslam/synthetic_dataset.h"
+
+static myslam::SyntheticDataset::Options SmallOptions() {
+    myslam::SyntheticDataset::Options options;
+    options.width = 160;
+    options.height = 60;
+    options.fx = options.fy = 90;
+    options.num_frames = 5;
+    options.seed = 7;
+    return options;
+}
+
+static bool SameImage(const cv::Mat &a, const cv::Mat &b) {
+    if (a.rows != b.rows || a.cols != b.cols) return false;
+    for (int v = 0; v < a.rows; ++v) {
+        if (std::memcmp(a.ptr<uchar>(v), b.ptr<uchar>(v), a.cols) != 0) return false;
+    }
+    return true;
+}
+
+TEST(MyslamTest, SyntheticDatasetDeterministic) {
+    myslam::SyntheticDataset a(SmallOptions()), b(SmallOptions());
+    ASSERT_TRUE(a.Init());
+    ASSERT_TRUE(b.Init());
+    for (int i = 0; i < 3; ++i) {
+        myslam::Frame::Ptr fa = a.NextFrame(), fb = b.NextFrame();
+        ASSERT_TRUE(fa != nullptr && fb != nullptr);
+        EXPECT_TRUE(SameImage(fa->left_img_, fb->left_img_));
+        EXPECT_TRUE(SameImage(fa->right_img_, fb->right_img_));
+    }
+
+    // another seed, another texture
+    myslam::SyntheticDataset::Options options = SmallOptions();
+    options.seed = 8;
+    myslam::SyntheticDataset c(options);
+    ASSERT_TRUE(c.Init());
+    myslam::SyntheticDataset d(SmallOptions());
+    ASSERT_TRUE(d.Init());
+    EXPECT_FALSE(SameImage(c.NextFrame()->left_img_, d.NextFrame()->left_img_));
+}
+
+TEST(MyslamTest, SyntheticDatasetSequence) {
+    myslam::SyntheticDataset dataset(SmallOptions());
+    ASSERT_TRUE(dataset.Init());
+    EXPECT_EQ(dataset.GroundTruth().size(), 5u);
+    EXPECT_DOUBLE_EQ(dataset.GetCamera(1)->pose().translation()[0], -0.537);
+
+    for (int i = 0; i < 5; ++i) {
+        myslam::Frame::Ptr frame = dataset.NextFrame();
+        ASSERT_TRUE(frame != nullptr);
+        EXPECT_EQ(frame->left_img_.rows, 60);
+        EXPECT_EQ(frame->left_img_.cols, 160);
+        EXPECT_EQ(frame->left_img_.type(), CV_8UC1);
+        EXPECT_DOUBLE_EQ(frame->time_stamp_, i / 10.0);
+    }
+    EXPECT_TRUE(dataset.NextFrame() == nullptr);
+}
+
+TEST(MyslamTest, SyntheticDatasetStereoConsistent) {
+    myslam::SyntheticDataset::Options options = SmallOptions();
+    options.noise = 0;
+    myslam::SyntheticDataset dataset(options);
+    ASSERT_TRUE(dataset.Init());
+    myslam::Frame::Ptr frame = dataset.NextFrame();
+    ASSERT_TRUE(frame != nullptr);
+
+    // points on the right wall (x = 6) project to the same gray level in both images
+    myslam::Camera::Ptr left = dataset.GetCamera(0), right = dataset.GetCamera(1);
+    const SE3 Tcw = dataset.GroundTruth()[0].inverse();
+    int compared = 0, close = 0;
+    for (double z = 4; z < 20; z += 0.37) {
+        for (double y = -1.5; y < 1.5; y += 0.23) {
+            Vec2 pl = left->world2pixel(Vec3(6, y, z), Tcw), pr = right->world2pixel(Vec3(6, y, z), Tcw);
+            if (pr[0] < 0 || pl[0] >= options.width - 1 || pl[1] < 0 || pl[1] >= options.height - 1) continue;
+            int l = frame->left_img_.at<uchar>(std::lround(pl[1]), std::lround(pl[0]));
+            int r = frame->right_img_.at<uchar>(std::lround(pr[1]), std::lround(pr[0]));
+            compared++;
+            if (std::abs(l - r) <= 24) close++;
+        }
+    }
+    ASSERT_GT(compared, 50);
+    // rounding to pixels may land across an edge of a block
+    EXPECT_GT(close, compared * 8 / 10);
+}
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include "myslam/common_include.h"
+#include "myslam/trajectory.h"
+
+// forward motion with a slow turn
+static myslam::Trajectory MakeTruth() {
+    myslam::Trajectory truth;
+    for (int i = 0; i < 50; ++i) {
+        truth.push_back(SE3(SO3::exp(Vec3(0, 0.02 * i, 0)), Vec3(0.1 * i * i / 50.0, 0, 1.0 * i)));
+    }
+    return truth;
+}
+
+TEST(MyslamTest, TrajectoryErrorAligned) {
+    myslam::Trajectory truth = MakeTruth();
+
+    // the estimate is in another world frame, the alignment removes it
+    SE3 world(SO3::exp(Vec3(0.1, -0.3, 0.2)), Vec3(5, -2, 1));
+    myslam::Trajectory estimate;
+    for (auto &pose : truth) estimate.push_back(world * pose);
+    myslam::TrajectoryError error = myslam::EvaluateTrajectory(estimate, truth);
+    EXPECT_EQ(error.num_poses, 50u);
+    EXPECT_LT(error.ate, 1e-9);
+    EXPECT_LT(error.rpe_translation, 1e-9);
+    EXPECT_LT(error.rpe_rotation, 1e-6);
+
+    // a drift of 1 cm per frame along x
+    for (size_t i = 0; i < estimate.size(); ++i) {
+        estimate[i] = world * SE3(SO3(), Vec3(0.01 * i, 0, 0)) * truth[i];
+    }
+    error = myslam::EvaluateTrajectory(estimate, truth);
+    EXPECT_GT(error.ate, 1e-3);
+    EXPECT_NEAR(error.rpe_translation, 0.01, 1e-9);
+}
+
+TEST(MyslamTest, LoadKittiPoses) {
+    const std::string path = "test_trajectory_poses.txt";
+    {
+        std::ofstream file(path);
+        file << "1 0 0 0 0 1 0 0 0 0 1 0\n";
+        file << "1 0 0 0.5 0 1 0 -0.1 0 0 1 2.0\n";
+    }
+    myslam::Trajectory poses;
+    ASSERT_TRUE(myslam::LoadKittiPoses(path, poses));
+    std::remove(path.c_str());
+    ASSERT_EQ(poses.size(), 2u);
+    EXPECT_NEAR((poses[1].translation() - Vec3(0.5, -0.1, 2.0)).norm(), 0, 1e-12);
+    EXPECT_FALSE(myslam::LoadKittiPoses("no_such_file.txt", poses));
+}
@@ -23,6 +23,77 @@ TEST(MyslamTest, Triangulation) {
     EXPECT_NEAR(pt_world[2], pt_world_estimated[2], 0.01);
 }
 
+TEST(MyslamTest, TriangulationBatch) {
+    // stereo rig, the batch must agree with triangulation() of each point
+    SE3 left(SO3(), Vec3(0, 0, 0)), right(SO3(), Vec3(-0.5, 0, 0));
+    std::vector<SE3> poses{left, right};
+    std::vector<Vec3> pts_world{Vec3(3, 2, 10), Vec3(-5, 1, 30), Vec3(0.5, -1, 5), Vec3(10, 0, 60)};
+
+    myslam::TriangulationBatch batch;
+    for (auto &pw : pts_world) {
+        Vec3 pl = left * pw, pr = right * pw;
+        batch.Add(pl / pl[2], pr / pr[2]);
+    }
+    // a mismatched pair, rows differ in the two views
+    batch.Add(Vec3(0.1, 0.1, 1), Vec3(0.05, 0.3, 1));
+
+    EXPECT_EQ(myslam::triangulation(left, right, batch), int(pts_world.size()));
+    for (size_t i = 0; i < pts_world.size(); ++i) {
+        EXPECT_TRUE(batch.success[i]);
+        EXPECT_NEAR(pts_world[i][0], batch.px[i], 0.01);
+        EXPECT_NEAR(pts_world[i][1], batch.py[i], 0.01);
+        EXPECT_NEAR(pts_world[i][2], batch.pz[i], 0.01);
+
+        Vec3 pt_single;
+        std::vector<Vec3> points{Vec3(batch.x0[i], batch.y0[i], 1), Vec3(batch.x1[i], batch.y1[i], 1)};
+        myslam::triangulation(poses, points, pt_single);
+        EXPECT_NEAR((pt_single - batch.Point(i)).norm(), 0, 1e-6);
+    }
+    EXPECT_FALSE(batch.success[pts_world.size()]);
+}
+
+TEST(MyslamTest, TriangulationBatchThreshold) {
+    // vertical mismatches around the threshold of triangulation(), sigma_4 / sigma_3 < 1e-2
+    SE3 left(SO3(), Vec3(0, 0, 0)), right(SO3(), Vec3(-0.5, 0, 0));
+    std::vector<SE3> poses{left, right};
+    Vec3 pw(1, 0.5, 8);
+    Vec3 pl = left * pw, pr = right * pw;
+    pl /= pl[2];
+    pr /= pr[2];
+
+    myslam::TriangulationBatch batch;
+    std::vector<double> ratios;
+    for (double dy = 1e-4; dy < 1; dy *= 1.1) {
+        Vec3 pr_mismatched = pr + Vec3(0, dy, 0);
+        batch.Add(pl, pr_mismatched);
+
+        Mat44 D;
+        D.row(0) = pl[0] * left.matrix3x4().row(2) - left.matrix3x4().row(0);
+        D.row(1) = pl[1] * left.matrix3x4().row(2) - left.matrix3x4().row(1);
+        D.row(2) = pr_mismatched[0] * right.matrix3x4().row(2) - right.matrix3x4().row(0);
+        D.row(3) = pr_mismatched[1] * right.matrix3x4().row(2) - right.matrix3x4().row(1);
+        Vec4 sigma = D.jacobiSvd().singularValues();
+        ratios.push_back(sigma[3] / sigma[2]);
+    }
+    myslam::triangulation(left, right, batch);
+
+    int cnt_good = 0, cnt_bad = 0;
+    for (size_t i = 0; i < batch.Size(); ++i) {
+        Vec3 pt_single;
+        std::vector<Vec3> points{Vec3(batch.x0[i], batch.y0[i], 1), Vec3(batch.x1[i], batch.y1[i], 1)};
+        bool success = myslam::triangulation(poses, points, pt_single);
+        // the batch is never looser than triangulation()
+        if (batch.success[i]) EXPECT_TRUE(success) << "ratio " << ratios[i];
+        // and agrees with it, but within a factor of sqrt(3) below the threshold
+        if (ratios[i] < 1e-2 / std::sqrt(3.0) * 0.9) EXPECT_TRUE(batch.success[i]) << "ratio " << ratios[i];
+        if (ratios[i] > 1e-2) EXPECT_FALSE(batch.success[i]) << "ratio " << ratios[i];
+        cnt_good += success;
+        cnt_bad += !success;
+    }
+    EXPECT_GT(cnt_good, 0);
+    EXPECT_GT(cnt_bad, 0);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();